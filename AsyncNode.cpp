@@ -0,0 +1,60 @@
+#include"AsyncNode.hpp"
+
+NodeEditor::AsyncTask NodeEditor::detail::AsyncPromise::get_return_object()
+{
+	return AsyncTask(std::coroutine_handle<AsyncPromise>::from_promise(*this));
+}
+
+bool NodeEditor::AsyncTask::poll()
+{
+	auto& promise = m_handle.promise();
+	if (promise.waiting && !promise.waiting->ready())
+	{
+		return false;
+	}
+
+	promise.waiting = nullptr;
+	m_handle.resume();
+
+	if (!m_handle.done())
+	{
+		return false;
+	}
+
+	const auto exception = promise.exception;
+	reset();
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+	return true;
+}
+
+void NodeEditor::AsyncTask::reset()
+{
+	if (m_handle)
+	{
+		m_handle.destroy();
+		m_handle = nullptr;
+	}
+}
+
+void NodeEditor::AsyncNode::childRun()
+{
+	//入力の生成元として中断中に評価された場合は何もしない
+	if (m_task)
+	{
+		return;
+	}
+
+	m_task = childRunAsync();
+	m_task.poll();
+}
+
+void NodeEditor::AsyncNode::resumeChild()
+{
+	if (m_task)
+	{
+		m_task.poll();
+	}
+}
@@ -0,0 +1,283 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<atomic>
+#include<chrono>
+#include<coroutine>
+#include<exception>
+#include<variant>
+#include"Node.hpp"
+#include"ThreadPool.hpp"
+
+namespace NodeEditor
+{
+	class AsyncTask;
+
+	namespace detail
+	{
+		class AsyncAwaiter;
+
+		struct AsyncPromise
+		{
+			//中断中に待っている条件(nullptrならすぐに再開できる)
+			AsyncAwaiter* waiting = nullptr;
+
+			std::exception_ptr exception;
+
+			AsyncTask get_return_object();
+
+			//最初の再開はAsyncTask::pollで行う
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			std::suspend_always final_suspend() noexcept
+			{
+				return {};
+			}
+
+			void return_void() {}
+
+			void unhandled_exception()
+			{
+				exception = std::current_exception();
+			}
+		};
+
+		/// <summary>
+		/// AsyncNodeの中でco_awaitで待つ条件
+		/// </summary>
+		class AsyncAwaiter
+		{
+		public:
+
+			virtual ~AsyncAwaiter() = default;
+
+			//再開できるならtrue(中断中は再開を試みるたびに呼ばれる)
+			virtual bool ready() = 0;
+
+			bool await_ready()
+			{
+				return ready();
+			}
+
+			void await_suspend(std::coroutine_handle<AsyncPromise> handle)
+			{
+				handle.promise().waiting = this;
+			}
+
+			void await_resume() {}
+		};
+	}
+
+	/// <summary>
+	/// AsyncNode::childRunAsyncの戻り値となるコルーチン
+	/// </summary>
+	class AsyncTask
+	{
+	public:
+
+		using promise_type = detail::AsyncPromise;
+
+	private:
+
+		std::coroutine_handle<promise_type> m_handle;
+
+	public:
+
+		AsyncTask() = default;
+
+		explicit AsyncTask(std::coroutine_handle<promise_type> handle)
+			:m_handle(handle)
+		{
+
+		}
+
+		AsyncTask(AsyncTask&& other) noexcept
+			:m_handle(std::exchange(other.m_handle, nullptr))
+		{
+
+		}
+
+		AsyncTask& operator=(AsyncTask&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_handle = std::exchange(other.m_handle, nullptr);
+			}
+			return *this;
+		}
+
+		~AsyncTask()
+		{
+			reset();
+		}
+
+		/// <summary>
+		/// 完了していなければtrue
+		/// </summary>
+		explicit operator bool() const
+		{
+			return static_cast<bool>(m_handle);
+		}
+
+		/// <summary>
+		/// 待っている条件が満たされていれば再開する
+		/// </summary>
+		/// <returns>完了したらtrue(コルーチン内で投げられた例外はここで投げ直す)</returns>
+		bool poll();
+
+		void reset();
+	};
+
+	namespace Async
+	{
+		/// <summary>
+		/// 次に再開を試みるとき(次のフレームのNode::runFor、Node::resume)まで待つ
+		/// </summary>
+		class NextFrame : public detail::AsyncAwaiter
+		{
+		private:
+
+			bool m_first = true;
+
+		public:
+
+			bool ready() override
+			{
+				return !std::exchange(m_first, false);
+			}
+		};
+
+		/// <summary>
+		/// durationが経過するまで待つ
+		/// </summary>
+		class Delay : public detail::AsyncAwaiter
+		{
+		private:
+
+			std::chrono::steady_clock::time_point m_deadline;
+
+		public:
+
+			explicit Delay(const Duration& duration)
+				:m_deadline(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration))
+			{
+
+			}
+
+			bool ready() override
+			{
+				return std::chrono::steady_clock::now() >= m_deadline;
+			}
+		};
+
+		/// <summary>
+		/// 関数をスレッドプール上で実行し、完了するまで待つ(co_awaitの結果は関数の戻り値)
+		/// </summary>
+		/// <remarks>
+		/// 関数は生成した時点で実行が始まる。関数の中でノードやソケットを操作しないこと。
+		/// </remarks>
+		template<class Result>
+		class Background : public detail::AsyncAwaiter
+		{
+		private:
+
+			struct State
+			{
+				std::atomic<bool> done = false;
+
+				std::conditional_t<std::is_void_v<Result>, std::monostate, Optional<Result>> result;
+
+				std::exception_ptr exception;
+			};
+
+			//ノードが破棄されてもワーカーから参照できるよう共有する
+			std::shared_ptr<State> m_state = std::make_shared<State>();
+
+		public:
+
+			template<class Func>
+			Background(ThreadPool& pool, Func function)
+			{
+				pool.submit([state = m_state, function = std::move(function)]() mutable
+					{
+						try
+						{
+							if constexpr (std::is_void_v<Result>)
+							{
+								function();
+							}
+							else
+							{
+								state->result = function();
+							}
+						}
+						catch (...)
+						{
+							state->exception = std::current_exception();
+						}
+						state->done.store(true, std::memory_order_release);
+					});
+			}
+
+			bool ready() override
+			{
+				return m_state->done.load(std::memory_order_acquire);
+			}
+
+			Result await_resume()
+			{
+				if (m_state->exception)
+				{
+					std::rethrow_exception(m_state->exception);
+				}
+				if constexpr (!std::is_void_v<Result>)
+				{
+					return std::move(*m_state->result);
+				}
+			}
+		};
+
+		template<class Func>
+		Background(ThreadPool&, Func) -> Background<std::invoke_result_t<Func>>;
+	}
+
+	/// <summary>
+	/// co_awaitで中断し、後のフレームで実行を再開できるノード
+	/// </summary>
+	/// <remarks>
+	/// 中断している間は次のノードに進まず、他の実行ソケットの処理を続ける。
+	/// 中断したノードはNode::runForまたはNode::resume(ExecutionPlan::resume)で再開し、完了したら次のノードに進む。
+	/// 入力ソケットの値は中断をまたぐと変わりうるので、必要な値は中断する前にコピーしておくこと。
+	/// 実行ソケットで到達するノードとして使う(Bytecode、Batchでは中断できない)。
+	/// </remarks>
+	class AsyncNode : public Node
+	{
+	private:
+
+		AsyncTask m_task;
+
+		void childRun() override;
+
+		bool suspended() const override
+		{
+			return static_cast<bool>(m_task);
+		}
+
+		void resumeChild() override;
+
+		void abortSuspended() override
+		{
+			m_task.reset();
+		}
+
+	protected:
+
+		/// <summary>
+		/// ノードの処理(co_awaitで中断できる)
+		/// </summary>
+		virtual AsyncTask childRunAsync() = 0;
+	};
+}
@@ -0,0 +1,109 @@
+#include"Batch.hpp"
+#include"Node.hpp"
+
+std::shared_ptr<NodeEditor::Batch> NodeEditor::Batch::Compile(Node& target)
+{
+	auto batch = std::make_shared<Batch>();
+	//定数も列として出力するため、畳み込まずに全ての生成元を評価する
+	//どの出力ソケットにも列を与えられるように、同じ関数のノードもまとめない
+	batch->m_plan = ExecutionPlan::Compile(target, nullptr, { .foldConstants = false, .eliminateDead = false, .mergeCommon = false });
+	return batch;
+}
+
+void NodeEditor::Batch::setInput(const ValueSocket& output, Column column)
+{
+	m_columns[&output] = std::move(column);
+	m_inputs[&output] = true;
+}
+
+bool NodeEditor::Batch::runNode(Node& node, const ValueSocket* const* sources, size_t count)
+{
+	node.m_error = NodeError();
+
+	m_inputColumns.resize(node.m_inputSockets.size());
+	for (size_t i = 0; i < node.m_inputSockets.size(); i++)
+	{
+		const auto itr = sources[i] ? m_columns.find(sources[i]) : m_columns.end();
+		if (itr == m_columns.end() || itr->second.size() != count)
+		{
+			return node.setError(NodeErrorCode::InputNotConnected, i);
+		}
+		m_inputColumns[i] = &itr->second;
+	}
+
+	m_outputColumns.resize(node.m_outputSockets.size());
+	for (size_t i = 0; i < node.m_outputSockets.size(); i++)
+	{
+		m_outputColumns[i] = &m_columns[node.m_outputSockets[i].get()];
+	}
+
+	//列全体を1度に計算する
+	try
+	{
+		if (node.childRunColumns(m_inputColumns.data(), m_outputColumns.data(), count))
+		{
+			return true;
+		}
+	}
+	catch (Error& ex)
+	{
+		node.m_error.message = ex.what();
+		return node.setError(NodeErrorCode::Exception);
+	}
+
+	//対応していないノードは要素ごとにchildRunを呼ぶ
+	Array<Array<ValueSlot>> outputs(node.m_outputSockets.size(), Array<ValueSlot>(count));
+	for (size_t idx = 0; idx < count; idx++)
+	{
+		for (size_t i = 0; i < node.m_inputSockets.size(); i++)
+		{
+			node.m_inputSockets[i]->setValue(m_inputColumns[i]->at(idx));
+		}
+		if (!node.runChild())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < node.m_outputSockets.size(); i++)
+		{
+			outputs[i][idx] = node.m_outputSockets[i]->value();
+		}
+	}
+	for (size_t i = 0; i < node.m_outputSockets.size(); i++)
+	{
+		m_outputColumns[i]->setBoxed(std::move(outputs[i]));
+	}
+	return true;
+}
+
+bool NodeEditor::Batch::run(size_t count)
+{
+	const auto& plan = *m_plan;
+	const auto& block = plan.m_blocks[0];
+
+	bool succeeded = true;
+	for (uint32 pos = block.instBegin; pos < block.instEnd; pos++)
+	{
+		const auto& entry = plan.m_nodes[plan.m_instructions[pos]];
+		auto& node = *entry.node;
+
+		//全ての出力ソケットに列が与えられたノードは評価しない
+		bool provided = !node.m_outputSockets.empty();
+		for (const auto& outSocket : node.m_outputSockets)
+		{
+			provided = provided && m_inputs.contains(outSocket.get());
+		}
+		if (provided)
+		{
+			continue;
+		}
+
+		succeeded = runNode(node, plan.m_sources.data() + entry.sourceBegin, count) && succeeded;
+	}
+	return succeeded;
+}
+
+const NodeEditor::Column* NodeEditor::Batch::column(const ValueSocket& output) const
+{
+	const auto itr = m_columns.find(&output);
+	return itr != m_columns.end() ? &itr->second : nullptr;
+}
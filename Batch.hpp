@@ -0,0 +1,164 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<unordered_map>
+#include"ExecutionPlan.hpp"
+#include"ValueSlot.hpp"
+
+namespace NodeEditor
+{
+	class Node;
+
+	/// <summary>
+	/// バッチ実行で1つの出力ソケットが持つN個の値(列)
+	/// </summary>
+	/// <remarks>
+	/// 型が分かっている列はArray&lt;T&gt;としてまとめて保持し(カーネルから連続したメモリとして読める)、
+	/// 要素ごとに実行したノードの出力はValueSlotの配列として保持する。
+	/// </remarks>
+	class Column
+	{
+	private:
+
+		//Array<T>
+		ValueSlot m_values;
+
+		//m_valuesのi番目の要素を取り出す
+		ValueSlot(*m_at)(const ValueSlot& values, size_t idx) = nullptr;
+
+		Array<ValueSlot> m_boxed;
+
+		size_t m_size = 0;
+
+	public:
+
+		Column() = default;
+
+		template<class T>
+		explicit Column(Array<T> values)
+		{
+			set(std::move(values));
+		}
+
+		template<class T>
+		void set(Array<T> values)
+		{
+			m_size = values.size();
+			m_values.set(std::move(values));
+			m_at = [](const ValueSlot& values, size_t idx)
+			{
+				return ValueSlot(values.get<Array<T>>()[idx]);
+			};
+			m_boxed.clear();
+		}
+
+		void setBoxed(Array<ValueSlot> values)
+		{
+			m_size = values.size();
+			m_boxed = std::move(values);
+			m_values.reset();
+			m_at = nullptr;
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		/// <summary>
+		/// idx番目の値
+		/// </summary>
+		ValueSlot at(size_t idx) const
+		{
+			return m_at ? m_at(m_values, idx) : m_boxed[idx];
+		}
+
+		/// <summary>
+		/// Array&lt;T&gt;として保持していればそのポインタ
+		/// </summary>
+		template<class T>
+		const Array<T>* tryGet() const
+		{
+			return m_values.tryGet<Array<T>>();
+		}
+
+		/// <summary>
+		/// Array&lt;T&gt;として参照する(要素ごとに保持している場合はscratchに集めて返す)
+		/// </summary>
+		template<class T>
+		const Array<T>& as(Array<T>& scratch) const
+		{
+			if (const auto values = tryGet<T>())
+			{
+				return *values;
+			}
+			scratch.resize(m_size);
+			for (size_t i = 0; i < m_size; i++)
+			{
+				scratch[i] = m_boxed[i].get<T>();
+			}
+			return scratch;
+		}
+	};
+
+	/// <summary>
+	/// 1つのノードの入力の生成元をN個のデータに対してまとめて評価する
+	/// </summary>
+	/// <remarks>
+	/// 各出力ソケットはN個の値の列(Column)を持つ。
+	/// childRunColumnsに対応したノード(組み込みの算術/比較ノードなど)は列全体を1度に計算し、
+	/// それ以外のノード(registerNodeFunctionで登録した関数など)は要素ごとにchildRunを呼ぶ。
+	/// 実行ソケットは辿らない。
+	/// </remarks>
+	class Batch
+	{
+	private:
+
+		std::shared_ptr<const ExecutionPlan> m_plan;
+
+		std::unordered_map<const ValueSocket*, Column> m_columns;
+
+		//setInputで値が与えられた出力ソケット
+		std::unordered_map<const ValueSocket*, bool> m_inputs;
+
+		//実行時に使い回す列へのポインタ
+		Array<const Column*> m_inputColumns;
+
+		Array<Column*> m_outputColumns;
+
+		bool runNode(Node& node, const ValueSocket* const* sources, size_t count);
+
+	public:
+
+		/// <summary>
+		/// targetとその入力の生成元を評価するバッチを生成する
+		/// </summary>
+		static std::shared_ptr<Batch> Compile(Node& target);
+
+		/// <summary>
+		/// 生成後に接続が変更されていなければtrue
+		/// </summary>
+		bool isValid() const
+		{
+			return m_plan->isValid();
+		}
+
+		/// <summary>
+		/// 出力ソケットの値の列を与える
+		/// </summary>
+		/// <remarks>
+		/// 全ての出力ソケットに列を与えたノードは評価されない
+		/// </remarks>
+		void setInput(const ValueSocket& output, Column column);
+
+		/// <summary>
+		/// count個のデータに対して評価する
+		/// </summary>
+		/// <returns>全てのノードの評価に成功したらtrue(失敗したノードにはエラーが記録される)</returns>
+		bool run(size_t count);
+
+		/// <summary>
+		/// 出力ソケットの値の列(評価されていない場合はnullptr)
+		/// </summary>
+		const Column* column(const ValueSocket& output) const;
+	};
+}
@@ -0,0 +1,94 @@
+#include"Benchmark.hpp"
+#include"BuiltinNodes.hpp"
+
+namespace
+{
+	//1回の操作で計算する要素数
+	constexpr size_t Count = 4096;
+
+	//valueを出力する(バッチ実行ではsetInputで列を与える)
+	class SourceNode : public NodeEditor::Node
+	{
+	private:
+
+		void childRun() override
+		{
+			setOutput(0, value);
+		}
+
+	public:
+
+		double value = 0;
+
+		SourceNode()
+		{
+			cfgOutputSockets({ {Type::getType<double>(),U"value"} });
+		}
+	};
+
+	//2つの列をtargetの入力に与えてバッチ実行する
+	Benchmark::Result MeasureBatch(const String& name, const std::shared_ptr<NodeEditor::Node>& target, const Array<double>& a, const Array<double>& b, size_t iterations)
+	{
+		auto sourceA = std::make_shared<SourceNode>();
+		auto sourceB = std::make_shared<SourceNode>();
+		NodeEditor::ISocket::connect(target->getInputSockets()[0], sourceA->getOutputSockets()[0]);
+		NodeEditor::ISocket::connect(target->getInputSockets()[1], sourceB->getOutputSockets()[0]);
+
+		const auto batch = NodeEditor::Batch::Compile(*target);
+		batch->setInput(*sourceA->getOutputSockets()[0], NodeEditor::Column(a));
+		batch->setInput(*sourceB->getOutputSockets()[0], NodeEditor::Column(b));
+
+		return Benchmark::Measure(U"Batch", name, iterations, [&](size_t)
+			{
+				batch->run(Count);
+				Benchmark::Sink += batch->column(*target->getOutputSockets()[0])->size();
+			});
+	}
+}
+
+Array<Benchmark::Result> Benchmark::RunBatch()
+{
+	Array<Result> results;
+
+	Array<double> a(Count), b(Count);
+	for (size_t i = 0; i < Count; i++)
+	{
+		a[i] = static_cast<double>(i % 100);
+		b[i] = static_cast<double>(i % 7) + 1.0;
+	}
+
+	//列の演算そのもの(1要素ずつのループとSSE2のカーネル)
+	{
+		Array<double> result(Count);
+		results << Measure(U"Batch", U"loop/Add", 100000, [&](size_t)
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					result[i] = a[i] + b[i];
+				}
+				Sink += static_cast<uint64>(result[0]);
+			});
+		results << Measure(U"Batch", U"kernel/Add", 100000, [&](size_t)
+			{
+				NodeEditor::Builtin::detail::AddColumns(a.data(), b.data(), result, Count);
+				Sink += static_cast<uint64>(result[0]);
+			});
+
+		Array<bool> compared(Count);
+		results << Measure(U"Batch", U"kernel/Less", 100000, [&](size_t)
+			{
+				NodeEditor::Builtin::detail::LessColumns(a.data(), b.data(), compared, Count);
+				Sink += compared[0];
+			});
+	}
+
+	//列全体を計算するノードと、要素ごとにchildRunを呼ぶ関数のノード
+	results << MeasureBatch(U"batch/AddNode", std::make_shared<NodeEditor::Builtin::AddNode>(), a, b, 10000);
+	{
+		const auto add = [](double x, double y) { return x + y; };
+		const Array<String> socketNames = { U"result", U"a", U"b" };
+		results << MeasureBatch(U"batch/function", std::make_shared<NodeEditor::detail::FunctionNode<double(double, double), decltype(add)>>(U"", socketNames, add), a, b, 1000);
+	}
+
+	return results;
+}
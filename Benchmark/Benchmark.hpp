@@ -0,0 +1,117 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<chrono>
+
+namespace Benchmark
+{
+	/// <summary>
+	/// 計測結果
+	/// </summary>
+	struct Result
+	{
+		String group;
+
+		String name;
+
+		size_t iterations;
+
+		//1回あたりの時間(ナノ秒)
+		double nsPerOp;
+
+		//1回あたりに実行するノード数(グラフの実行以外は0)
+		size_t nodes = 0;
+
+		//1回ごとの時間の分布(ナノ秒、MeasureLatencyで計測したときのみ0以外)
+		double p50Ns = 0;
+
+		double p95Ns = 0;
+
+		double p99Ns = 0;
+	};
+
+	//計測対象が最適化で消されないように結果を書き込む先
+	inline volatile uint64 Sink = 0;
+
+	/// <summary>
+	/// funcをiterations回呼び出して1回あたりの時間を計測する
+	/// </summary>
+	/// <param name="func">試行の番号を受け取る関数</param>
+	template<class Func>
+	Result Measure(const String& group, const String& name, size_t iterations, Func&& func)
+	{
+		//ウォームアップ
+		for (size_t i = 0; i < Max<size_t>(iterations / 10, 1); i++)
+		{
+			func(i);
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			func(i);
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		return Result{ group, name, iterations, std::chrono::duration<double, std::nano>(end - begin).count() / iterations };
+	}
+
+	/// <summary>
+	/// funcをiterations回呼び出して1回ごとの時間を計測し、平均と50/95/99パーセンタイルを求める
+	/// </summary>
+	/// <remarks>
+	/// 1回ごとに時刻を読むので、1回が数マイクロ秒以上かかる処理に使う
+	/// </remarks>
+	/// <param name="func">試行の番号を受け取る関数</param>
+	template<class Func>
+	Result MeasureLatency(const String& group, const String& name, size_t iterations, Func&& func)
+	{
+		//ウォームアップ
+		for (size_t i = 0; i < Max<size_t>(iterations / 10, 1); i++)
+		{
+			func(i);
+		}
+
+		Array<double> samples(iterations);
+		for (size_t i = 0; i < iterations; i++)
+		{
+			const auto begin = std::chrono::steady_clock::now();
+			func(i);
+			const auto end = std::chrono::steady_clock::now();
+			samples[i] = std::chrono::duration<double, std::nano>(end - begin).count();
+		}
+
+		Result result{ group, name, iterations, samples.sum() / iterations };
+
+		//最近接順位法(全体のp%以上がその値以下になる最小の標本)
+		samples.sort();
+		const auto percentile = [&samples](double p)
+		{
+			const size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+			return samples[Clamp<size_t>(rank, 1, samples.size()) - 1];
+		};
+		result.p50Ns = percentile(0.50);
+		result.p95Ns = percentile(0.95);
+		result.p99Ns = percentile(0.99);
+		return result;
+	}
+
+	/// <summary>
+	/// ソケットの値の受け渡し(std::anyとValueSlotの比較)
+	/// </summary>
+	Array<Result> RunValueSlot();
+
+	/// <summary>
+	/// 関数ノードの引数の受け渡しと呼び出し(std::any、std::function、関数オブジェクトの比較)
+	/// </summary>
+	Array<Result> RunFunctionNode();
+
+	/// <summary>
+	/// 生成した形の異なるグラフ(10～100万ノード)のNode::run(平均と1回ごとの時間の分布)
+	/// </summary>
+	Array<Result> RunGraph();
+
+	/// <summary>
+	/// 4096要素の列の計算(1要素ずつのループ、SSE2のカーネル、バッチ実行のノードと関数の比較)
+	/// </summary>
+	Array<Result> RunBatch();
+}
@@ -0,0 +1,130 @@
+#include<any>
+#include"Benchmark.hpp"
+#include"Node.hpp"
+
+namespace
+{
+	class EntryNode : public NodeEditor::Node
+	{
+	public:
+
+		EntryNode()
+		{
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//実行のたびに異なる値を出力するノード(関数ノードの評価を省略させない)
+	template<class T>
+	class CounterNode : public NodeEditor::Node
+	{
+	private:
+
+		T m_value;
+
+		size_t m_count = 0;
+
+		void childRun() override
+		{
+			if constexpr (std::is_same_v<T, String>)
+			{
+				m_value[0] = static_cast<char32>(U'a' + m_count++ % 26);
+			}
+			else if constexpr (std::is_same_v<T, Point>)
+			{
+				m_value.x = static_cast<int32>(m_count++);
+			}
+			else
+			{
+				m_value = static_cast<T>(m_count++);
+			}
+			setOutput(0, m_value);
+		}
+
+	public:
+
+		explicit CounterNode(const T& value)
+			:m_value(value)
+		{
+			cfgOutputSockets({ {Type::getType<T>(),U"value"} });
+		}
+	};
+
+	//引数をstd::anyで取り出していたときのFunctionNodeの再現
+	template<class FuncType>
+	class AnyFunctionNode;
+
+	template<class Result, class... Args>
+	class AnyFunctionNode<Result(Args...)> : public NodeEditor::Node
+	{
+	private:
+
+		std::function<Result(Args...)> m_function;
+
+		template<class T>
+		T getAnyInput(size_t index) const
+		{
+			const std::any value = getInput<T>(index);
+			return std::any_cast<T>(value);
+		}
+
+		void childRun() override
+		{
+			size_t argIdx = sizeof...(Args) - 1;
+			const std::any result = m_function(getAnyInput<Args>(argIdx--)...);
+			setOutput(0, std::any_cast<Result>(result));
+		}
+
+	public:
+
+		explicit AnyFunctionNode(std::function<Result(Args...)> function)
+			:m_function(function)
+		{
+			cfgOutputSockets({ {Type::getType<Result>(),U"result"} });
+			cfgInputSockets({ {Type::getType<Args>(),U"arg"}... });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//entry → function の実行を1回の操作として計測する(入力は2つともcounterから受け取る)
+	template<class T>
+	Benchmark::Result MeasureRun(const String& name, const T& value, std::shared_ptr<NodeEditor::Node> function, size_t iterations)
+	{
+		auto entry = std::make_shared<EntryNode>();
+		auto counter = std::make_shared<CounterNode<T>>(value);
+
+		for (const auto& inSocket : function->getInputSockets())
+		{
+			NodeEditor::ISocket::connect(inSocket, counter->getOutputSockets()[0]);
+		}
+		NodeEditor::ISocket::connect(entry->getNextNodeSockets()[0], function->getPrevNodeSockets()[0]);
+
+		return Benchmark::Measure(U"FunctionNode", name, iterations, [&](size_t)
+			{
+				entry->run();
+			});
+	}
+
+	template<class Result, class Arg, class Callable>
+	void MeasureFunction(Array<Benchmark::Result>& results, const String& typeName, const Arg& value, Callable function, size_t iterations)
+	{
+		using FuncType = Result(Arg, Arg);
+		const Array<String> socketNames = { U"result", U"a", U"b" };
+
+		results << MeasureRun(U"any/" + typeName, value, std::make_shared<AnyFunctionNode<FuncType>>(function), iterations);
+		results << MeasureRun(U"std::function/" + typeName, value, std::make_shared<NodeEditor::detail::FunctionNode<FuncType>>(U"", socketNames, function), iterations);
+		results << MeasureRun(U"callable/" + typeName, value, std::make_shared<NodeEditor::detail::FunctionNode<FuncType, Callable>>(U"", socketNames, function), iterations);
+	}
+}
+
+Array<Benchmark::Result> Benchmark::RunFunctionNode()
+{
+	Array<Result> results;
+
+	MeasureFunction<int32>(results, U"int32", int32(0), [](int32 a, int32 b) { return a + b; }, 1000000);
+	MeasureFunction<Point>(results, U"Point", Point(0, 0), [](Point a, Point b) { return Point(a.x + b.x, a.y + b.y); }, 1000000);
+	MeasureFunction<int32>(results, U"String", String(64, U'a'), [](const String& a, const String& b) { return static_cast<int32>(a.size() + b.size()); }, 1000000);
+
+	return results;
+}
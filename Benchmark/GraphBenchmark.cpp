@@ -0,0 +1,231 @@
+#include<random>
+#include"Benchmark.hpp"
+#include"Graph.hpp"
+#include"Shared/SampleNodes.hpp"
+
+namespace
+{
+	using NodeEditor::ISocket;
+	using NodeEditor::Node;
+
+	using EntryNode = SampleNodes::EntryNode;
+
+	//実行のたびに異なる値を出力するノード(下流の純粋なノードの評価を省略させない)
+	using CounterNode = SampleNodes::CounterNode<double>;
+
+	//全ての入力を読んで合計を記録するノード
+	using SinkNode = SampleNodes::SinkNode<double>;
+
+	//実行ソケットで辿られるたびに入力を読むノード
+	class StepNode : public Node
+	{
+	private:
+
+		void childRun() override
+		{
+			Benchmark::Sink += static_cast<uint64>(getInput<double>(0));
+		}
+
+	public:
+
+		StepNode()
+		{
+			Name = U"Step";
+			cfgInputSockets({ {Type::getType<double>(),U"value"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//生成したグラフ(entryを実行すると全てのノードが評価される)
+	struct GraphShape
+	{
+		NodeEditor::Graph graph;
+
+		std::shared_ptr<Node> entry;
+
+		std::shared_ptr<Node> counter;
+	};
+
+	std::shared_ptr<Node> AddBinary(NodeEditor::Graph& graph, const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b)
+	{
+		const auto node = *graph.addNode<NodeEditor::Builtin::AddNode>();
+		ISocket::connect(node->getInputSockets()[0], a->getOutputSockets()[0]);
+		ISocket::connect(node->getInputSockets()[1], b->getOutputSockets()[0]);
+		return node;
+	}
+
+	//outputsを全て入力に持つSinkNodeをentryの次に繋ぐ
+	void AddSink(GraphShape& shape, const Array<std::shared_ptr<Node>>& outputs)
+	{
+		const auto sink = std::make_shared<SinkNode>(outputs.size());
+		shape.graph.addNode(sink);
+		const auto inSockets = sink->getInputSockets();
+		for (size_t i = 0; i < outputs.size(); i++)
+		{
+			ISocket::connect(inSockets[i], outputs[i]->getOutputSockets()[0]);
+		}
+		ISocket::connect(shape.entry->getNextNodeSockets()[0], sink->getPrevNodeSockets()[0]);
+	}
+
+	std::unique_ptr<GraphShape> CreateShape()
+	{
+		auto shape = std::make_unique<GraphShape>();
+		shape->graph.registerBuiltinNodes();
+		shape->entry = std::make_shared<EntryNode>();
+		shape->counter = std::make_shared<CounterNode>();
+		shape->graph.addNode(shape->entry);
+		shape->graph.addNode(shape->counter);
+		return shape;
+	}
+
+	//counter → add → add → ... → sink(各addはcounterも入力に持つ)
+	std::unique_ptr<GraphShape> CreateChain(size_t count)
+	{
+		auto shape = CreateShape();
+		auto last = shape->counter;
+		for (size_t i = 0; i < count; i++)
+		{
+			last = AddBinary(shape->graph, last, shape->counter);
+		}
+		AddSink(*shape, { last });
+		return shape;
+	}
+
+	//counter → count個のadd → sink
+	std::unique_ptr<GraphShape> CreateFanOut(size_t count)
+	{
+		auto shape = CreateShape();
+		Array<std::shared_ptr<Node>> outputs;
+		outputs.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			outputs << AddBinary(shape->graph, shape->counter, shape->counter);
+		}
+		AddSink(*shape, outputs);
+		return shape;
+	}
+
+	//1つの出力を2つのaddで使い、それを1つのaddで合流させる菱形を直列に繋ぐ
+	std::unique_ptr<GraphShape> CreateDiamonds(size_t count)
+	{
+		auto shape = CreateShape();
+		auto last = shape->counter;
+		for (size_t i = 0; i < count / 3; i++)
+		{
+			const auto left = AddBinary(shape->graph, last, shape->counter);
+			const auto right = AddBinary(shape->graph, last, last);
+			last = AddBinary(shape->graph, left, right);
+		}
+		AddSink(*shape, { last });
+		return shape;
+	}
+
+	//entry → step → step → ...(実行ソケットで辿るノードの列)
+	std::unique_ptr<GraphShape> CreateSequence(size_t count)
+	{
+		auto shape = CreateShape();
+		auto last = shape->entry;
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto step = std::make_shared<StepNode>();
+			shape->graph.addNode(step);
+			ISocket::connect(step->getInputSockets()[0], shape->counter->getOutputSockets()[0]);
+			ISocket::connect(last->getNextNodeSockets()[0], step->getPrevNodeSockets()[0]);
+			last = step;
+		}
+		return shape;
+	}
+
+	//各addが先に生成したノードから入力を2つ選ぶ有向非巡回グラフ(出力が使われないノードはsinkに繋ぐ)
+	std::unique_ptr<GraphShape> CreateRandomDAG(size_t count)
+	{
+		auto shape = CreateShape();
+
+		//バージョン間で同じグラフになるようにシードを固定する
+		std::mt19937_64 rng(12345);
+
+		Array<std::shared_ptr<Node>> nodes;
+		nodes.reserve(count + 1);
+		Array<bool> used(count + 1, false);
+		nodes << shape->counter;
+		for (size_t i = 0; i < count; i++)
+		{
+			std::uniform_int_distribution<size_t> dist(0, nodes.size() - 1);
+			const size_t a = dist(rng), b = dist(rng);
+			used[a] = used[b] = true;
+			nodes << AddBinary(shape->graph, nodes[a], nodes[b]);
+		}
+
+		Array<std::shared_ptr<Node>> outputs;
+		for (size_t i = 1; i < nodes.size(); i++)
+		{
+			if (!used[i])
+			{
+				outputs << nodes[i];
+			}
+		}
+		AddSink(*shape, outputs);
+		return shape;
+	}
+
+	struct ShapeType
+	{
+		String name;
+
+		std::unique_ptr<GraphShape>(*create)(size_t);
+	};
+
+	void MeasureShape(Array<Benchmark::Result>& results, const ShapeType& type, size_t count)
+	{
+		const auto shape = type.create(count);
+		const size_t nodes = shape->graph.nodes().size();
+		const String name = U"{}/{}"_fmt(type.name, count);
+
+		//初回は実行計画の生成を含む
+		const auto begin = std::chrono::steady_clock::now();
+		shape->entry->run();
+		const auto end = std::chrono::steady_clock::now();
+		auto first = Benchmark::Result{ U"Graph", name + U"/first", 1, std::chrono::duration<double, std::nano>(end - begin).count() };
+		first.nodes = nodes;
+		results << first;
+
+		//1回あたりの評価ノード数がおよそ一定になるように反復回数を決める
+		const size_t iterations = Clamp<size_t>(10000000 / nodes, 5, 1000000);
+		auto result = Benchmark::MeasureLatency(U"Graph", name, iterations, [&](size_t)
+			{
+				shape->entry->run();
+			});
+		result.nodes = nodes;
+		results << result;
+	}
+}
+
+Array<Benchmark::Result> Benchmark::RunGraph()
+{
+	Array<Result> results;
+
+	const ShapeType types[] = {
+		{ U"chain", CreateChain },
+		{ U"fanout", CreateFanOut },
+		{ U"diamond", CreateDiamonds },
+		{ U"sequence", CreateSequence },
+		{ U"random", CreateRandomDAG },
+	};
+
+	//実行ソケットの列が上限で打ち切られないようにする
+	const size_t stepLimit = NodeEditor::ExecutionPlan::StepLimit();
+
+	for (const auto& type : types)
+	{
+		for (size_t count = 10; count <= 1000000; count *= 10)
+		{
+			NodeEditor::ExecutionPlan::SetStepLimit(Max(stepLimit, count + 1));
+			MeasureShape(results, type, count);
+		}
+	}
+
+	NodeEditor::ExecutionPlan::SetStepLimit(stepLimit);
+
+	return results;
+}
@@ -0,0 +1,64 @@
+#include<Siv3D.hpp>
+#include"Benchmark.hpp"
+
+void Main()
+{
+	Array<Benchmark::Result> results;
+
+	results.append(Benchmark::RunValueSlot());
+	results.append(Benchmark::RunFunctionNode());
+	results.append(Benchmark::RunGraph());
+	results.append(Benchmark::RunBatch());
+
+	//バージョン間で比較できるようにJSONで書き出す
+	JSONWriter writer;
+	writer.startObject();
+	{
+		writer.key(U"results").startArray();
+		for (const auto& result : results)
+		{
+			writer.startObject();
+			writer.key(U"group").write(result.group);
+			writer.key(U"name").write(result.name);
+			writer.key(U"iterations").write(static_cast<uint64>(result.iterations));
+			writer.key(U"nsPerOp").write(result.nsPerOp);
+			if (result.nodes)
+			{
+				writer.key(U"nodes").write(static_cast<uint64>(result.nodes));
+				writer.key(U"nodesPerSecond").write(result.nodes / result.nsPerOp * 1e9);
+			}
+			if (result.p50Ns)
+			{
+				writer.key(U"p50Ns").write(result.p50Ns);
+				writer.key(U"p95Ns").write(result.p95Ns);
+				writer.key(U"p99Ns").write(result.p99Ns);
+			}
+			writer.endObject();
+		}
+		writer.endArray();
+	}
+	writer.endObject();
+
+	TextWriter(U"benchmark.json").write(writer.get());
+
+	for (const auto& result : results)
+	{
+		if (result.p50Ns)
+		{
+			Print << U"{}/{}: {:.1f} ns ({:.1f} Mnodes/s, p50 {:.1f} / p95 {:.1f} / p99 {:.1f} ns)"_fmt(result.group, result.name, result.nsPerOp, result.nodes / result.nsPerOp * 1e3, result.p50Ns, result.p95Ns, result.p99Ns);
+		}
+		else if (result.nodes)
+		{
+			Print << U"{}/{}: {:.1f} ns ({:.1f} Mnodes/s)"_fmt(result.group, result.name, result.nsPerOp, result.nodes / result.nsPerOp * 1e3);
+		}
+		else
+		{
+			Print << U"{}/{}: {:.1f} ns"_fmt(result.group, result.name, result.nsPerOp);
+		}
+	}
+
+	while (System::Update())
+	{
+
+	}
+}
@@ -0,0 +1,136 @@
+#include<any>
+#include"Benchmark.hpp"
+#include"ValueSlot.hpp"
+
+namespace
+{
+	//std::anyで保持していたときのValueSocketの再現
+	class AnySocket
+	{
+	private:
+
+		std::any m_value;
+
+		const type_info& m_type;
+
+	public:
+
+		explicit AnySocket(const type_info& type)
+			:m_type(type)
+		{
+
+		}
+
+		std::any value() const
+		{
+			return m_value;
+		}
+
+		void setValue(std::any value)
+		{
+			if (!value.has_value() || value.type() != m_type)
+			{
+				throw Error(U"指定された値が正しくありません");
+			}
+			m_value = value;
+		}
+	};
+
+	//ValueSlotで保持するValueSocketの再現
+	class SlotSocket
+	{
+	private:
+
+		NodeEditor::ValueSlot m_value;
+
+		uint32 m_typeId;
+
+	public:
+
+		explicit SlotSocket(uint32 typeId)
+			:m_typeId(typeId)
+		{
+
+		}
+
+		const NodeEditor::ValueSlot& value() const
+		{
+			return m_value;
+		}
+
+		void setValue(const NodeEditor::ValueSlot& value)
+		{
+			if (value.typeId() != m_typeId)
+			{
+				throw Error(U"指定された値が正しくありません");
+			}
+			m_value = value;
+		}
+
+		template<class T>
+		void setValue(const T& value)
+		{
+			if (Type::getId<T>() != m_typeId)
+			{
+				throw Error(U"指定された値が正しくありません");
+			}
+			m_value.set(value);
+		}
+	};
+
+	uint64 Touch(int32 value)
+	{
+		return static_cast<uint64>(value);
+	}
+
+	uint64 Touch(const Point& value)
+	{
+		return static_cast<uint64>(value.x + value.y);
+	}
+
+	uint64 Touch(const String& value)
+	{
+		return value.size();
+	}
+
+	uint64 Touch(const Image& value)
+	{
+		return value.width();
+	}
+
+	//setOutput → 接続先への受け渡し → getInput を1つの接続で行う
+	template<class T>
+	void MeasureTransfer(Array<Benchmark::Result>& results, const String& typeName, const T& value, size_t iterations)
+	{
+		{
+			AnySocket output(typeid(T)), input(typeid(T));
+			results << Benchmark::Measure(U"ValueSlot", U"any/" + typeName, iterations, [&](size_t)
+				{
+					output.setValue(std::any(value));
+					input.setValue(output.value());
+					Benchmark::Sink += Touch(std::any_cast<T>(input.value()));
+				});
+		}
+		{
+			SlotSocket output(Type::getId<T>()), input(Type::getId<T>());
+			results << Benchmark::Measure(U"ValueSlot", U"slot/" + typeName, iterations, [&](size_t)
+				{
+					output.setValue(value);
+					input.setValue(output.value());
+					Benchmark::Sink += Touch(input.value().get<T>());
+				});
+		}
+	}
+}
+
+Array<Benchmark::Result> Benchmark::RunValueSlot()
+{
+	Array<Result> results;
+
+	MeasureTransfer(results, U"int32", int32(42), 10000000);
+	MeasureTransfer(results, U"Point", Point(12, 34), 10000000);
+	MeasureTransfer(results, U"String", String(U"ノードエディタのソケットを流れる文字列"), 1000000);
+	MeasureTransfer(results, U"Image", Image(256, 256, Palette::White), 1000);
+
+	return results;
+}
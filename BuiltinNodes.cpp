@@ -0,0 +1,140 @@
+#include"BuiltinNodes.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define NODEEDITOR_SSE2
+#include<emmintrin.h>
+#endif
+
+namespace
+{
+	struct Add
+	{
+		static double Scalar(double a, double b) { return a + b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+#endif
+	};
+
+	struct Subtract
+	{
+		static double Scalar(double a, double b) { return a - b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+#endif
+	};
+
+	struct Multiply
+	{
+		static double Scalar(double a, double b) { return a * b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+#endif
+	};
+
+	struct Divide
+	{
+		static double Scalar(double a, double b) { return a / b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+#endif
+	};
+
+	struct Less
+	{
+		static bool Scalar(double a, double b) { return a < b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_cmplt_pd(a, b); }
+#endif
+	};
+
+	struct Greater
+	{
+		static bool Scalar(double a, double b) { return a > b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_cmpgt_pd(a, b); }
+#endif
+	};
+
+	struct Equal
+	{
+		static bool Scalar(double a, double b) { return a == b; }
+#ifdef NODEEDITOR_SSE2
+		static __m128d Simd(__m128d a, __m128d b) { return _mm_cmpeq_pd(a, b); }
+#endif
+	};
+
+	template<class Op>
+	void Arithmetic(const double* a, const double* b, Array<double>& result, size_t count)
+	{
+		double* out = result.data();
+		size_t i = 0;
+#ifdef NODEEDITOR_SSE2
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_pd(out + i, Op::Simd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+			_mm_storeu_pd(out + i + 2, Op::Simd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			out[i] = Op::Scalar(a[i], b[i]);
+		}
+	}
+
+	//比較結果はビットマスクで受け取ってboolに展開する
+	template<class Op>
+	void Compare(const double* a, const double* b, Array<bool>& result, size_t count)
+	{
+		size_t i = 0;
+#ifdef NODEEDITOR_SSE2
+		for (; i + 4 <= count; i += 4)
+		{
+			const int mask = _mm_movemask_pd(Op::Simd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)))
+				| (_mm_movemask_pd(Op::Simd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2))) << 2);
+			result[i] = (mask & 1) != 0;
+			result[i + 1] = (mask & 2) != 0;
+			result[i + 2] = (mask & 4) != 0;
+			result[i + 3] = (mask & 8) != 0;
+		}
+#endif
+		for (; i < count; i++)
+		{
+			result[i] = Op::Scalar(a[i], b[i]);
+		}
+	}
+}
+
+void NodeEditor::Builtin::detail::AddColumns(const double* a, const double* b, Array<double>& result, size_t count)
+{
+	Arithmetic<Add>(a, b, result, count);
+}
+
+void NodeEditor::Builtin::detail::SubtractColumns(const double* a, const double* b, Array<double>& result, size_t count)
+{
+	Arithmetic<Subtract>(a, b, result, count);
+}
+
+void NodeEditor::Builtin::detail::MultiplyColumns(const double* a, const double* b, Array<double>& result, size_t count)
+{
+	Arithmetic<Multiply>(a, b, result, count);
+}
+
+void NodeEditor::Builtin::detail::DivideColumns(const double* a, const double* b, Array<double>& result, size_t count)
+{
+	Arithmetic<Divide>(a, b, result, count);
+}
+
+void NodeEditor::Builtin::detail::LessColumns(const double* a, const double* b, Array<bool>& result, size_t count)
+{
+	Compare<Less>(a, b, result, count);
+}
+
+void NodeEditor::Builtin::detail::GreaterColumns(const double* a, const double* b, Array<bool>& result, size_t count)
+{
+	Compare<Greater>(a, b, result, count);
+}
+
+void NodeEditor::Builtin::detail::EqualColumns(const double* a, const double* b, Array<bool>& result, size_t count)
+{
+	Compare<Equal>(a, b, result, count);
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include<Siv3D.hpp>
+#include"Batch.hpp"
+#include"Node.hpp"
+
+namespace NodeEditor
+{
+	namespace Builtin
+	{
+		namespace detail
+		{
+			//列同士の演算(SSE2が使える環境では2要素のレジスタ2つで1回に4要素ずつ計算し、端数は1要素ずつ計算する)
+
+			void AddColumns(const double* a, const double* b, Array<double>& result, size_t count);
+
+			void SubtractColumns(const double* a, const double* b, Array<double>& result, size_t count);
+
+			void MultiplyColumns(const double* a, const double* b, Array<double>& result, size_t count);
+
+			void DivideColumns(const double* a, const double* b, Array<double>& result, size_t count);
+
+			void LessColumns(const double* a, const double* b, Array<bool>& result, size_t count);
+
+			void GreaterColumns(const double* a, const double* b, Array<bool>& result, size_t count);
+
+			void EqualColumns(const double* a, const double* b, Array<bool>& result, size_t count);
+		}
+
+		/// <summary>
+		/// 2つの実数から値を1つ計算するノード
+		/// </summary>
+		/// <remarks>
+		/// バッチ実行では列全体をkernelで計算する
+		/// </remarks>
+		template<class Result>
+		class BinaryNode : public Node
+		{
+		public:
+
+			using ScalarFunction = Result(*)(double, double);
+
+			using KernelFunction = void(*)(const double*, const double*, Array<Result>&, size_t);
+
+		private:
+
+			ScalarFunction m_scalar;
+
+			KernelFunction m_kernel;
+
+			//要素ごとに保持された入力の列を集める領域
+			Array<double> m_scratchA;
+
+			Array<double> m_scratchB;
+
+			void childRun() override
+			{
+				setOutput(0, m_scalar(getInput<double>(0), getInput<double>(1)));
+			}
+
+			bool childRunSlots(const ValueSlot* const* inputs, ValueSlot* outputs) const override
+			{
+				outputs[0].set(m_scalar(inputs[0]->get<double>(), inputs[1]->get<double>()));
+				return true;
+			}
+
+			bool childRunColumns(const Column* const* inputs, Column* const* outputs, size_t count) override
+			{
+				const auto& a = inputs[0]->as<double>(m_scratchA);
+				const auto& b = inputs[1]->as<double>(m_scratchB);
+
+				Array<Result> result(count);
+				m_kernel(a.data(), b.data(), result, count);
+				outputs[0]->set(std::move(result));
+				return true;
+			}
+
+		protected:
+
+			BinaryNode(const String& name, ScalarFunction scalar, KernelFunction kernel)
+				:m_scalar(scalar),
+				m_kernel(kernel)
+			{
+				Name = name;
+
+				Pure = true;
+
+				ThreadSafe = true;
+
+				cfgInputSockets({ {Type::getType<double>(),U"A"},{Type::getType<double>(),U"B"} });
+				cfgOutputSockets({ {Type::getType<Result>(),U"Result"} });
+			}
+		};
+
+		class AddNode : public BinaryNode<double>
+		{
+		public:
+
+			AddNode()
+				:BinaryNode(U"A + B", [](double a, double b) { return a + b; }, detail::AddColumns)
+			{
+
+			}
+		};
+
+		class SubtractNode : public BinaryNode<double>
+		{
+		public:
+
+			SubtractNode()
+				:BinaryNode(U"A - B", [](double a, double b) { return a - b; }, detail::SubtractColumns)
+			{
+
+			}
+		};
+
+		class MultiplyNode : public BinaryNode<double>
+		{
+		public:
+
+			MultiplyNode()
+				:BinaryNode(U"A * B", [](double a, double b) { return a * b; }, detail::MultiplyColumns)
+			{
+
+			}
+		};
+
+		class DivideNode : public BinaryNode<double>
+		{
+		public:
+
+			DivideNode()
+				:BinaryNode(U"A / B", [](double a, double b) { return a / b; }, detail::DivideColumns)
+			{
+
+			}
+		};
+
+		class LessNode : public BinaryNode<bool>
+		{
+		public:
+
+			LessNode()
+				:BinaryNode(U"A < B", [](double a, double b) { return a < b; }, detail::LessColumns)
+			{
+
+			}
+		};
+
+		class GreaterNode : public BinaryNode<bool>
+		{
+		public:
+
+			GreaterNode()
+				:BinaryNode(U"A > B", [](double a, double b) { return a > b; }, detail::GreaterColumns)
+			{
+
+			}
+		};
+
+		class EqualNode : public BinaryNode<bool>
+		{
+		public:
+
+			EqualNode()
+				:BinaryNode(U"A == B", [](double a, double b) { return a == b; }, detail::EqualColumns)
+			{
+
+			}
+		};
+	}
+}
@@ -0,0 +1,301 @@
+#include"Bytecode.hpp"
+#include"Node.hpp"
+
+std::shared_ptr<NodeEditor::Bytecode> NodeEditor::Bytecode::Compile(Node& entry, const FunctionTable& functions)
+{
+	//InstanceSet::valueで全ての出力を読めるよう、定数も含めて全てのノードをインスタンスごとのレジスタで実行する
+	auto plan = ExecutionPlan::Compile(entry, nullptr, { .foldConstants = false, .eliminateDead = false });
+
+	auto bytecode = std::make_shared<Bytecode>();
+	bytecode->m_functions = &functions;
+	bytecode->m_context.nodePass.resize(plan->m_nodes.size(), 0);
+
+	//出力ソケットごとにレジスタを割り当てる
+	Array<uint32> registerBegin(plan->m_nodes.size());
+	for (size_t i = 0; i < plan->m_nodes.size(); i++)
+	{
+		const auto node = plan->m_nodes[i].node;
+		registerBegin[i] = static_cast<uint32>(bytecode->m_registerIndex.size());
+		for (const auto& outSocket : node->m_outputSockets)
+		{
+			bytecode->m_registerIndex.emplace(outSocket.get(), static_cast<uint32>(bytecode->m_registerIndex.size()));
+		}
+	}
+	//まとめたノードの出力はまとめ先のノードのレジスタで読む
+	for (const auto& [merged, original] : plan->m_merged)
+	{
+		bytecode->m_registerIndex[merged] = bytecode->m_registerIndex.at(original);
+	}
+	bytecode->m_registers.resize(bytecode->m_registerIndex.size());
+	bytecode->m_context.registers = bytecode->m_registers.data();
+
+	for (const auto nodeIdx : plan->m_instructions)
+	{
+		const auto& entry = plan->m_nodes[nodeIdx];
+		const auto node = entry.node;
+
+		Instruction inst;
+		inst.node = nodeIdx;
+		inst.operandBegin = static_cast<uint32>(bytecode->m_operands.size());
+		inst.result = registerBegin[nodeIdx];
+		inst.state = InvalidRegister;
+
+		//別のグラフで生成されたノードの番号は、同じ番号でも別の関数を指す
+		if (node->FunctionId && functions.contains(node->FunctionTableId, *node->FunctionId))
+		{
+			inst.op = OpCode::Call;
+			inst.function = *node->FunctionId;
+		}
+		else
+		{
+			inst.op = OpCode::CallNode;
+			inst.function = 0;
+
+			if (node->InstanceState)
+			{
+				inst.state = static_cast<uint32>(bytecode->m_stateNodes.size());
+				bytecode->m_stateNodes << nodeIdx;
+			}
+		}
+
+		for (size_t i = 0; i < node->m_inputSockets.size(); i++)
+		{
+			const auto source = plan->m_sources[entry.sourceBegin + i];
+			bytecode->m_operands << (source ? bytecode->m_registerIndex.at(source) : InvalidRegister);
+		}
+
+		bytecode->m_code << inst;
+	}
+
+	bytecode->m_plan = std::move(plan);
+
+	return bytecode;
+}
+
+bool NodeEditor::Bytecode::execute(Context& context, const Instruction& inst) const
+{
+	context.nodePass[inst.node] = context.pass;
+
+	auto& node = *m_plan->m_nodes[inst.node].node;
+	if (node.m_error)
+	{
+		node.m_error = NodeError();
+	}
+
+	switch (inst.op)
+	{
+	case OpCode::Call:
+		return call(context, inst, node);
+	case OpCode::CallNode:
+		return callNode(context, inst, node);
+	}
+	return false;
+}
+
+bool NodeEditor::Bytecode::call(Context& context, const Instruction& inst, Node& node) const
+{
+	const auto argCount = node.m_inputSockets.size();
+
+	context.args.resize(argCount);
+	for (size_t i = 0; i < argCount; i++)
+	{
+		const auto reg = m_operands[inst.operandBegin + i];
+		//生成元が失敗していて値がない場合も未接続として扱う
+		if (reg == InvalidRegister || !context.registers[reg].hasValue())
+		{
+			return node.setError(NodeErrorCode::InputNotConnected, i);
+		}
+		context.args[i] = &context.registers[reg];
+	}
+
+	ValueSlot unused;
+	try
+	{
+		const detail::TraceScope trace(Trace::Category::Node, node);
+		NODEEDITOR_PROFILE_SCOPE(node.m_profile);
+		(*m_functions)[inst.function].invoke(context.args.data(), node.m_outputSockets ? context.registers[inst.result] : unused);
+	}
+	catch (Error& ex)
+	{
+		node.m_error.message = ex.what();
+		return node.setError(NodeErrorCode::Exception);
+	}
+	return true;
+}
+
+bool NodeEditor::Bytecode::callNode(Context& context, const Instruction& inst, Node& node) const
+{
+	//レジスタの値を入力ソケットに渡す(大きな値は参照カウントが増えるだけ)
+	for (size_t i = 0; i < node.m_inputSockets.size(); i++)
+	{
+		const auto reg = m_operands[inst.operandBegin + i];
+		if (reg == InvalidRegister || !context.registers[reg].hasValue())
+		{
+			return node.setError(NodeErrorCode::InputNotConnected, i);
+		}
+		node.m_inputSockets[i]->setValue(context.registers[reg]);
+	}
+
+	//インスタンスごとの状態に切り替えてから実行する
+	ValueSlot* const state = context.states && inst.state != InvalidRegister ? &context.states[inst.state] : nullptr;
+	if (state)
+	{
+		node.loadState(*state);
+	}
+
+	const bool succeeded = node.runChild();
+
+	if (state)
+	{
+		node.saveState(*state);
+	}
+
+	if (!succeeded)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < node.m_outputSockets.size(); i++)
+	{
+		context.registers[inst.result + i] = node.m_outputSockets[i]->value();
+	}
+	return true;
+}
+
+void NodeEditor::Bytecode::run(Context& context) const
+{
+	const auto& plan = *m_plan;
+
+	context.pass++;
+	context.passBegin = context.pass;
+	context.steps = 0;
+	context.interrupted = false;
+
+	//前回の実行で打ち切られたループは最初から実行する
+	plan.abortLoops(context.loops);
+
+	const detail::TraceScope passTrace(Trace::Category::Pass, *plan.m_nodes[m_code[plan.m_blocks[0].instEnd - 1].node].node);
+
+	context.stack.clear();
+
+	//実行ソケットが循環している計画は実行しない
+	if (plan.m_hasCycle)
+	{
+		for (size_t i = 0; i < plan.m_blocks.size(); i++)
+		{
+			if (plan.m_cyclic[i])
+			{
+				plan.m_nodes[m_code[plan.m_blocks[i].instEnd - 1].node].node->setError(NodeErrorCode::ExecCycle);
+			}
+		}
+		context.interrupted = true;
+		return;
+	}
+
+	context.stack << 0;
+
+	while (context.stack)
+	{
+		const auto blockIdx = context.stack.back();
+		const auto& block = plan.m_blocks[blockIdx];
+		context.stack.pop_back();
+
+		if (++context.steps > ExecutionPlan::StepLimit())
+		{
+			context.steps--;
+			context.interrupted = true;
+			plan.m_nodes[m_code[block.instEnd - 1].node].node->setError(NodeErrorCode::StepLimitExceeded);
+			plan.abortLoops(context.loops);
+			break;
+		}
+
+		const detail::TraceScope stepTrace(Trace::Category::Step, *plan.m_nodes[m_code[block.instEnd - 1].node].node);
+
+		//入力の生成元を実行
+		for (uint32 pos = block.instBegin; pos + 1 < block.instEnd; pos++)
+		{
+			const auto& inst = m_code[pos];
+			//実行ソケットで到達するノードは、反復ごとに入力の生成元として実行し直さない
+			const bool evaluated = plan.m_nodes[inst.node].block ? context.nodePass[inst.node] >= context.passBegin : context.nodePass[inst.node] == context.pass;
+			if (!evaluated)
+			{
+				execute(context, inst);
+			}
+		}
+
+		//ブロックのノード自身を実行
+		const auto& inst = m_code[block.instEnd - 1];
+		if (!execute(context, inst))
+		{
+			plan.endLoop(context.loops, blockIdx);
+			continue;
+		}
+
+		//ループのノードは本体を実行し終えたら再び実行する
+		if (inst.op == OpCode::CallNode && plan.m_nodes[inst.node].node->looping())
+		{
+			plan.nextIteration(context.loops, blockIdx);
+			//本体の入力の生成元を反復ごとに評価し直す
+			context.pass++;
+			context.stack << blockIdx;
+		}
+		else
+		{
+			plan.endLoop(context.loops, blockIdx);
+		}
+
+		//次のノードを積む(接続順に実行されるよう逆順に積む)
+		if (block.nextBegin != block.nextEnd)
+		{
+			const auto nextExecIdx = inst.op == OpCode::CallNode ? plan.m_nodes[inst.node].node->NextExecIdx : 0;
+			const auto& next = plan.m_nextTable[block.nextBegin + nextExecIdx];
+			for (uint32 i = next.end; i > next.begin; i--)
+			{
+				context.stack << plan.m_successors[i - 1];
+			}
+		}
+	}
+}
+
+void NodeEditor::Bytecode::saveStates(ValueSlot* states) const
+{
+	for (size_t i = 0; i < m_stateNodes.size(); i++)
+	{
+		m_plan->m_nodes[m_stateNodes[i]].node->saveState(states[i]);
+	}
+}
+
+uint32 NodeEditor::Bytecode::stateIndex(const Node& node) const
+{
+	for (size_t i = 0; i < m_stateNodes.size(); i++)
+	{
+		if (m_plan->m_nodes[m_stateNodes[i]].node == &node)
+		{
+			return static_cast<uint32>(i);
+		}
+	}
+	return InvalidRegister;
+}
+
+void NodeEditor::Bytecode::collectErrors(const Context& context, Array<std::pair<const Node*, NodeError>>& errors) const
+{
+	for (size_t i = 0; i < m_plan->m_nodes.size(); i++)
+	{
+		const auto node = m_plan->m_nodes[i].node;
+		if (node->m_error && context.nodePass[i] >= context.passBegin)
+		{
+			errors.emplace_back(node, node->m_error);
+		}
+	}
+}
+
+void NodeEditor::Bytecode::run()
+{
+	run(m_context);
+}
+
+const NodeEditor::ValueSlot* NodeEditor::Bytecode::value(const ValueSocket& output) const
+{
+	const auto itr = m_registerIndex.find(&output);
+	return itr != m_registerIndex.end() ? &m_registers[itr->second] : nullptr;
+}
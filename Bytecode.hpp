@@ -0,0 +1,295 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<atomic>
+#include<functional>
+#include<unordered_map>
+#include<utility>
+#include"ExecutionPlan.hpp"
+#include"ValueSlot.hpp"
+
+namespace NodeEditor
+{
+	class Node;
+
+	struct NodeError;
+
+	namespace detail
+	{
+		template<class FuncType>
+		struct FunctionInvoker;
+
+		template<class Result, class... Args>
+		struct FunctionInvoker<Result(Args...)>
+		{
+			//引数iにargs[i]の値を渡して呼び出す
+			template<class Callable>
+			static void Invoke(Callable& function, const ValueSlot* const* args, ValueSlot& result)
+			{
+				Invoke(function, args, result, std::index_sequence_for<Args...>());
+			}
+
+			template<class Callable, size_t... Idx>
+			static void Invoke(Callable& function, const ValueSlot* const* args, ValueSlot& result, std::index_sequence<Idx...>)
+			{
+				if constexpr (std::is_void_v<Result>)
+				{
+					function(args[Idx]->get<std::decay_t<Args>>()...);
+				}
+				else
+				{
+					result.set(function(args[Idx]->get<std::decay_t<Args>>()...));
+				}
+			}
+		};
+	}
+
+	/// <summary>
+	/// 関数として登録されたノードの呼び出し先の一覧
+	/// </summary>
+	class FunctionTable
+	{
+	public:
+
+		//引数のレジスタを受け取り、戻り値をresultに書き込む(戻り値がなければ何もしない)
+		using Invoker = std::function<void(const ValueSlot* const* args, ValueSlot& result)>;
+
+		struct Entry
+		{
+			String name;
+
+			Invoker invoke;
+		};
+
+	private:
+
+		//テーブルを生成するたびに加算される(テーブルごとに一意の番号を割り当てる)
+		static inline std::atomic<uint64> s_idCounter = 0;
+
+		//ノードの関数の番号がどのテーブルのものかを確かめるための番号
+		uint64 m_id = ++s_idCounter;
+
+		Array<Entry> m_entries;
+
+	public:
+
+		/// <summary>
+		/// 関数を追加して、その番号を返す
+		/// </summary>
+		template<class FuncType, class Callable>
+		uint32 add(const String& name, Callable function)
+		{
+			m_entries << Entry{ name, [function = std::move(function)](const ValueSlot* const* args, ValueSlot& result) mutable
+				{
+					detail::FunctionInvoker<FuncType>::Invoke(function, args, result);
+				} };
+			return static_cast<uint32>(m_entries.size() - 1);
+		}
+
+		const Entry& operator[](uint32 idx) const
+		{
+			return m_entries[idx];
+		}
+
+		size_t size() const
+		{
+			return m_entries.size();
+		}
+
+		/// <summary>
+		/// テーブルごとに一意の番号(0にはならない)
+		/// </summary>
+		uint64 id() const
+		{
+			return m_id;
+		}
+
+		/// <summary>
+		/// tableIdのテーブルのidx番目の関数がこのテーブルにあればtrue
+		/// </summary>
+		bool contains(uint64 tableId, uint32 idx) const
+		{
+			return tableId == m_id && idx < m_entries.size();
+		}
+	};
+
+	/// <summary>
+	/// 実行計画から生成したレジスタマシン用の命令列
+	/// </summary>
+	/// <remarks>
+	/// 値は出力ソケットごとに割り当てたレジスタ(平坦な配列)に置く。
+	/// 関数テーブルに登録された関数のノードは関数を直接呼び出す命令になり、
+	/// それ以外のノードはレジスタの値を入力ソケットに渡してchildRunを呼ぶ命令になる。
+	/// ブロックと実行ソケットの接続は元の実行計画のものを使う。
+	/// 生成後の命令列は変更されないので、InstanceSetで複数のインスタンスから共有できる。
+	/// </remarks>
+	class Bytecode
+	{
+		friend class InstanceSet;
+
+	public:
+
+		static constexpr uint32 InvalidRegister = UINT32_MAX;
+
+		enum class OpCode : uint8
+		{
+			//関数テーブルの関数を呼び出す
+			Call,
+			//ノードのchildRunを呼び出す
+			CallNode,
+		};
+
+		struct Instruction
+		{
+			OpCode op;
+
+			//実行計画のノードの番号
+			uint32 node;
+
+			//関数テーブルの番号(Call)
+			uint32 function;
+
+			//m_operandsの先頭(入力ソケットの数だけ続く)
+			uint32 operandBegin;
+
+			//最初の出力ソケットのレジスタ(出力ソケットの数だけ続く)
+			uint32 result;
+
+			//ノードの状態の番号(InstanceStateでないノードはInvalidRegister)
+			uint32 state;
+		};
+
+		/// <summary>
+		/// 1回の実行で使う作業領域
+		/// </summary>
+		struct Context
+		{
+			ValueSlot* registers = nullptr;
+
+			//ノードの状態(nullptrならノードのメンバ変数をそのまま使う)
+			ValueSlot* states = nullptr;
+
+			//ノードごとの最後に評価されたパス番号
+			Array<uint64> nodePass;
+
+			//ループの反復ごとに進む
+			uint64 pass = 0;
+
+			//runを始めたときのpass
+			uint64 passBegin = 0;
+
+			//実行時に使い回す引数の列とスタック
+			Array<const ValueSlot*> args;
+
+			Array<uint32> stack;
+
+			size_t steps = 0;
+
+			//反復中のループ
+			Array<ExecutionPlan::LoopFrame> loops;
+
+			bool interrupted = false;
+		};
+
+	private:
+
+		std::shared_ptr<const ExecutionPlan> m_plan;
+
+		const FunctionTable* m_functions = nullptr;
+
+		//実行計画のm_instructionsと同じ並び
+		Array<Instruction> m_code;
+
+		//入力ソケットが参照するレジスタ(未接続の場合はInvalidRegister)
+		Array<uint32> m_operands;
+
+		std::unordered_map<const ValueSocket*, uint32> m_registerIndex;
+
+		//InstanceStateなノードの実行計画での番号(状態の番号順)
+		Array<uint32> m_stateNodes;
+
+		//run()で使うレジスタと作業領域
+		Array<ValueSlot> m_registers;
+
+		Context m_context;
+
+		bool execute(Context& context, const Instruction& inst) const;
+
+		bool call(Context& context, const Instruction& inst, Node& node) const;
+
+		bool callNode(Context& context, const Instruction& inst, Node& node) const;
+
+		void run(Context& context) const;
+
+		//各ノードの現在の状態をstatesに書き出す
+		void saveStates(ValueSlot* states) const;
+
+		//nodeの状態の番号(InstanceStateなノードでなければInvalidRegister)
+		uint32 stateIndex(const Node& node) const;
+
+		//contextの直前の実行で評価され、エラーを記録したノードとそのエラーをerrorsに追加する
+		void collectErrors(const Context& context, Array<std::pair<const Node*, NodeError>>& errors) const;
+
+	public:
+
+		/// <summary>
+		/// entryを起点とする命令列を生成する
+		/// </summary>
+		/// <param name="functions">FunctionIdが指す関数テーブル(実行中は破棄しないこと)。別のテーブルの関数のノードはchildRunを呼ぶ命令になる</param>
+		static std::shared_ptr<Bytecode> Compile(Node& entry, const FunctionTable& functions);
+
+		/// <summary>
+		/// 生成後に接続が変更されていなければtrue
+		/// </summary>
+		bool isValid() const
+		{
+			return m_plan->isValid();
+		}
+
+		/// <summary>
+		/// 起点ノードから実行する
+		/// </summary>
+		/// <remarks>
+		/// 1回の実行の中では入力の生成元は1度だけ評価される。
+		/// 関数を直接呼び出すノードの出力はレジスタにのみ書き込まれ、出力ソケットには反映されない。
+		/// </remarks>
+		void run();
+
+		/// <summary>
+		/// 出力ソケットに割り当てたレジスタの値(命令列に含まれない場合はnullptr)
+		/// </summary>
+		const ValueSlot* value(const ValueSocket& output) const;
+
+		size_t instructionCount() const
+		{
+			return m_code.size();
+		}
+
+		/// <summary>
+		/// 関数を直接呼び出す命令の数(残りはノードのchildRunを呼ぶ命令)
+		/// </summary>
+		size_t callCount() const
+		{
+			return m_code.count_if([](const Instruction& inst) { return inst.op == OpCode::Call; });
+		}
+
+		size_t registerCount() const
+		{
+			return m_registerIndex.size();
+		}
+
+		size_t stateCount() const
+		{
+			return m_stateNodes.size();
+		}
+
+		size_t steps() const
+		{
+			return m_context.steps;
+		}
+
+		bool interrupted() const
+		{
+			return m_context.interrupted;
+		}
+	};
+}
@@ -25,6 +25,12 @@ namespace NodeEditor
 
 		float BezierX = 50;
 
+		//ノードの実行時間を色と文字で表示する(NODEEDITOR_PROFILEを定義したときのみ有効)
+		bool ShowProfile = false;
+
+		//起点ノードから実行しても実行されないノード(Graph::deadNodes)を暗く表示する
+		bool DimDeadNodes = false;
+
 		Font font = Font(16);
 
 		std::map<size_t, Texture> typeIconList = std::map<size_t, Texture>
@@ -51,18 +57,4 @@ namespace NodeEditor
 			}
 		}
 	};
-
-	enum class IOType
-	{
-		Input, Output
-	};
-
-	class ISerializable
-	{
-	public:
-
-		virtual void serialize(JSONWriter&) const = 0;
-
-		virtual void deserialize(const JSONValue&) = 0;
-	};
 }
@@ -0,0 +1,1146 @@
+#include"ExecutionPlan.hpp"
+#include"Node.hpp"
+#include"SubgraphNode.hpp"
+
+struct NodeEditor::ExecutionPlan::ParallelContext
+{
+	ThreadPool& pool;
+
+	//ブロックのノード自身の位置(これより前が入力の生成元)
+	uint32 end;
+
+	//評価が終わっていない命令数
+	uint32 remaining;
+
+	std::mutex mutex;
+
+	std::condition_variable cv;
+
+	//呼び出し元のスレッドで評価する命令
+	Array<uint32> serialQueue;
+
+	std::exception_ptr exception;
+};
+
+struct NodeEditor::ExecutionPlan::CommonNodes
+{
+	struct Key
+	{
+		//関数テーブルの番号と、その中の関数の番号
+		uint64 table;
+
+		uint32 function;
+
+		Array<const ValueSocket*> sources;
+
+		bool operator==(const Key& other) const
+		{
+			return table == other.table && function == other.function && sources == other.sources;
+		}
+	};
+
+	struct Hash
+	{
+		size_t operator()(const Key& key) const
+		{
+			size_t hash = static_cast<size_t>(key.table) * 31 + key.function;
+			for (const auto source : key.sources)
+			{
+				hash ^= std::hash<const ValueSocket*>()(source) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			return hash;
+		}
+	};
+
+	//関数と入力の組ごとに最初に並べたノード(m_nodesのインデックス)
+	std::unordered_map<Key, uint32, Hash> nodes;
+};
+
+struct NodeEditor::ExecutionPlan::SubgraphBoundary
+{
+	//内部のノードの境界で未接続のソケットから、サブグラフのノードの対応するソケットへ
+	std::unordered_map<const ISocket*, const ISocket*> outer;
+
+	std::unordered_set<const SubgraphNode*> entered;
+
+	void enter(const SubgraphNode& subgraph)
+	{
+		if (!entered.insert(&subgraph).second)
+		{
+			return;
+		}
+		for (size_t i = 0; i < subgraph.m_inputTargets.size(); i++)
+		{
+			for (const auto& target : subgraph.m_inputTargets[i])
+			{
+				outer.emplace(target.get(), subgraph.m_inputSockets[i].get());
+			}
+		}
+		for (size_t i = 0; i < subgraph.m_execExits.size(); i++)
+		{
+			outer.emplace(subgraph.m_execExits[i].get(), subgraph.m_nextNodeSockets[i].get());
+		}
+	}
+
+	//境界で未接続のソケットを、外側のサブグラフのノードのソケットに置き換える
+	const ISocket* connected(const ISocket* socket) const
+	{
+		while (!socket->ConnectedSocket)
+		{
+			const auto itr = outer.find(socket);
+			if (itr == outer.end())
+			{
+				return nullptr;
+			}
+			socket = itr->second;
+		}
+		return socket;
+	}
+
+	//入力ソケットに値を出力するノードの出力ソケット(サブグラフのノードの出力は内部のノードの出力に置き換える)
+	const ValueSocket* source(const ValueSocket& inSocket)
+	{
+		const auto socket = connected(&inSocket);
+		if (!socket)
+		{
+			return nullptr;
+		}
+
+		auto source = dynamic_cast<const ValueSocket*>(socket->ConnectedSocket[0].get());
+		while (const auto subgraph = dynamic_cast<const SubgraphNode*>(&source->Parent))
+		{
+			enter(*subgraph);
+			source = subgraph->m_outputSources[source->Index].get();
+		}
+		return source;
+	}
+
+	//次の実行ソケットの先で実行するノード(サブグラフのノードは内部の最初に実行するノードに置き換える)
+	void targets(const ExecSocket& nextSocket, Array<Node*>& result)
+	{
+		if (const auto socket = connected(&nextSocket))
+		{
+			for (const auto& prevSocket : socket->ConnectedSocket)
+			{
+				entries(*prevSocket, result);
+			}
+		}
+	}
+
+	void entries(const ISocket& prevSocket, Array<Node*>& result)
+	{
+		if (const auto subgraph = dynamic_cast<const SubgraphNode*>(&prevSocket.Parent))
+		{
+			enter(*subgraph);
+			for (const auto& entry : subgraph->m_execEntries[prevSocket.Index])
+			{
+				entries(*entry, result);
+			}
+		}
+		else
+		{
+			result << &prevSocket.Parent;
+		}
+	}
+};
+
+uint32 NodeEditor::ExecutionPlan::addNode(Node& node, std::unordered_map<const Node*, uint32>& nodeIndex, SubgraphBoundary& boundary)
+{
+	const auto itr = nodeIndex.find(&node);
+	if (itr != nodeIndex.end())
+	{
+		return itr->second;
+	}
+
+	const auto idx = static_cast<uint32>(m_nodes.size());
+	nodeIndex.emplace(&node, idx);
+	m_nodes << NodeEntry{ &node, static_cast<uint32>(m_sources.size()) };
+
+	for (const auto& inSocket : node.m_inputSockets)
+	{
+		m_sources << boundary.source(*inSocket);
+	}
+
+	return idx;
+}
+
+void NodeEditor::ExecutionPlan::addBlock(uint32 nodeIdx, std::unordered_map<const Node*, uint32>& nodeIndex, CommonNodes& common, SubgraphBoundary& boundary)
+{
+	//入力の生成元を帰りがけ順(トポロジカル順)に並べる
+	//循環している接続は辿らない
+	struct Frame
+	{
+		uint32 nodeIdx;
+		size_t inputIdx;
+	};
+
+	std::unordered_map<uint32, bool> visited;
+	Array<Frame> stack;
+
+	//EvaluatesBodyなノードの出力に依存する生成元(そのノードが自身で評価する)
+	std::unordered_set<uint32> body;
+
+	//本体のために命令列に戻した、まとめられたノード
+	std::unordered_set<uint32> restored;
+
+	visited.emplace(nodeIdx, false);
+	stack << Frame{ nodeIdx, 0 };
+
+	while (stack)
+	{
+		auto& frame = stack.back();
+		const auto entry = m_nodes[frame.nodeIdx];
+
+		if (frame.inputIdx < entry.node->m_inputSockets.size())
+		{
+			const auto sourcePos = entry.sourceBegin + frame.inputIdx++;
+			const auto source = m_sources[sourcePos] = mergedSource(m_sources[sourcePos]);
+			if (source)
+			{
+				const auto sourceIdx = addNode(source->Parent, nodeIndex, boundary);
+				const auto [itr, inserted] = visited.emplace(sourceIdx, false);
+				if (inserted)
+				{
+					stack << Frame{ sourceIdx, 0 };
+				}
+				else if (!itr->second)
+				{
+					m_nodes[sourceIdx].cyclic = true;
+					if (m_nodes[sourceIdx].node->EvaluatesBody && !entry.node->EvaluatesBody)
+					{
+						body.insert(frame.nodeIdx);
+					}
+				}
+			}
+		}
+		else
+		{
+			const auto idx = frame.nodeIdx;
+			visited[idx] = true;
+			stack.pop_back();
+
+			//生成元を並べている間にまとめられたノードがあれば付け替える
+			for (size_t i = 0; i < entry.node->m_inputSockets.size(); i++)
+			{
+				auto& source = m_sources[entry.sourceBegin + i];
+				source = mergedSource(source);
+				if (source && !entry.node->EvaluatesBody && body.find(nodeIndex.at(&source->Parent)) != body.end())
+				{
+					body.insert(idx);
+				}
+			}
+
+			if (idx != nodeIdx && body.find(idx) != body.end())
+			{
+				//本体は接続されている出力ソケットを直接参照するので、他のノードにまとめた生成元も評価する
+				for (const auto& inSocket : entry.node->m_inputSockets)
+				{
+					const auto source = boundary.source(*inSocket);
+					if (source && mergedSource(source) != source)
+					{
+						const auto sourceIdx = nodeIndex.at(&source->Parent);
+						if (restored.insert(sourceIdx).second)
+						{
+							m_instructions << sourceIdx;
+						}
+					}
+				}
+				continue;
+			}
+
+			//ブロックのノード自身は実行ソケットで辿るたびに実行する
+			if (m_options.mergeCommon && idx != nodeIdx && mergeCommon(idx, common))
+			{
+				//まとめた先が別のブロックで並べられたノードなら、このブロックでも評価する(入力は同じなので並べ終えている)
+				const auto& outputs = entry.node->m_outputSockets;
+				if (outputs)
+				{
+					const auto originalIdx = nodeIndex.at(&mergedSource(outputs[0].get())->Parent);
+					if (visited.emplace(originalIdx, true).second && !m_nodes[originalIdx].folded)
+					{
+						m_instructions << originalIdx;
+					}
+				}
+				continue;
+			}
+
+			//生成元は全て並べ終えているので、定数かどうかが決まる(循環している生成元は定数として扱わない)
+			auto& current = m_nodes[idx];
+			current.constant = isConstant(current, nodeIndex);
+
+			if (m_options.foldConstants && current.constant && idx != nodeIdx)
+			{
+				if (!current.folded)
+				{
+					current.folded = true;
+					m_folded << idx;
+				}
+			}
+			else
+			{
+				m_instructions << idx;
+			}
+		}
+	}
+}
+
+const NodeEditor::ValueSocket* NodeEditor::ExecutionPlan::mergedSource(const ValueSocket* source) const
+{
+	const auto itr = source ? m_merged.find(source) : m_merged.end();
+	return itr != m_merged.end() ? itr->second : source;
+}
+
+bool NodeEditor::ExecutionPlan::mergeCommon(uint32 nodeIdx, CommonNodes& common)
+{
+	auto& entry = m_nodes[nodeIdx];
+	if (entry.merged)
+	{
+		return true;
+	}
+
+	//Pureな関数ノードはインスタンスごとの設定を持たないので、関数と入力が同じなら出力も同じ
+	const auto& node = *entry.node;
+	if (!node.Pure || !node.Deterministic || !node.FunctionId || entry.cyclic)
+	{
+		return false;
+	}
+
+	CommonNodes::Key key{ node.FunctionTableId, *node.FunctionId, {} };
+	for (size_t i = 0; i < node.m_inputSockets.size(); i++)
+	{
+		const auto source = m_sources[entry.sourceBegin + i];
+		//未接続の入力があるノードはエラーをそれぞれのノードに記録する
+		if (!source)
+		{
+			return false;
+		}
+		key.sources << source;
+	}
+
+	const auto [itr, inserted] = common.nodes.emplace(std::move(key), nodeIdx);
+	if (inserted || itr->second == nodeIdx)
+	{
+		return false;
+	}
+
+	//まとめたノードは実行しないので、出力ソケットはまとめ先の出力ソケットを参照する
+	//(計画の外から読んでも最新の値になる。再びノードを実行すると参照は外れる)
+	const auto& original = *m_nodes[itr->second].node;
+	for (size_t i = 0; i < node.m_outputSockets.size(); i++)
+	{
+		m_merged.emplace(node.m_outputSockets[i].get(), original.m_outputSockets[i].get());
+		node.m_outputSockets[i]->bind(*original.m_outputSockets[i]);
+	}
+	entry.merged = true;
+	return true;
+}
+
+bool NodeEditor::ExecutionPlan::isConstant(const NodeEntry& entry, const std::unordered_map<const Node*, uint32>& nodeIndex) const
+{
+	const auto& node = *entry.node;
+	//入力の無いノードはConstantでなければ定数として扱わない(Pureでも、入力が変化しないことを理由に省略しない)
+	if (!node.Constant && !(node.Pure && node.Deterministic && node.m_inputSockets))
+	{
+		return false;
+	}
+	for (size_t i = 0; i < node.m_inputSockets.size(); i++)
+	{
+		const auto source = m_sources[entry.sourceBegin + i];
+		if (!source || !m_nodes[nodeIndex.at(&source->Parent)].constant)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void NodeEditor::ExecutionPlan::addDependencies(const Block& block, const std::unordered_map<const Node*, uint32>& nodeIndex)
+{
+	std::unordered_map<uint32, uint32> position;
+	for (uint32 pos = block.instBegin; pos < block.instEnd; pos++)
+	{
+		position.emplace(m_instructions[pos], pos);
+	}
+
+	Array<Array<uint32>> dependents(block.instEnd - block.instBegin);
+	m_dependencyCount.resize(block.instEnd, 0);
+
+	for (uint32 pos = block.instBegin; pos < block.instEnd; pos++)
+	{
+		const auto& entry = m_nodes[m_instructions[pos]];
+		for (size_t i = 0; i < entry.node->m_inputSockets.size(); i++)
+		{
+			const auto source = m_sources[entry.sourceBegin + i];
+			if (!source)
+			{
+				continue;
+			}
+			//循環している接続(後ろにある生成元)は依存として扱わない
+			const auto itr = position.find(nodeIndex.at(&source->Parent));
+			if (itr != position.end() && itr->second < pos)
+			{
+				m_dependencyCount[pos]++;
+				dependents[itr->second - block.instBegin] << pos;
+			}
+		}
+	}
+
+	for (const auto& list : dependents)
+	{
+		const auto begin = static_cast<uint32>(m_dependents.size());
+		m_dependents.append(list);
+		m_dependentRange << Range{ begin, static_cast<uint32>(m_dependents.size()) };
+	}
+}
+
+void NodeEditor::ExecutionPlan::markCycles()
+{
+	//Tarjanの強連結成分分解(再帰しない)で循環に含まれるブロックを求める
+	constexpr uint32 Unvisited = UINT32_MAX;
+
+	struct Frame
+	{
+		uint32 block;
+		uint32 edge;
+	};
+
+	const auto blockCount = static_cast<uint32>(m_blocks.size());
+	Array<uint32> order(blockCount, Unvisited);
+	Array<uint32> lowLink(blockCount, 0);
+	Array<bool> onStack(blockCount, false);
+	Array<uint32> component;
+	Array<Frame> stack;
+	uint32 counter = 0;
+
+	m_cyclic.assign(blockCount, false);
+
+	const auto edgeRange = [this](uint32 blockIdx)
+	{
+		const auto& block = m_blocks[blockIdx];
+		if (block.nextBegin == block.nextEnd)
+		{
+			return Range{ 0, 0 };
+		}
+		return Range{ m_nextTable[block.nextBegin].begin, m_nextTable[block.nextEnd - 1].end };
+	};
+
+	const auto visit = [&](uint32 blockIdx)
+	{
+		order[blockIdx] = lowLink[blockIdx] = counter++;
+		onStack[blockIdx] = true;
+		component << blockIdx;
+		stack << Frame{ blockIdx, edgeRange(blockIdx).begin };
+	};
+
+	for (uint32 root = 0; root < blockCount; root++)
+	{
+		if (order[root] != Unvisited)
+		{
+			continue;
+		}
+
+		visit(root);
+		while (stack)
+		{
+			auto& frame = stack.back();
+			const auto current = frame.block;
+
+			if (frame.edge < edgeRange(current).end)
+			{
+				const auto next = m_successors[frame.edge++];
+				if (next == current)
+				{
+					m_cyclic[current] = true;
+				}
+				if (order[next] == Unvisited)
+				{
+					visit(next);
+				}
+				else if (onStack[next])
+				{
+					lowLink[current] = Min(lowLink[current], order[next]);
+				}
+				continue;
+			}
+
+			stack.pop_back();
+			if (stack)
+			{
+				auto& parent = lowLink[stack.back().block];
+				parent = Min(parent, lowLink[current]);
+			}
+
+			if (lowLink[current] == order[current])
+			{
+				//2つ以上のブロックからなる成分は循環している
+				const bool cyclic = component.back() != current;
+				while (true)
+				{
+					const auto blockIdx = component.back();
+					component.pop_back();
+					onStack[blockIdx] = false;
+					m_cyclic[blockIdx] = m_cyclic[blockIdx] || cyclic;
+					if (blockIdx == current)
+					{
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	m_hasCycle = m_cyclic.includes(true);
+}
+
+std::shared_ptr<NodeEditor::ExecutionPlan> NodeEditor::ExecutionPlan::Compile(Node& entry, const ExecutionPlan* previous, const CompileOptions& options)
+{
+	auto plan = std::make_shared<ExecutionPlan>();
+	plan->m_topologyVersion = ISocket::TopologyVersion();
+	plan->m_options = options;
+
+	std::unordered_map<const Node*, uint32> nodeIndex;
+
+	//実行ソケットで到達できるノードを列挙
+	//サブグラフのノードは境界の接続を内部のノードへ付け替えて展開する
+	Array<Node*> blockNodes = { &entry };
+	std::unordered_map<const Node*, uint32> blockIndex = { { &entry, 0 } };
+	SubgraphBoundary boundary;
+	Array<Node*> targets;
+
+	for (size_t i = 0; i < blockNodes.size(); i++)
+	{
+		for (const auto& nextSocket : blockNodes[i]->m_nextNodeSockets)
+		{
+			targets.clear();
+			boundary.targets(*nextSocket, targets);
+			for (const auto target : targets)
+			{
+				if (blockIndex.emplace(target, static_cast<uint32>(blockNodes.size())).second)
+				{
+					blockNodes << target;
+				}
+			}
+		}
+	}
+
+	plan->m_blocks.resize(blockNodes.size());
+
+	CommonNodes common;
+
+	for (size_t i = 0; i < blockNodes.size(); i++)
+	{
+		auto& block = plan->m_blocks[i];
+
+		block.instBegin = static_cast<uint32>(plan->m_instructions.size());
+		const auto nodeIdx = plan->addNode(*blockNodes[i], nodeIndex, boundary);
+		plan->m_nodes[nodeIdx].block = true;
+		plan->addBlock(nodeIdx, nodeIndex, common, boundary);
+		block.instEnd = static_cast<uint32>(plan->m_instructions.size());
+		plan->addDependencies(block, nodeIndex);
+
+		block.nextBegin = static_cast<uint32>(plan->m_nextTable.size());
+		for (const auto& nextSocket : blockNodes[i]->m_nextNodeSockets)
+		{
+			Range range;
+			range.begin = static_cast<uint32>(plan->m_successors.size());
+			targets.clear();
+			boundary.targets(*nextSocket, targets);
+			for (const auto target : targets)
+			{
+				plan->m_successors << blockIndex[target];
+			}
+			range.end = static_cast<uint32>(plan->m_successors.size());
+			plan->m_nextTable << range;
+		}
+		block.nextEnd = static_cast<uint32>(plan->m_nextTable.size());
+	}
+
+	plan->markCycles();
+
+	plan->m_dead.resize(plan->m_blocks.size(), false);
+	if (options.eliminateDead)
+	{
+		plan->markDeadBlocks(nodeIndex);
+	}
+
+	//中断しているノードが新しい計画でも実行ソケットで到達できれば引き継ぐ
+	//(到達できないノードは削除されている可能性があるので参照しない)
+	if (previous)
+	{
+		for (const auto blockIdx : previous->m_suspended)
+		{
+			const auto node = previous->m_nodes[previous->m_instructions[previous->m_blocks[blockIdx].instEnd - 1]].node;
+			const auto itr = blockIndex.find(node);
+			if (itr != blockIndex.end() && node->suspended())
+			{
+				plan->m_suspended << itr->second;
+			}
+			else
+			{
+				//到達できなくなったノードはどの計画からも再開されず、再び接続しても中断中として飛ばされ続けるので破棄する
+				node->abortSuspended();
+			}
+		}
+
+		//反復の途中だったループは、新しい計画では最初から実行する
+		for (const auto& loop : previous->m_loops)
+		{
+			const auto node = previous->m_nodes[previous->m_instructions[previous->m_blocks[loop.block].instEnd - 1]].node;
+			if (blockIndex.find(node) != blockIndex.end())
+			{
+				node->abortLoop();
+			}
+		}
+	}
+
+	plan->m_counters = std::make_unique<std::atomic<uint32>[]>(plan->m_instructions.size());
+
+	return plan;
+}
+
+bool NodeEditor::ExecutionPlan::evaluate(const NodeEntry& entry)
+{
+	const auto sources = m_sources.data() + entry.sourceBegin;
+	entry.node->m_evalPass = m_pass;
+
+	//このパスで失敗した生成元の出力は古い値なので、使わずに失敗を下流へ伝える
+	//(循環している接続の生成元は前のパスで評価されたものなので対象にしない)
+	for (size_t i = 0; i < entry.node->m_inputSockets.size(); i++)
+	{
+		const Node* producer = sources[i] ? &sources[i]->Parent : nullptr;
+		if (producer && producer->m_error && m_passBegin <= producer->m_evalPass)
+		{
+			entry.node->m_error = NodeError();
+			return entry.node->setError(NodeErrorCode::InputFailed, i);
+		}
+	}
+
+	//入力が変化していなければ前回の出力を使う
+	if (entry.node->upToDate(sources))
+	{
+		m_skipped++;
+		return true;
+	}
+
+	m_evaluated++;
+	return entry.node->execute(sources);
+}
+
+bool NodeEditor::ExecutionPlan::evaluated(const NodeEntry& entry) const
+{
+	//実行ソケットで到達するノードは、反復ごとに入力の生成元として実行し直さない
+	return entry.block ? entry.node->m_evalPass >= m_passBegin : entry.node->m_evalPass == m_pass;
+}
+
+bool NodeEditor::ExecutionPlan::expired(const Deadline* deadline) const
+{
+	return deadline && m_sliceProgress && std::chrono::steady_clock::now() >= *deadline;
+}
+
+bool NodeEditor::ExecutionPlan::runProducers(const Block& block, uint32& pos, const Deadline* deadline)
+{
+	//このパスで評価済みのものは出力値をそのまま使う
+	for (; pos + 1 < block.instEnd; pos++)
+	{
+		const auto& entry = m_nodes[m_instructions[pos]];
+		if (!evaluated(entry))
+		{
+			if (expired(deadline))
+			{
+				return false;
+			}
+			evaluate(entry);
+			m_sliceProgress = true;
+		}
+	}
+	return true;
+}
+
+void NodeEditor::ExecutionPlan::runProducersParallel(const Block& block, ThreadPool& pool)
+{
+	ParallelContext context{ pool, block.instEnd - 1, block.instEnd - 1 - block.instBegin };
+
+	if (context.remaining < 2)
+	{
+		uint32 pos = block.instBegin;
+		runProducers(block, pos, nullptr);
+		return;
+	}
+
+	for (uint32 pos = block.instBegin; pos < context.end; pos++)
+	{
+		m_counters[pos] = m_dependencyCount[pos];
+	}
+	for (uint32 pos = block.instBegin; pos < context.end; pos++)
+	{
+		if (m_dependencyCount[pos] == 0)
+		{
+			dispatch(context, pos);
+		}
+	}
+
+	//ThreadSafeでないノードはこのスレッドで評価する
+	while (true)
+	{
+		uint32 pos;
+		{
+			std::unique_lock lock(context.mutex);
+			context.cv.wait(lock, [&context]() { return context.serialQueue || context.remaining == 0; });
+			if (!context.serialQueue)
+			{
+				break;
+			}
+			pos = context.serialQueue.back();
+			context.serialQueue.pop_back();
+		}
+
+		const auto& entry = m_nodes[m_instructions[pos]];
+		if (!evaluated(entry))
+		{
+			try
+			{
+				evaluate(entry);
+			}
+			catch (...)
+			{
+				std::lock_guard lock(context.mutex);
+				context.exception = context.exception ? context.exception : std::current_exception();
+			}
+		}
+		complete(context, pos);
+	}
+
+	if (context.exception)
+	{
+		std::rethrow_exception(context.exception);
+	}
+}
+
+void NodeEditor::ExecutionPlan::dispatch(ParallelContext& context, uint32 pos)
+{
+	const auto& entry = m_nodes[m_instructions[pos]];
+	const auto node = entry.node;
+
+	//評価が短時間で終わるノードはプールに渡す負担の方が大きいので、このスレッドで評価する
+	const bool cheap = 0 < node->Cost && node->Cost < MinParallelCost;
+
+	if (node->ThreadSafe && !cheap && !evaluated(entry))
+	{
+		context.pool.submit([this, &context, pos]()
+			{
+				try
+				{
+					evaluate(m_nodes[m_instructions[pos]]);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(context.mutex);
+					context.exception = context.exception ? context.exception : std::current_exception();
+				}
+				complete(context, pos);
+			});
+	}
+	else
+	{
+		{
+			std::lock_guard lock(context.mutex);
+			context.serialQueue << pos;
+		}
+		context.cv.notify_one();
+	}
+}
+
+void NodeEditor::ExecutionPlan::complete(ParallelContext& context, uint32 pos)
+{
+	const auto range = m_dependentRange[pos];
+	for (uint32 i = range.begin; i < range.end; i++)
+	{
+		const auto dependent = m_dependents[i];
+		if (dependent < context.end && --m_counters[dependent] == 0)
+		{
+			dispatch(context, dependent);
+		}
+	}
+
+	//contextはremainingが0になった時点で破棄されうるので、ロック中に通知する
+	std::lock_guard lock(context.mutex);
+	if (--context.remaining == 0)
+	{
+		context.cv.notify_all();
+	}
+}
+
+void NodeEditor::ExecutionPlan::markDeadBlocks(const std::unordered_map<const Node*, uint32>& nodeIndex)
+{
+	//副作用のあるノードから入力の生成元を辿り、結果が使われるノードを求める
+	//起点ノード(呼び出し元が出力を読む)と、次の実行ソケットを複数持つノード(実行して行き先を決める)も必ず実行する
+	Array<bool> needed(m_nodes.size(), false);
+	Array<uint32> stack;
+
+	const auto entryIdx = m_instructions[m_blocks[0].instEnd - 1];
+	for (uint32 i = 0; i < m_nodes.size(); i++)
+	{
+		const auto& node = *m_nodes[i].node;
+		if (!node.Pure || node.m_nextNodeSockets.size() > 1 || i == entryIdx)
+		{
+			needed[i] = true;
+			stack << i;
+		}
+	}
+
+	while (stack)
+	{
+		const auto& entry = m_nodes[stack.back()];
+		stack.pop_back();
+
+		for (size_t i = 0; i < entry.node->m_inputSockets.size(); i++)
+		{
+			const auto source = m_sources[entry.sourceBegin + i];
+			if (!source)
+			{
+				continue;
+			}
+			const auto sourceIdx = nodeIndex.at(&source->Parent);
+			if (!needed[sourceIdx])
+			{
+				needed[sourceIdx] = true;
+				stack << sourceIdx;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < m_blocks.size(); i++)
+	{
+		m_dead[i] = !needed[m_instructions[m_blocks[i].instEnd - 1]];
+	}
+}
+
+void NodeEditor::ExecutionPlan::foldConstants()
+{
+	const auto version = constantVersion();
+
+	//失敗したノードがあれば次のパスでも計算し直す
+	bool succeeded = true;
+	for (const auto nodeIdx : m_folded)
+	{
+		succeeded = evaluate(m_nodes[nodeIdx]) && succeeded;
+	}
+	m_constantVersion = succeeded ? Optional<uint64>(version) : none;
+}
+
+uint64 NodeEditor::ExecutionPlan::constantVersion() const
+{
+	//他のグラフや計画のノードの編集では変わらない
+	uint64 version = 0;
+	for (const auto nodeIdx : m_folded)
+	{
+		version += m_nodes[nodeIdx].node->m_constantVersion;
+	}
+	return version;
+}
+
+void NodeEditor::ExecutionPlan::beginPass()
+{
+	m_pass = ++s_passCounter;
+	m_passBegin = m_pass;
+	m_evaluated = 0;
+	m_skipped = 0;
+	m_steps = 0;
+	m_interrupted = false;
+
+	//途中で止めたパスのループは打ち切る
+	abortLoops(m_loops);
+
+	m_stack.clear();
+	m_pausedBlock.reset();
+	m_inProgress = false;
+	m_resumePass = false;
+
+	if (m_folded && m_constantVersion != constantVersion())
+	{
+		foldConstants();
+	}
+}
+
+bool NodeEditor::ExecutionPlan::runStack(ThreadPool* pool, const Deadline* deadline)
+{
+	//ノードの中から使えるよう、実行中のスレッドプールを記録する
+	struct PoolScope
+	{
+		ThreadPool* previous;
+
+		explicit PoolScope(ThreadPool* pool)
+			:previous(std::exchange(t_currentPool, pool))
+		{
+
+		}
+
+		~PoolScope()
+		{
+			t_currentPool = previous;
+		}
+	} poolScope(pool);
+
+	while (m_pausedBlock || m_stack)
+	{
+		uint32 blockIdx;
+		uint32 pos;
+
+		if (m_pausedBlock)
+		{
+			//時間切れで止めたブロックの続きから
+			blockIdx = *m_pausedBlock;
+			pos = m_pausedPos;
+			m_pausedBlock.reset();
+		}
+		else
+		{
+			blockIdx = m_stack.back();
+			m_stack.pop_back();
+			pos = m_blocks[blockIdx].instBegin;
+
+			//終わらないループなどで止まらなくなるのを防ぐ(循環している計画はそもそも実行しない)
+			if (++m_steps > s_stepLimit)
+			{
+				m_steps--;
+				m_interrupted = true;
+				m_nodes[m_instructions[m_blocks[blockIdx].instEnd - 1]].node->setError(NodeErrorCode::StepLimitExceeded);
+				abortLoops(m_loops);
+				break;
+			}
+
+			//中断しているノードには入らない
+			if (m_nodes[m_instructions[m_blocks[blockIdx].instEnd - 1]].node->suspended())
+			{
+				continue;
+			}
+
+			//結果が使われないノードは実行せずに次のノードへ進む
+			if (m_dead[blockIdx])
+			{
+				pushNext(m_blocks[blockIdx], *m_nodes[m_instructions[m_blocks[blockIdx].instEnd - 1]].node);
+				continue;
+			}
+		}
+
+		const auto block = m_blocks[blockIdx];
+		const auto& entry = m_nodes[m_instructions[block.instEnd - 1]];
+
+		const detail::TraceScope trace(Trace::Category::Step, *entry.node);
+
+		//入力の生成元を実行
+		if (pool && pos == block.instBegin && !expired(deadline))
+		{
+			runProducersParallel(block, *pool);
+			pos = block.instEnd - 1;
+			m_sliceProgress = true;
+		}
+		if (!runProducers(block, pos, deadline) || expired(deadline))
+		{
+			m_pausedBlock = blockIdx;
+			m_pausedPos = pos;
+			return false;
+		}
+
+		//ブロックのノード自身を実行
+		m_sliceProgress = true;
+		if (!evaluate(entry))
+		{
+			endLoop(m_loops, blockIdx);
+			continue;
+		}
+
+		//中断したら再開するまで次のノードに進まない
+		if (entry.node->suspended())
+		{
+			m_suspended << blockIdx;
+			continue;
+		}
+
+		//ループのノードは本体を実行し終えたら再び実行する
+		if (entry.node->looping())
+		{
+			nextIteration(m_loops, blockIdx);
+			//本体の入力の生成元を反復ごとに評価し直す
+			m_pass = ++s_passCounter;
+			m_stack << blockIdx;
+		}
+		else
+		{
+			endLoop(m_loops, blockIdx);
+		}
+
+		pushNext(block, *entry.node);
+	}
+	return true;
+}
+
+void NodeEditor::ExecutionPlan::pushNext(const Block& block, const Node& node)
+{
+	//次のノードを積む(接続順に実行されるよう逆順に積む)
+	if (block.nextBegin != block.nextEnd)
+	{
+		const auto& next = m_nextTable[block.nextBegin + node.NextExecIdx];
+		for (uint32 i = next.end; i > next.begin; i--)
+		{
+			m_stack << m_successors[i - 1];
+		}
+	}
+}
+
+void NodeEditor::ExecutionPlan::nextIteration(Array<LoopFrame>& loops, uint32 blockIdx) const
+{
+	//反復のステップ数はパス全体のステップ数に加算されるので、終わらないループもステップ数の上限で止まる
+	if (!loops || loops.back().block != blockIdx)
+	{
+		loops << LoopFrame{ blockIdx };
+	}
+}
+
+void NodeEditor::ExecutionPlan::endLoop(Array<LoopFrame>& loops, uint32 blockIdx) const
+{
+	if (loops && loops.back().block == blockIdx)
+	{
+		m_nodes[m_instructions[m_blocks[blockIdx].instEnd - 1]].node->abortLoop();
+		loops.pop_back();
+	}
+}
+
+void NodeEditor::ExecutionPlan::abortLoops(Array<LoopFrame>& loops) const
+{
+	for (const auto& loop : loops)
+	{
+		m_nodes[m_instructions[m_blocks[loop.block].instEnd - 1]].node->abortLoop();
+	}
+	loops.clear();
+}
+
+const NodeEditor::Node& NodeEditor::ExecutionPlan::entryNode() const
+{
+	return *m_nodes[m_instructions[m_blocks[0].instEnd - 1]].node;
+}
+
+void NodeEditor::ExecutionPlan::run(ThreadPool* pool)
+{
+	const detail::TraceScope trace(Trace::Category::Pass, entryNode());
+
+	beginPass();
+
+	if (reportCycle())
+	{
+		return;
+	}
+
+	m_stack << 0;
+
+	runStack(pool);
+}
+
+bool NodeEditor::ExecutionPlan::runFor(const Duration& budget, ThreadPool* pool)
+{
+	const Deadline deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+
+	const detail::TraceScope trace(Trace::Category::Pass, entryNode());
+
+	if (!m_inProgress)
+	{
+		if (m_suspended)
+		{
+			resumeSuspended();
+			m_resumePass = true;
+		}
+		else
+		{
+			beginPass();
+			if (reportCycle())
+			{
+				return true;
+			}
+			m_stack << 0;
+		}
+	}
+
+	m_sliceProgress = false;
+	while (runStack(pool, &deadline))
+	{
+		if (!m_resumePass)
+		{
+			m_inProgress = false;
+			return true;
+		}
+
+		//中断していたノードの続きが終わったら、同じ時間枠で起点ノードからのパスを始める
+		beginPass();
+		m_stack << 0;
+	}
+	m_inProgress = true;
+	return false;
+}
+
+void NodeEditor::ExecutionPlan::resume(ThreadPool* pool)
+{
+	if (!m_suspended || m_inProgress)
+	{
+		return;
+	}
+
+	const detail::TraceScope trace(Trace::Category::Pass, entryNode());
+
+	resumeSuspended();
+
+	runStack(pool);
+}
+
+bool NodeEditor::ExecutionPlan::reportCycle()
+{
+	if (!m_hasCycle)
+	{
+		return false;
+	}
+
+	//循環に含まれるノードにエラーを記録する(どこから実行しても終わらない可能性があるので、どのノードも実行しない)
+	for (size_t i = 0; i < m_blocks.size(); i++)
+	{
+		if (m_cyclic[i])
+		{
+			m_nodes[m_instructions[m_blocks[i].instEnd - 1]].node->setError(NodeErrorCode::ExecCycle);
+		}
+	}
+	m_interrupted = true;
+	return true;
+}
+
+void NodeEditor::ExecutionPlan::resumeSuspended()
+{
+	beginPass();
+
+	const auto suspended = std::move(m_suspended);
+	m_suspended.clear();
+
+	Array<uint32> completed;
+	for (const auto blockIdx : suspended)
+	{
+		const auto node = m_nodes[m_instructions[m_blocks[blockIdx].instEnd - 1]].node;
+
+		if (!node->resumeRun())
+		{
+			continue;
+		}
+		if (node->suspended())
+		{
+			m_suspended << blockIdx;
+			continue;
+		}
+
+		//完了したノードはこのパスで評価済みとして扱う(後続の入力の生成元として再び実行しない)
+		node->m_evalPass = m_pass;
+		completed << blockIdx;
+	}
+
+	//中断した順に次のノードへ進むよう逆順に積む
+	for (size_t i = completed.size(); i > 0; i--)
+	{
+		const auto& block = m_blocks[completed[i - 1]];
+		pushNext(block, *m_nodes[m_instructions[block.instEnd - 1]].node);
+	}
+}
@@ -0,0 +1,442 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<atomic>
+#include<chrono>
+#include<unordered_map>
+#include<unordered_set>
+#include"NodeSocket.hpp"
+#include"ThreadPool.hpp"
+#include"Trace.hpp"
+
+namespace NodeEditor
+{
+	class Node;
+
+	/// <summary>
+	/// 実行計画を生成するときに行う最適化
+	/// </summary>
+	struct CompileOptions
+	{
+		//Constantなノードと、その出力だけからPureなノードで計算される入力の生成元を命令列から除き、
+		//定数の値が編集されるまで再び評価しない
+		bool foldConstants = true;
+
+		//実行ソケットで到達するPureなノードのうち、出力が計画内のどこにも使われないものを実行しない
+		//(起点ノードと、次の実行ソケットを複数持つノードは除く。関数のノードはpureを指定して登録したものだけが対象)
+		bool eliminateDead = true;
+
+		//関数テーブルの同じ関数に同じ出力ソケットを入力したPureな関数ノードを1つだけ評価し、
+		//その出力を全ての接続先で使う(グラフ自体は変更しない)
+		bool mergeCommon = true;
+	};
+
+	/// <summary>
+	/// ソケットの接続関係から生成した平坦な実行計画
+	/// </summary>
+	/// <remarks>
+	/// 起点ノードから実行ソケットで到達できるノードごとにブロックを作り、
+	/// ブロック内には入力の生成元ノードをトポロジカル順に並べる。
+	/// 接続が変更される(ISocket::TopologyVersionが変わる)まで使い回す。
+	/// </remarks>
+	class ExecutionPlan
+	{
+		friend class Bytecode;
+
+		friend class Batch;
+
+	public:
+
+		/// <summary>
+		/// 直前の実行の集計
+		/// </summary>
+		struct Statistics
+		{
+			//childRunを実行したノード数
+			size_t evaluated = 0;
+
+			//入力が変化していないため実行を省略したノード数
+			size_t skipped = 0;
+
+			//実行ソケットで辿ったノード数
+			size_t steps = 0;
+
+			//ステップ数の上限に達して中断したらtrue
+			bool interrupted = false;
+		};
+
+		/// <summary>
+		/// 1回の実行で辿るノード数の上限の既定値
+		/// </summary>
+		/// <remarks>
+		/// ループの反復で辿ったノードも数える(ループの本体が1ノードなら、1回の反復はループのノードと合わせて2ステップ)
+		/// </remarks>
+		static constexpr size_t DefaultStepLimit = 1000000;
+
+		/// <summary>
+		/// 並列実行時にスレッドプールに渡すノードの評価時間の下限[ns](Node::Costが不明なノードは常に渡す)
+		/// </summary>
+		static constexpr double MinParallelCost = 2000;
+
+	private:
+
+		//計画に含まれるノード
+		struct NodeEntry
+		{
+			Node* node;
+			//m_sourcesの先頭(入力ソケットの数だけ続く)
+			uint32 sourceBegin;
+			//Constantなノードから、Pureなノードだけを介して計算されるならtrue
+			bool constant = false;
+			//m_foldedに含まれていればtrue
+			bool folded = false;
+			//循環している接続の生成元ならtrue(他のノードとまとめない)
+			bool cyclic = false;
+			//他のノードにまとめて評価しないならtrue
+			bool merged = false;
+			//実行ソケットで到達するノード(ブロックのノード自身)ならtrue
+			bool block = false;
+		};
+
+		//実行ソケットで到達するノード1つ分の命令列
+		struct Block
+		{
+			//m_instructionsの範囲(最後の命令がブロックのノード自身)
+			uint32 instBegin;
+			uint32 instEnd;
+			//m_nextTableの範囲(次の実行ソケット1つにつき1要素)
+			uint32 nextBegin;
+			uint32 nextEnd;
+		};
+
+		struct Range
+		{
+			uint32 begin;
+			uint32 end;
+		};
+
+		//反復中のループのノード
+		struct LoopFrame
+		{
+			//ループのノードのブロック
+			uint32 block;
+		};
+
+		//実行のたびに加算されるパス番号(全ての計画で共通)
+		static inline uint64 s_passCounter = 0;
+
+		static inline size_t s_stepLimit = DefaultStepLimit;
+
+		//このスレッドで実行中の計画に渡されたスレッドプール
+		static inline thread_local ThreadPool* t_currentPool = nullptr;
+
+		uint64 m_topologyVersion = 0;
+
+		//畳み込んだ定数を計算したときのconstantVersion()(noneなら未計算か、失敗したノードがある)
+		Optional<uint64> m_constantVersion;
+
+		CompileOptions m_options;
+
+		//実行中のパス番号(ループの反復ごとに進む)
+		uint64 m_pass = 0;
+
+		//パスを始めたときのパス番号
+		uint64 m_passBegin = 0;
+
+		//入力ソケットごとの接続先の出力ソケット(未接続の場合はnullptr)
+		Array<const ValueSocket*> m_sources;
+
+		Array<NodeEntry> m_nodes;
+
+		//m_nodesのインデックスの列
+		Array<uint32> m_instructions;
+
+		Array<Block> m_blocks;
+
+		//m_successorsの範囲
+		Array<Range> m_nextTable;
+
+		//m_blocksのインデックスの列
+		Array<uint32> m_successors;
+
+		//定数として畳み込んだ入力の生成元(m_nodesのインデックスをトポロジカル順に並べたもの)
+		//ブロックの命令列には含めず、パスの開始時に必要な場合だけ評価する
+		Array<uint32> m_folded;
+
+		//実行ソケットの循環に含まれるブロックならtrue(m_blocksと同じ並び)
+		Array<bool> m_cyclic;
+
+		//実行しても結果が使われないブロックならtrue(m_blocksと同じ並び)
+		//ノードを実行せずに次のノードへ進む
+		Array<bool> m_dead;
+
+		//まとめたノードの出力ソケットから、代わりに評価するノードの出力ソケットへの対応
+		std::unordered_map<const ValueSocket*, const ValueSocket*> m_merged;
+
+		bool m_hasCycle = false;
+
+		//ブロック内の依存関係(m_instructionsと同じ並び)
+		//同じブロック内で先に評価される入力の生成元の数
+		Array<uint32> m_dependencyCount;
+
+		//m_dependentsの範囲
+		Array<Range> m_dependentRange;
+
+		//出力を使う同じブロック内の命令の位置
+		Array<uint32> m_dependents;
+
+		//並列実行時の残りの依存数
+		std::unique_ptr<std::atomic<uint32>[]> m_counters;
+
+		//実行時に使い回すスタック
+		Array<uint32> m_stack;
+
+		//ノードが中断しているブロック(再開したら次のノードに進む)
+		Array<uint32> m_suspended;
+
+		//時間切れで止めたブロックと、その中で次に評価する命令の位置
+		Optional<uint32> m_pausedBlock;
+
+		uint32 m_pausedPos = 0;
+
+		//時間分割で実行中のパスがあればtrue
+		bool m_inProgress = false;
+
+		//runForで中断していたノードの続きを実行しているパスならtrue(終わったら起点ノードからのパスを始める)
+		bool m_resumePass = false;
+
+		//今回の時間枠でノードを1つ以上評価したらtrue(期限が短すぎても必ず進むようにする)
+		bool m_sliceProgress = false;
+
+		std::atomic<size_t> m_evaluated = 0;
+
+		std::atomic<size_t> m_skipped = 0;
+
+		size_t m_steps = 0;
+
+		//反復中のループ(内側のループほど後ろ)
+		Array<LoopFrame> m_loops;
+
+		bool m_interrupted = false;
+
+		struct ParallelContext;
+
+		struct CommonNodes;
+
+		//サブグラフのノードを展開するための、境界のソケットの対応
+		struct SubgraphBoundary;
+
+		uint32 addNode(Node& node, std::unordered_map<const Node*, uint32>& nodeIndex, SubgraphBoundary& boundary);
+
+		void addBlock(uint32 nodeIdx, std::unordered_map<const Node*, uint32>& nodeIndex, CommonNodes& common, SubgraphBoundary& boundary);
+
+		//まとめたノードの出力を参照している入力を、代わりのノードの出力に付け替える
+		const ValueSocket* mergedSource(const ValueSocket* source) const;
+
+		//既に並べた同じ関数・同じ入力のノードがあればそれにまとめてtrueを返す
+		bool mergeCommon(uint32 nodeIdx, CommonNodes& common);
+
+		void addDependencies(const Block& block, const std::unordered_map<const Node*, uint32>& nodeIndex);
+
+		void markCycles();
+
+		bool isConstant(const NodeEntry& entry, const std::unordered_map<const Node*, uint32>& nodeIndex) const;
+
+		void markDeadBlocks(const std::unordered_map<const Node*, uint32>& nodeIndex);
+
+		void foldConstants();
+
+		//畳み込んだノードのconstantChangedの回数の合計(どれかの値が編集されると変わる)
+		uint64 constantVersion() const;
+
+		using Deadline = std::chrono::steady_clock::time_point;
+
+		bool evaluate(const NodeEntry& entry);
+
+		//このパスで評価済みならtrue(入力の生成元としてだけ評価するノードはループの今回の反復で評価済みならtrue)
+		bool evaluated(const NodeEntry& entry) const;
+
+		bool expired(const Deadline* deadline) const;
+
+		//posから入力の生成元を評価する(期限を過ぎたらその位置で止めてfalseを返す)
+		bool runProducers(const Block& block, uint32& pos, const Deadline* deadline);
+
+		void runProducersParallel(const Block& block, ThreadPool& pool);
+
+		void dispatch(ParallelContext& context, uint32 pos);
+
+		void complete(ParallelContext& context, uint32 pos);
+
+		void beginPass();
+
+		//新しいパスを始めて中断しているノードを再開し、完了したノードの次のノードをスタックに積む
+		void resumeSuspended();
+
+		//実行ソケットが循環していれば、循環に含まれるノードにエラーを記録してtrueを返す
+		bool reportCycle();
+
+		//スタックが空になるまでブロックを実行する(期限を過ぎたらノードの境界で止めてfalseを返す)
+		bool runStack(ThreadPool* pool, const Deadline* deadline = nullptr);
+
+		void pushNext(const Block& block, const Node& node);
+
+		//ループのノードが次の反復に進むときに呼ぶ
+		void nextIteration(Array<LoopFrame>& loops, uint32 blockIdx) const;
+
+		//ブロックのノードが反復を終えたら、または失敗したら呼ぶ
+		void endLoop(Array<LoopFrame>& loops, uint32 blockIdx) const;
+
+		void abortLoops(Array<LoopFrame>& loops) const;
+
+		//起点ノード
+		const Node& entryNode() const;
+
+	public:
+
+		/// <summary>
+		/// entryを起点とする実行計画を生成する
+		/// </summary>
+		/// <remarks>
+		/// SubgraphNodeは内部のノードに展開する(命令列には内部のノードだけが並ぶ)ので、entryには指定できない
+		/// </remarks>
+		/// <param name="previous">作り直す前の計画(中断しているノードを引き継ぐ)</param>
+		static std::shared_ptr<ExecutionPlan> Compile(Node& entry, const ExecutionPlan* previous = nullptr, const CompileOptions& options = {});
+
+		/// <summary>
+		/// 1回の実行で辿るノード数の上限を設定する(全ての計画で共通)
+		/// </summary>
+		/// <remarks>
+		/// 上限に達すると実行を中断し、その時点のノードにエラーを記録する(反復中のループは打ち切る)
+		/// </remarks>
+		static void SetStepLimit(size_t limit)
+		{
+			s_stepLimit = limit;
+		}
+
+		static size_t StepLimit()
+		{
+			return s_stepLimit;
+		}
+
+		/// <summary>
+		/// このスレッドで実行中の計画に渡されたスレッドプール(無ければnullptr)
+		/// </summary>
+		/// <remarks>
+		/// ノードのchildRunの中から、計画と同じプールで処理を分割するために使う
+		/// </remarks>
+		static ThreadPool* CurrentPool()
+		{
+			return t_currentPool;
+		}
+
+		/// <summary>
+		/// 生成後に接続が変更されていなければtrue
+		/// </summary>
+		bool isValid() const
+		{
+			return m_topologyVersion == ISocket::TopologyVersion();
+		}
+
+		/// <summary>
+		/// 起点ノードから実行する
+		/// </summary>
+		/// <param name="pool">
+		/// 指定した場合、ThreadSafeなノードは互いに依存していなければプール上で並列に評価される。
+		/// それ以外のノードと実行ソケットの順序は呼び出し元のスレッドで直列に処理される。
+		/// </param>
+		/// <remarks>
+		/// 1回の実行(パス)の中では入力の生成元は1度だけ評価され、
+		/// 以降はソケットに残った出力値が使われる。
+		/// ただしループのノードの反復ごとに、それ以降に実行するノードの入力の生成元は評価し直される。
+		/// </remarks>
+		void run(ThreadPool* pool = nullptr);
+
+		/// <summary>
+		/// budgetの時間だけ実行し、時間切れになったらノードの境界で止める
+		/// </summary>
+		/// <remarks>
+		/// 止めたパスは次に呼ばれたときに続きから実行する(パスが終わっていれば新しいパスを始める)。
+		/// 新しいパスを始めるときに中断しているノードがあれば、先にresumeと同じように再開し、
+		/// その続きを同じ時間枠の中で実行してから起点ノードからのパスを始める。
+		/// 時間切れでも1回の呼び出しで少なくとも1つのノードは評価する。
+		/// run()を呼ぶと実行中のパスは破棄される。
+		/// </remarks>
+		/// <returns>パスが最後まで終わったらtrue</returns>
+		bool runFor(const Duration& budget, ThreadPool* pool = nullptr);
+
+		/// <summary>
+		/// runForで実行中のパスがあればtrue
+		/// </summary>
+		bool inProgress() const
+		{
+			return m_inProgress;
+		}
+
+		/// <summary>
+		/// 中断しているノードを再開し、完了したものから次のノードを実行する
+		/// </summary>
+		/// <remarks>
+		/// 新しいパスとして実行する(入力の生成元は再び評価される)。
+		/// 中断中のノードに実行ソケットで再び到達した場合、そのノードは実行されない。
+		/// runForで実行中のパスがある間は何もしない。
+		/// </remarks>
+		void resume(ThreadPool* pool = nullptr);
+
+		/// <summary>
+		/// 中断しているノードの数
+		/// </summary>
+		size_t suspendedCount() const
+		{
+			return m_suspended.size();
+		}
+
+		Statistics statistics() const
+		{
+			return Statistics{ m_evaluated.load(), m_skipped.load(), m_steps, m_interrupted };
+		}
+
+		/// <summary>
+		/// 実行ソケットの接続が循環していればtrue
+		/// </summary>
+		/// <remarks>
+		/// 循環している計画は実行せず、循環に含まれるノードにNodeErrorCode::ExecCycleを記録する
+		/// </remarks>
+		bool hasCycle() const
+		{
+			return m_hasCycle;
+		}
+
+		size_t nodeCount() const
+		{
+			return m_nodes.size();
+		}
+
+		size_t instructionCount() const
+		{
+			return m_instructions.size();
+		}
+
+		/// <summary>
+		/// 定数として畳み込んだノードの数
+		/// </summary>
+		size_t foldedCount() const
+		{
+			return m_folded.size();
+		}
+
+		/// <summary>
+		/// 結果が使われないため実行しないノードの数
+		/// </summary>
+		size_t deadCount() const
+		{
+			return std::count(m_dead.begin(), m_dead.end(), true);
+		}
+
+		/// <summary>
+		/// 同じ関数・同じ入力の他のノードにまとめたため評価しないノードの数
+		/// </summary>
+		size_t mergedCount() const
+		{
+			return std::count_if(m_nodes.begin(), m_nodes.end(), [](const NodeEntry& entry) { return entry.merged; });
+		}
+	};
+}
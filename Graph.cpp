@@ -0,0 +1,414 @@
+#include"Graph.hpp"
+
+void NodeEditor::Graph::registerBuiltinNodes()
+{
+	registerNodeType<Builtin::AddNode>();
+	registerNodeType<Builtin::SubtractNode>();
+	registerNodeType<Builtin::MultiplyNode>();
+	registerNodeType<Builtin::DivideNode>();
+	registerNodeType<Builtin::LessNode>();
+	registerNodeType<Builtin::GreaterNode>();
+	registerNodeType<Builtin::EqualNode>();
+	registerNodeType<Builtin::ForNode>();
+	registerNodeType<Builtin::WhileNode>();
+	registerNodeType<Builtin::ForEachNode>();
+	registerNodeType<Builtin::ParallelForEachNode>();
+}
+
+void NodeEditor::Graph::addNode(std::shared_ptr<Node> node, const Vec2& pos)
+{
+	m_nodelist << node;
+	node->ID = m_nextId++;
+	node->Location = pos;
+	assignInnerIds(*node);
+}
+
+void NodeEditor::Graph::assignInnerIds(Node& node)
+{
+	//内部のノードは定義に保存されたIDで生成されるので、そのままでは全てのインスタンスで同じIDになる
+	if (const auto subgraph = dynamic_cast<SubgraphNode*>(&node))
+	{
+		for (const auto& inner : subgraph->m_nodes)
+		{
+			inner->ID = m_nextId++;
+			assignInnerIds(*inner);
+		}
+	}
+}
+
+Optional<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::addNode(const String& name, const Vec2& pos)
+{
+	auto inode = m_generator.getNode(name);
+	if (inode)
+	{
+		addNode(*inode, pos);
+	}
+	return inode;
+}
+
+Optional<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::addNode(const Type& type, const Vec2& pos)
+{
+	auto inode = m_generator.getNode(type);
+	if (inode)
+	{
+		addNode(*inode, pos);
+	}
+	return inode;
+}
+
+Optional<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::searchNode(size_t id)
+{
+	for (auto& node : m_nodelist)
+	{
+		if (node->ID == id)
+		{
+			return node;
+		}
+	}
+	return none;
+}
+
+Optional<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::searchNode(const String& className)
+{
+	for (auto& node : m_nodelist)
+	{
+		if (node->Class == className)
+		{
+			return node;
+		}
+	}
+	return none;
+}
+
+void NodeEditor::Graph::registerSubgraph(std::shared_ptr<const SubgraphDefinition> definition)
+{
+	for (const auto& subgraph : m_subgraphs)
+	{
+		if (subgraph->Name == definition->Name)
+		{
+			throw Error(U"サブグラフ\"{}\"は既に定義されています"_fmt(definition->Name));
+		}
+	}
+
+	//1度生成して、内部のノードの種類とポートが正しいことを確かめる
+	//(登録済みの定義だけを参照できるので、循環した定義もここで弾かれる)
+	SubgraphNode(definition, definition->instantiate(m_generator));
+
+	auto& generator = m_generator;
+	m_generator.registerGenerator(definition->className(), [definition, &generator]() -> std::shared_ptr<Node>
+		{
+			return std::make_shared<SubgraphNode>(definition, definition->instantiate(generator));
+		});
+	m_subgraphs << definition;
+}
+
+std::shared_ptr<NodeEditor::SubgraphNode> NodeEditor::Graph::collapse(const Array<std::shared_ptr<Node>>& nodes, const String& name)
+{
+	String definitionName = name;
+	for (size_t i = m_subgraphs.size() + 1; definitionName.isEmpty(); i++)
+	{
+		const auto candidate = U"Subgraph{}"_fmt(i);
+		if (!m_subgraphs.includes_if([&](const auto& subgraph) { return subgraph->Name == candidate; }))
+		{
+			definitionName = candidate;
+		}
+	}
+
+	const auto definition = SubgraphDefinition::Create(definitionName, nodes);
+	registerSubgraph(definition);
+
+	//最初のインスタンスはnodesをそのまま内部のノードにする(ノードの状態と参照を保つ)
+	const auto subgraph = std::make_shared<SubgraphNode>(definition, nodes);
+	subgraph->Class = definition->className();
+
+	std::unordered_map<size_t, std::shared_ptr<Node>> nodeById;
+	std::unordered_set<const Node*> inside;
+	Vec2 center(0, 0);
+	for (const auto& node : nodes)
+	{
+		nodeById.emplace(node->ID, node);
+		inside.emplace(node.get());
+		center += node->Location / static_cast<double>(nodes.size());
+	}
+
+	const auto outsideSockets = [&inside](const Array<std::shared_ptr<ISocket>>& sockets)
+	{
+		Array<std::shared_ptr<ISocket>> result;
+		for (const auto& socket : sockets)
+		{
+			if (inside.find(&socket->Parent) == inside.end())
+			{
+				result << socket;
+			}
+		}
+		return result;
+	};
+
+	//外とつながっていた接続をサブグラフのノードに付け替える
+	for (size_t i = 0; i < definition->Inputs.size(); i++)
+	{
+		const auto& socket = definition->Inputs[i].sockets.front();
+		ISocket::connect(subgraph->m_inputSockets[i], nodeById.at(socket.nodeID)->m_inputSockets[socket.socketIndex]->ConnectedSocket[0]);
+	}
+	for (size_t i = 0; i < definition->Outputs.size(); i++)
+	{
+		const auto& socket = definition->Outputs[i].sockets.front();
+		for (const auto& target : outsideSockets(nodeById.at(socket.nodeID)->m_outputSockets[socket.socketIndex]->ConnectedSocket))
+		{
+			ISocket::connect(subgraph->m_outputSockets[i], target);
+		}
+	}
+	for (size_t i = 0; i < definition->ExecInputs.size(); i++)
+	{
+		const auto& socket = definition->ExecInputs[i].sockets.front();
+		for (const auto& source : outsideSockets(nodeById.at(socket.nodeID)->m_prevNodeSockets[socket.socketIndex]->ConnectedSocket))
+		{
+			ISocket::connect(subgraph->m_prevNodeSockets[i], source);
+		}
+	}
+	for (size_t i = 0; i < definition->ExecOutputs.size(); i++)
+	{
+		const auto& socket = definition->ExecOutputs[i].sockets.front();
+		for (const auto& target : outsideSockets(nodeById.at(socket.nodeID)->m_nextNodeSockets[socket.socketIndex]->ConnectedSocket))
+		{
+			ISocket::connect(subgraph->m_nextNodeSockets[i], target);
+		}
+	}
+
+	//内部どうしの接続だけを残す
+	Array<std::pair<std::shared_ptr<ISocket>, std::shared_ptr<ISocket>>> innerConnections;
+	for (const auto& node : nodes)
+	{
+		for (const auto& inSocket : node->m_inputSockets)
+		{
+			if (inSocket->ConnectedSocket && inside.find(&inSocket->ConnectedSocket[0]->Parent) != inside.end())
+			{
+				innerConnections.emplace_back(inSocket, inSocket->ConnectedSocket[0]);
+			}
+		}
+		for (const auto& nextSocket : node->m_nextNodeSockets)
+		{
+			for (const auto& target : nextSocket->ConnectedSocket)
+			{
+				if (inside.find(&target->Parent) != inside.end())
+				{
+					innerConnections.emplace_back(nextSocket, target);
+				}
+			}
+		}
+	}
+	for (const auto& node : nodes)
+	{
+		node->disconnectAllSockets();
+	}
+	for (const auto& [from, to] : innerConnections)
+	{
+		ISocket::connect(from, to);
+	}
+	m_nodelist.remove_if([&inside](const std::shared_ptr<Node>& node) { return inside.find(node.get()) != inside.end(); });
+
+	addNode(subgraph, center);
+	return subgraph;
+}
+
+Array<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::expand(const std::shared_ptr<SubgraphNode>& node)
+{
+	//境界の接続を内部のノードに付け替える
+	for (size_t i = 0; i < node->m_inputTargets.size(); i++)
+	{
+		const auto& inSocket = node->m_inputSockets[i];
+		if (inSocket->ConnectedSocket)
+		{
+			const auto source = inSocket->ConnectedSocket[0];
+			for (const auto& target : node->m_inputTargets[i])
+			{
+				ISocket::connect(target, source);
+			}
+		}
+	}
+	for (size_t i = 0; i < node->m_outputSources.size(); i++)
+	{
+		//接続すると元の接続が切れて配列が変わるのでコピーする
+		const auto targets = node->m_outputSockets[i]->ConnectedSocket;
+		for (const auto& target : targets)
+		{
+			ISocket::connect(node->m_outputSources[i], target);
+		}
+	}
+	for (size_t i = 0; i < node->m_execEntries.size(); i++)
+	{
+		for (const auto& source : node->m_prevNodeSockets[i]->ConnectedSocket)
+		{
+			for (const auto& entry : node->m_execEntries[i])
+			{
+				ISocket::connect(source, entry);
+			}
+		}
+	}
+	for (size_t i = 0; i < node->m_execExits.size(); i++)
+	{
+		for (const auto& target : node->m_nextNodeSockets[i]->ConnectedSocket)
+		{
+			ISocket::connect(node->m_execExits[i], target);
+		}
+	}
+
+	node->disconnectAllSockets();
+	m_nodelist.remove(node);
+
+	//まとめる前の配置を保ったまま、左上をサブグラフのノードの位置に合わせる
+	Vec2 topLeft = node->m_nodes ? node->m_nodes.front()->Location : Vec2(0, 0);
+	for (const auto& inner : node->m_nodes)
+	{
+		topLeft = Vec2(Min(topLeft.x, inner->Location.x), Min(topLeft.y, inner->Location.y));
+	}
+	for (const auto& inner : node->m_nodes)
+	{
+		addNode(inner, inner->Location - topLeft + node->Location);
+	}
+
+	return node->m_nodes;
+}
+
+void NodeEditor::Graph::clear()
+{
+	m_nextId = 1;
+	m_nodelist.clear();
+
+	for (const auto& subgraph : m_subgraphs)
+	{
+		m_generator.unregister(subgraph->className());
+	}
+	m_subgraphs.clear();
+}
+
+String NodeEditor::Graph::save() const
+{
+	JSONWriter writer;
+
+	writer.startObject();
+	{
+		writer.key(U"subgraphs").startArray();
+		for (const auto& subgraph : m_subgraphs)
+		{
+			subgraph->serialize(writer);
+		}
+		writer.endArray();
+
+		writer.key(U"nodes").startArray();
+		for (const auto& node : m_nodelist)
+		{
+			node->serialize(writer);
+		}
+		writer.endArray();
+	}
+	writer.endObject();
+
+	return writer.get();
+}
+
+void NodeEditor::Graph::load(const JSONReader& json)
+{
+	clear();
+
+	//サブグラフは定義された順に保存されているので、先に定義されたものだけを内部で参照する
+	for (const auto& subgraphJson : json[U"subgraphs"].arrayView())
+	{
+		auto definition = std::make_shared<SubgraphDefinition>();
+		definition->deserialize(subgraphJson);
+		registerSubgraph(definition);
+	}
+
+	m_nodelist = m_generator.loadNodes(json[U"nodes"]);
+
+	for (const auto& node : m_nodelist)
+	{
+		//読み込んだ後に追加したノードのIDが重複しないようにする
+		m_nextId = Max(m_nextId, static_cast<uint32>(node->ID + 1));
+	}
+	for (const auto& node : m_nodelist)
+	{
+		assignInnerIds(*node);
+	}
+}
+
+Array<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::deadNodes(const Array<std::shared_ptr<Node>>& roots) const
+{
+	//起点が無ければグラフは実行されないので、実行を省略したノードも無い(組み立て中のグラフを全て暗くしない)
+	if (!roots)
+	{
+		return{};
+	}
+
+	//起点ノードから実行ソケットで到達できるノード
+	std::unordered_set<const Node*> reached;
+	Array<const Node*> stack;
+	for (const auto& root : roots)
+	{
+		if (reached.emplace(root.get()).second)
+		{
+			stack << root.get();
+		}
+	}
+	while (stack)
+	{
+		const auto node = stack.back();
+		stack.pop_back();
+		for (const auto& nextSocket : node->m_nextNodeSockets)
+		{
+			for (const auto& socket : nextSocket->ConnectedSocket)
+			{
+				if (reached.emplace(&socket->Parent).second)
+				{
+					stack << &socket->Parent;
+				}
+			}
+		}
+	}
+
+	//副作用のあるノードと起点ノードから入力の生成元を辿る(ExecutionPlanで実行を省略しないノード)
+	std::unordered_set<const Node*> live;
+	for (const auto node : reached)
+	{
+		if (!node->Pure || node->m_nextNodeSockets.size() > 1 || roots.includes_if([node](const auto& root) { return root.get() == node; }))
+		{
+			live.emplace(node);
+			stack << node;
+		}
+	}
+	while (stack)
+	{
+		const auto node = stack.back();
+		stack.pop_back();
+		for (const auto& inSocket : node->m_inputSockets)
+		{
+			if (inSocket->ConnectedSocket && live.emplace(&inSocket->ConnectedSocket[0]->Parent).second)
+			{
+				stack << &inSocket->ConnectedSocket[0]->Parent;
+			}
+		}
+	}
+
+	Array<std::shared_ptr<Node>> dead;
+	for (const auto& node : m_nodelist)
+	{
+		if (!live.contains(node.get()))
+		{
+			dead << node;
+		}
+	}
+	return dead;
+}
+
+Array<std::shared_ptr<NodeEditor::Node>> NodeEditor::Graph::deadNodes() const
+{
+	Array<std::shared_ptr<Node>> roots;
+	for (const auto& node : m_nodelist)
+	{
+		if (!node->m_prevNodeSockets && node->m_nextNodeSockets)
+		{
+			roots << node;
+		}
+	}
+	return deadNodes(roots);
+}
@@ -0,0 +1,188 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<unordered_set>
+#include"Node.hpp"
+#include"AsyncNode.hpp"
+#include"NodeSocket.hpp"
+#include"Bytecode.hpp"
+#include"BuiltinNodes.hpp"
+#include"InstanceSet.hpp"
+#include"LoopNode.hpp"
+#include"NodeGenerator.hpp"
+#include"SubgraphNode.hpp"
+
+namespace NodeEditor
+{
+	/// <summary>
+	/// ノードの一覧と登録されたノードの種類を持つグラフ
+	/// </summary>
+	/// <remarks>
+	/// 描画に関わるもの(Config、Font、Texture)には依存しないので、
+	/// NODEEDITOR_HEADLESSを定義してウィンドウの無い環境でもNodeEditor::saveで保存したグラフを読み込んで実行できる。
+	/// </remarks>
+	class Graph
+	{
+	private:
+
+		Array<std::shared_ptr<Node>> m_nodelist;
+
+		uint32 m_nextId = 1;
+
+		detail::NodeGenerator m_generator;
+
+		//登録した順(後の定義は前の定義を内部で参照できる)
+		Array<std::shared_ptr<const SubgraphDefinition>> m_subgraphs;
+
+		//サブグラフのノードの内部のノード(入れ子を含む)に、インスタンスごとに異なるIDを割り当てる
+		void assignInnerIds(Node& node);
+
+	public:
+
+		/// <summary>
+		/// ノードの種類を登録する
+		/// </summary>
+		/// <param name="options">生成したノードに適用する性質(指定しなければノードのコンストラクタの設定に従う)</param>
+		template<class NodeType>
+		void registerNodeType(const NodeOptions& options)
+		{
+			m_generator.registerType<NodeType>(options);
+		}
+
+		template<class NodeType>
+		void registerNodeType(bool visible = true)
+		{
+			registerNodeType<NodeType>(NodeOptions{ .visible = visible });
+		}
+
+		/// <summary>
+		/// 組み込みの算術/比較/ループのノードを登録する
+		/// </summary>
+		void registerBuiltinNodes();
+
+		/// <summary>
+		/// 関数をノードとして登録する
+		/// </summary>
+		/// <param name="function">FuncTypeの形で呼び出せる関数オブジェクト(ラムダ式などはstd::functionに変換せずに保持する)</param>
+		/// <param name="options">関数の性質(既定では副作用があるものとして毎回呼び出し、別スレッドからは呼ばない。入力だけから戻り値が決まる関数はpureを指定する)</param>
+		template<class FuncType, class Callable>
+		void registerNodeFunction(const String& name, const Array<String>& argNames, Callable function, const NodeOptions& options)
+		{
+			m_generator.registerFunction<FuncType, Callable>(name, argNames, function, options);
+		}
+
+		/// <param name="threadSafe">関数が他のノードと同時に別スレッドから呼ばれてもよい場合はtrue</param>
+		template<class FuncType, class Callable>
+		void registerNodeFunction(const String& name, const Array<String>& argNames, Callable function, bool threadSafe = false)
+		{
+			registerNodeFunction<FuncType, Callable>(name, argNames, function, NodeOptions{ .threadSafe = threadSafe });
+		}
+
+		/// <summary>
+		/// サブグラフの定義を"Subgraph::名前"のノードの種類として登録する
+		/// </summary>
+		/// <remarks>
+		/// 内部のノードの種類が登録されていない場合と、同じ名前の定義が登録済みの場合は例外を投げる
+		/// </remarks>
+		void registerSubgraph(std::shared_ptr<const SubgraphDefinition> definition);
+
+		/// <summary>
+		/// nodesをサブグラフの定義にまとめて登録し、nodesをそのサブグラフのノード1つに置き換える
+		/// </summary>
+		/// <remarks>
+		/// nodesは外との接続だけが切られて、置き換えたノードの内部のノードになる(IDは割り当て直される)。
+		/// nodesに種類が登録されていないノードがある場合は、グラフを変更せずに例外を投げる
+		/// </remarks>
+		/// <param name="name">定義の名前(空なら重複しない名前を付ける)</param>
+		/// <returns>nodesの代わりに追加したノード</returns>
+		std::shared_ptr<SubgraphNode> collapse(const Array<std::shared_ptr<Node>>& nodes, const String& name = U"");
+
+		/// <summary>
+		/// サブグラフのノードを内部のノードに置き換える(定義は登録されたまま残る)
+		/// </summary>
+		/// <returns>追加した内部のノード</returns>
+		Array<std::shared_ptr<Node>> expand(const std::shared_ptr<SubgraphNode>& node);
+
+		const Array<std::shared_ptr<const SubgraphDefinition>>& subgraphs() const
+		{
+			return m_subgraphs;
+		}
+
+		/// <summary>
+		/// entryを起点とするグラフをレジスタマシン用の命令列に変換する
+		/// </summary>
+		/// <remarks>
+		/// 命令列はこのグラフの関数テーブルを参照するので、グラフより長く使わないこと。
+		/// </remarks>
+		std::shared_ptr<Bytecode> compile(Node& entry) const
+		{
+			return Bytecode::Compile(entry, m_generator.functions);
+		}
+
+		void addNode(std::shared_ptr<Node> node, const Vec2& pos = Vec2(0, 0));
+
+		template<class NodeType>
+		Optional<std::shared_ptr<NodeType>> addNode(const Vec2& pos = Vec2(0, 0))
+		{
+			auto result = addNode(Type::getType<NodeType>(), pos);
+			if (result)
+			{
+				return std::dynamic_pointer_cast<NodeType>(*result);
+			}
+			else
+			{
+				return none;
+			}
+		}
+
+		Optional<std::shared_ptr<Node>> addNode(const String& name, const Vec2& pos = Vec2(0, 0));
+
+		Optional<std::shared_ptr<Node>> addNode(const Type& type, const Vec2& pos = Vec2(0, 0));
+
+		Optional<std::shared_ptr<Node>> searchNode(size_t id);
+
+		Optional<std::shared_ptr<Node>> searchNode(const String& className);
+
+		void clear();
+
+		String save() const;
+
+		/// <summary>
+		/// saveで保存したグラフを読み込む
+		/// </summary>
+		/// <remarks>
+		/// 保存されたノードの種類が登録されていない場合は例外を投げる
+		/// </remarks>
+		void load(const JSONReader& json);
+
+		/// <summary>
+		/// 起点ノードから実行しても実行されないノードを求める
+		/// </summary>
+		/// <remarks>
+		/// 起点ノードから実行ソケットで到達できないノードと、その入力の生成元にもならないノードに加え、
+		/// 到達できても出力がどこにも使われないPureなノード(ExecutionPlanで実行を省略するもの)を含む。
+		/// pureを指定せずに登録した関数のノードは副作用があるものとして扱い、出力が使われなくても含まない。
+		/// rootsが空なら何も含まない
+		/// </remarks>
+		Array<std::shared_ptr<Node>> deadNodes(const Array<std::shared_ptr<Node>>& roots) const;
+
+		/// <summary>
+		/// 前の実行ソケットを持たず、次の実行ソケットを持つノードを全て起点としてdeadNodesを求める
+		/// </summary>
+		Array<std::shared_ptr<Node>> deadNodes() const;
+
+		Array<std::shared_ptr<Node>>& nodes()
+		{
+			return m_nodelist;
+		}
+
+		const Array<std::shared_ptr<Node>>& nodes() const
+		{
+			return m_nodelist;
+		}
+
+		const detail::NodeGenerator& generator() const
+		{
+			return m_generator;
+		}
+	};
+}
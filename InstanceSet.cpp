@@ -0,0 +1,81 @@
+#include"InstanceSet.hpp"
+#include"Node.hpp"
+
+NodeEditor::InstanceSet::InstanceSet(std::shared_ptr<const Bytecode> code, size_t count)
+	:m_code(std::move(code))
+{
+	m_context.nodePass.resize(m_code->m_context.nodePass.size(), 0);
+	resize(count);
+}
+
+void NodeEditor::InstanceSet::resize(size_t count)
+{
+	const auto stateCount = m_code->stateCount();
+
+	m_registers.resize(count * m_code->registerCount());
+	m_states.resize(count * stateCount);
+	m_errors.resize(count);
+
+	for (size_t i = m_count; i < count; i++)
+	{
+		m_code->saveStates(m_states.data() + i * stateCount);
+	}
+	m_count = count;
+}
+
+void NodeEditor::InstanceSet::run()
+{
+	bool interrupted = false;
+	for (size_t i = 0; i < m_count; i++)
+	{
+		run(i);
+		interrupted = interrupted || m_interrupted;
+	}
+	m_interrupted = interrupted;
+}
+
+void NodeEditor::InstanceSet::run(size_t instance)
+{
+	m_context.registers = m_registers.data() + instance * m_code->registerCount();
+	m_context.states = m_states.data() + instance * m_code->stateCount();
+
+	m_code->run(m_context);
+
+	m_interrupted = m_context.interrupted;
+
+	//ノードのエラーは次のインスタンスの実行で上書きされるので、インスタンスごとに控えておく
+	m_errors[instance].clear();
+	m_code->collectErrors(m_context, m_errors[instance]);
+}
+
+const NodeEditor::ValueSlot* NodeEditor::InstanceSet::value(size_t instance, const ValueSocket& output) const
+{
+	const auto itr = m_code->m_registerIndex.find(&output);
+	if (itr == m_code->m_registerIndex.end())
+	{
+		return nullptr;
+	}
+	return &m_registers[instance * m_code->registerCount() + itr->second];
+}
+
+NodeEditor::NodeError NodeEditor::InstanceSet::error(size_t instance, const Node& node) const
+{
+	for (const auto& [failed, error] : m_errors[instance])
+	{
+		if (failed == &node)
+		{
+			return error;
+		}
+	}
+	return NodeError();
+}
+
+NodeEditor::ValueSlot& NodeEditor::InstanceSet::state(size_t instance, const Node& node)
+{
+	const auto idx = m_code->stateIndex(node);
+	if (idx == Bytecode::InvalidRegister)
+	{
+		throw Error(U"ノード\"{}\"はインスタンスごとの状態を持っていません"_fmt(node.Name));
+	}
+	return m_states[instance * m_code->stateCount() + idx];
+}
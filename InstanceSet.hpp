@@ -0,0 +1,113 @@
+#pragma once
+#include<Siv3D.hpp>
+#include"Bytecode.hpp"
+#include"Node.hpp"
+#include"ValueSlot.hpp"
+
+namespace NodeEditor
+{
+	/// <summary>
+	/// 1つの命令列を共有して実行するインスタンスの集まり
+	/// </summary>
+	/// <remarks>
+	/// 各インスタンスはレジスタ(出力ソケットの値)とInstanceStateなノードの状態だけを持ち、
+	/// ノードやソケットは命令列の生成元のものを使い回す。
+	/// レジスタと状態はインスタンスの順に連続して並び、run()はインスタンスを順に実行する。
+	/// ノードに記録されるエラーは最後に実行したインスタンスのものなので、インスタンスごとのエラーはerrorで取得する。
+	/// </remarks>
+	class InstanceSet
+	{
+	private:
+
+		std::shared_ptr<const Bytecode> m_code;
+
+		size_t m_count = 0;
+
+		//インスタンスiのレジスタは[i * registerCount, (i + 1) * registerCount)
+		Array<ValueSlot> m_registers;
+
+		//インスタンスiの状態は[i * stateCount, (i + 1) * stateCount)
+		Array<ValueSlot> m_states;
+
+		//インスタンスごとの、直前の実行でエラーを記録したノードとそのエラー
+		Array<Array<std::pair<const Node*, NodeError>>> m_errors;
+
+		Bytecode::Context m_context;
+
+		bool m_interrupted = false;
+
+	public:
+
+		/// <param name="code">共有する命令列</param>
+		/// <param name="count">インスタンスの数</param>
+		explicit InstanceSet(std::shared_ptr<const Bytecode> code, size_t count = 0);
+
+		/// <summary>
+		/// インスタンスの数を変更する
+		/// </summary>
+		/// <remarks>
+		/// 追加されたインスタンスの状態はその時点のノードの状態で初期化される
+		/// </remarks>
+		void resize(size_t count);
+
+		size_t size() const
+		{
+			return m_count;
+		}
+
+		/// <summary>
+		/// 命令列の生成後に接続が変更されていなければtrue
+		/// </summary>
+		bool isValid() const
+		{
+			return m_code->isValid();
+		}
+
+		/// <summary>
+		/// 全てのインスタンスを順に実行する
+		/// </summary>
+		void run();
+
+		/// <summary>
+		/// instance番目のインスタンスを実行する
+		/// </summary>
+		void run(size_t instance);
+
+		/// <summary>
+		/// instance番目のインスタンスの出力ソケットの値(命令列に含まれない場合はnullptr)
+		/// </summary>
+		const ValueSlot* value(size_t instance, const ValueSocket& output) const;
+
+		/// <summary>
+		/// instance番目のインスタンスでのnodeの状態
+		/// </summary>
+		/// <remarks>
+		/// nodeがInstanceStateなノードとして命令列に含まれていない場合は例外を投げる
+		/// </remarks>
+		ValueSlot& state(size_t instance, const Node& node);
+
+		/// <summary>
+		/// 直前の実行でinstance番目のインスタンスのnodeに記録されたエラー
+		/// </summary>
+		/// <remarks>
+		/// エラーが無いか、そのインスタンスでnodeが評価されなかった場合はNodeErrorCode::None
+		/// </remarks>
+		NodeError error(size_t instance, const Node& node) const;
+
+		/// <summary>
+		/// 直前の実行でinstance番目のインスタンスのいずれかのノードがエラーを記録していればtrue
+		/// </summary>
+		bool failed(size_t instance) const
+		{
+			return !m_errors[instance].isEmpty();
+		}
+
+		/// <summary>
+		/// 直前の実行でステップ数の上限に達したインスタンスがあればtrue
+		/// </summary>
+		bool interrupted() const
+		{
+			return m_interrupted;
+		}
+	};
+}
@@ -0,0 +1,386 @@
+#include"LoopNode.hpp"
+
+void NodeEditor::LoopNode::childRun()
+{
+	if (!m_looping)
+	{
+		beginLoop();
+	}
+
+	m_looping = nextLoop();
+	NextExecIdx = m_looping ? 0 : 1;
+}
+
+NodeEditor::Builtin::ForNode::ForNode()
+{
+	Name = U"For";
+	cfgInputSockets({ {Type::getType<int32>(),U"first"},{Type::getType<int32>(),U"last"} });
+	cfgOutputSockets({ {Type::getType<int32>(),U"index"} });
+}
+
+void NodeEditor::Builtin::ForNode::beginLoop()
+{
+	m_index = getInput<int32>(0);
+	m_last = getInput<int32>(1);
+	setOutput(0, m_index);
+}
+
+bool NodeEditor::Builtin::ForNode::nextLoop()
+{
+	if (m_index >= m_last)
+	{
+		return false;
+	}
+	setOutput(0, m_index++);
+	return true;
+}
+
+NodeEditor::Builtin::WhileNode::WhileNode()
+{
+	Name = U"While";
+	cfgInputSockets({ {Type::getType<bool>(),U"condition"} });
+	cfgOutputSockets({ {Type::getType<int32>(),U"index"} });
+}
+
+void NodeEditor::Builtin::WhileNode::beginLoop()
+{
+	m_index = 0;
+	setOutput(0, m_index);
+}
+
+bool NodeEditor::Builtin::WhileNode::nextLoop()
+{
+	if (!getInput<bool>(0))
+	{
+		return false;
+	}
+	setOutput(0, m_index++);
+	return true;
+}
+
+NodeEditor::Builtin::ForEachNode::ForEachNode()
+{
+	Name = U"ForEach";
+	cfgInputSockets({ {Type::getType<Array<double>>(),U"array"} });
+	cfgOutputSockets({ {Type::getType<double>(),U"element"},{Type::getType<int32>(),U"index"} });
+}
+
+void NodeEditor::Builtin::ForEachNode::beginLoop()
+{
+	//前回の領域を使い回す
+	const auto& elements = getInput<Array<double>>(0);
+	m_elements.assign(elements.begin(), elements.end());
+	m_index = 0;
+	setOutput(0, 0.0);
+	setOutput<int32>(1, 0);
+}
+
+bool NodeEditor::Builtin::ForEachNode::nextLoop()
+{
+	if (m_index >= m_elements.size())
+	{
+		return false;
+	}
+	setOutput(0, m_elements[m_index]);
+	setOutput(1, static_cast<int32>(m_index));
+	m_index++;
+	return true;
+}
+
+NodeEditor::Builtin::ParallelForEachNode::ParallelForEachNode()
+{
+	Name = U"ParallelForEach";
+	EvaluatesBody = true;
+	cfgInputSockets({ {Type::getType<Array<double>>(),U"array"},{Type::getType<double>(),U"result"} });
+	cfgOutputSockets({ {Type::getType<double>(),U"element"},{Type::getType<int32>(),U"index"},{Type::getType<Array<double>>(),U"results"} });
+}
+
+bool NodeEditor::Builtin::ParallelForEachNode::bodyError(NodeErrorCode code, const Node* node, size_t socketIdx)
+{
+	m_bodyError.code = code;
+	m_bodyError.socketIdx = socketIdx;
+	m_bodyError.message = node ? node->Name : U"";
+	return false;
+}
+
+bool NodeEditor::Builtin::ParallelForEachNode::compileBody()
+{
+	struct Frame
+	{
+		const Node* node;
+		size_t inputIdx;
+	};
+
+	//ノードごとの最初の出力ソケットのレジスタ(本体の外のノードはInvalidRegister、未確定のノードは含まない)
+	std::unordered_map<const Node*, uint32> registers;
+	std::unordered_map<const Node*, bool> visited;
+	Array<Frame> stack;
+
+	m_code.clear();
+	m_operands.clear();
+	m_registerCount = 2;
+	m_threadSafe = true;
+	m_bodyError = NodeError();
+
+	const auto sourceOf = [](const ValueSocket& inSocket) -> const ValueSocket*
+	{
+		return inSocket.ConnectedSocket ? dynamic_cast<const ValueSocket*>(inSocket.ConnectedSocket[0].get()) : nullptr;
+	};
+
+	//resultsは本体の評価が終わってから出力するので、本体からは参照できない
+	const auto refersResults = [this](const ValueSocket& source)
+	{
+		return &source.Parent == this && source.Index > IndexRegister;
+	};
+
+	const auto operandOf = [&](const ValueSocket& source)
+	{
+		if (&source.Parent == this)
+		{
+			return Operand{ static_cast<uint32>(source.Index), nullptr };
+		}
+		const auto reg = registers.at(&source.Parent);
+		return reg != InvalidRegister ? Operand{ reg + static_cast<uint32>(source.Index), nullptr } : Operand{ InvalidRegister, &source };
+	};
+
+	const auto result = sourceOf(*m_inputSockets[1]);
+	if (!result)
+	{
+		return bodyError(NodeErrorCode::InputNotConnected, nullptr, 1);
+	}
+	if (refersResults(*result))
+	{
+		return bodyError(NodeErrorCode::BodyCycle);
+	}
+
+	if (&result->Parent != this)
+	{
+		visited.emplace(&result->Parent, false);
+		stack << Frame{ &result->Parent, 0 };
+	}
+
+	while (stack)
+	{
+		auto& frame = stack.back();
+		const auto& inputs = frame.node->m_inputSockets;
+
+		if (frame.inputIdx < inputs.size())
+		{
+			const auto source = sourceOf(*inputs[frame.inputIdx++]);
+			if (!source)
+			{
+				return bodyError(NodeErrorCode::BodyNotConnected, frame.node);
+			}
+			if (refersResults(*source))
+			{
+				return bodyError(NodeErrorCode::BodyCycle);
+			}
+			if (&source->Parent != this)
+			{
+				const auto [itr, inserted] = visited.emplace(&source->Parent, false);
+				if (inserted)
+				{
+					stack << Frame{ &source->Parent, 0 };
+				}
+				else if (!itr->second)
+				{
+					return bodyError(NodeErrorCode::BodyCycle);
+				}
+			}
+		}
+		else
+		{
+			const auto node = frame.node;
+			visited[node] = true;
+			stack.pop_back();
+
+			//このノードの出力に依存するノードだけを本体として命令列に加える
+			bool variant = false;
+			for (const auto& inSocket : inputs)
+			{
+				const auto source = sourceOf(*inSocket);
+				variant = variant || &source->Parent == this || registers.at(&source->Parent) != InvalidRegister;
+			}
+
+			if (!variant)
+			{
+				registers.emplace(node, InvalidRegister);
+				continue;
+			}
+
+			const Instruction instruction{ node, static_cast<uint32>(m_operands.size()), m_registerCount };
+			for (const auto& inSocket : inputs)
+			{
+				m_operands << operandOf(*sourceOf(*inSocket));
+			}
+			registers.emplace(node, m_registerCount);
+			m_registerCount += static_cast<uint32>(node->m_outputSockets.size());
+			m_threadSafe = m_threadSafe && node->ThreadSafe;
+			m_code << instruction;
+		}
+	}
+
+	m_result = operandOf(*result);
+	return true;
+}
+
+void NodeEditor::Builtin::ParallelForEachNode::prepare(Worker& worker)
+{
+	worker.registers.resize(m_registerCount);
+	worker.operands.resize(m_operands.size());
+	for (size_t i = 0; i < m_operands.size(); i++)
+	{
+		const auto& operand = m_operands[i];
+		worker.operands[i] = operand.socket ? &operand.socket->value() : &worker.registers[operand.reg];
+	}
+	worker.result = m_result.socket ? &m_result.socket->value() : &worker.registers[m_result.reg];
+	worker.unsupported = nullptr;
+	worker.exception = nullptr;
+}
+
+void NodeEditor::Builtin::ParallelForEachNode::runRange(Worker& worker, const Array<double>& elements, size_t begin, size_t end)
+{
+	try
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			worker.registers[ElementRegister].set(elements[i]);
+			worker.registers[IndexRegister].set(static_cast<int32>(i));
+
+			for (const auto& instruction : m_code)
+			{
+				if (!instruction.node->childRunSlots(worker.operands.data() + instruction.operandBegin, worker.registers.data() + instruction.result))
+				{
+					worker.unsupported = instruction.node;
+					return;
+				}
+			}
+
+			m_results[i] = worker.result->get<double>();
+		}
+	}
+	catch (...)
+	{
+		worker.exception = std::current_exception();
+	}
+}
+
+void NodeEditor::Builtin::ParallelForEachNode::childRun()
+{
+	//変換に失敗した場合も、接続が変更されるまでは同じ結果になるので変換し直さない
+	if (m_topologyVersion != ISocket::TopologyVersion())
+	{
+		compileBody();
+		m_topologyVersion = ISocket::TopologyVersion();
+	}
+
+	if (m_bodyError)
+	{
+		m_error.message = m_bodyError.message;
+		setError(m_bodyError.code, m_bodyError.socketIdx);
+		return;
+	}
+
+	for (size_t i = 0; i < m_operands.size(); i++)
+	{
+		const auto& operand = m_operands[i];
+		if (operand.socket && !operand.socket->hasValue())
+		{
+			//値を受け取る本体のノードを記録する
+			const auto consumer = std::find_if(m_code.begin(), m_code.end(), [i](const Instruction& instruction)
+				{
+					return instruction.operandBegin <= i && i < instruction.operandBegin + instruction.node->m_inputSockets.size();
+				});
+			m_error.message = consumer->node->Name;
+			setError(NodeErrorCode::BodyNotConnected);
+			return;
+		}
+	}
+
+	const auto& elements = getInput<Array<double>>(0);
+	const auto count = elements.size();
+
+	//要素の少ない分割を作らないよう、分割数は要素数までにする
+	const auto pool = ExecutionPlan::CurrentPool();
+	const size_t chunkCount = Min<size_t>(pool && m_threadSafe ? pool->threadCount() + 1 : 1, Max<size_t>(count, 1));
+
+	m_results.resize(count);
+	if (m_workers.size() < chunkCount)
+	{
+		m_workers.resize(chunkCount);
+	}
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		prepare(m_workers[i]);
+	}
+
+	const auto chunkRange = [&](size_t chunk)
+	{
+		return std::make_pair(count * chunk / chunkCount, count * (chunk + 1) / chunkCount);
+	};
+
+	if (chunkCount == 1)
+	{
+		runRange(m_workers[0], elements, 0, count);
+	}
+	else
+	{
+		//呼び出したスレッドも分割を取り出して評価するので、プールのワーカーから呼ばれても待ち続けない
+		struct Shared
+		{
+			std::atomic<size_t> next = 0;
+			std::mutex mutex;
+			std::condition_variable cv;
+			size_t remaining;
+		};
+
+		const auto shared = std::make_shared<Shared>();
+		shared->remaining = chunkCount;
+
+		const auto runChunks = [this, shared, &elements, chunkRange, chunkCount]()
+		{
+			for (size_t chunk; (chunk = shared->next++) < chunkCount;)
+			{
+				const auto [begin, end] = chunkRange(chunk);
+				runRange(m_workers[chunk], elements, begin, end);
+
+				std::lock_guard lock(shared->mutex);
+				if (--shared->remaining == 0)
+				{
+					shared->cv.notify_one();
+				}
+			}
+		};
+
+		//タスクが開始されたときには全ての分割が取り出し済みの場合がある(その場合はsharedだけを参照して終わる)
+		for (size_t i = 1; i < chunkCount; i++)
+		{
+			pool->submit(runChunks);
+		}
+		runChunks();
+
+		std::unique_lock lock(shared->mutex);
+		shared->cv.wait(lock, [&] { return shared->remaining == 0; });
+	}
+
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		const auto& worker = m_workers[i];
+		if (worker.exception)
+		{
+			std::rethrow_exception(worker.exception);
+		}
+		//対応しているかはノードの種類で決まるので、接続が変更されるまで評価し直さない
+		if (worker.unsupported)
+		{
+			bodyError(NodeErrorCode::BodyUnsupported, worker.unsupported);
+			m_error.message = m_bodyError.message;
+			setError(m_bodyError.code);
+			return;
+		}
+	}
+
+	setOutput(0, count ? elements.back() : 0.0);
+	setOutput<int32>(1, count ? static_cast<int32>(count - 1) : 0);
+	setOutput(2, m_results);
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<condition_variable>
+#include<exception>
+#include<mutex>
+#include"Node.hpp"
+
+namespace NodeEditor
+{
+	/// <summary>
+	/// 本体の実行ソケットの先を繰り返し実行するノード
+	/// </summary>
+	/// <remarks>
+	/// 次の実行ソケットの0番目が本体、1番目が完了後の処理。
+	/// 反復は実行計画(ExecutionPlan、Bytecode)がスタックで進めるので、回数が多くても再帰しない。
+	/// 本体の入力の生成元は反復ごとに評価し直される(Pureなノードは入力が変化していなければ省略される)。
+	/// 反復で辿ったノードは1回の実行のステップ数に数えられ、ExecutionPlan::StepLimitを超えると打ち切ってエラーを記録する
+	/// (本体が1ノードなら、1回の反復でループのノードと合わせて2ステップ)。
+	/// </remarks>
+	class LoopNode : public Node
+	{
+	private:
+
+		bool m_looping = false;
+
+		void childRun() override;
+
+		bool looping() const override
+		{
+			return m_looping;
+		}
+
+		void abortLoop() override
+		{
+			m_looping = false;
+		}
+
+	protected:
+
+		/// <summary>
+		/// 反復を始める(入力から反復の範囲を読み取る)
+		/// </summary>
+		/// <remarks>
+		/// 1度も反復しない場合にも出力があるよう、出力ソケットに初期値を設定すること
+		/// </remarks>
+		virtual void beginLoop() = 0;
+
+		/// <summary>
+		/// 次の反復に進む
+		/// </summary>
+		/// <returns>本体を実行するならtrue(出力ソケットに今回の値を設定すること)</returns>
+		virtual bool nextLoop() = 0;
+
+		LoopNode()
+		{
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"body",U"completed" });
+		}
+	};
+
+	namespace Builtin
+	{
+		/// <summary>
+		/// indexをfirstからlastの手前まで1ずつ増やしながら本体を実行する
+		/// </summary>
+		class ForNode : public LoopNode
+		{
+		private:
+
+			int32 m_index = 0;
+
+			int32 m_last = 0;
+
+			void beginLoop() override;
+
+			bool nextLoop() override;
+
+		public:
+
+			ForNode();
+		};
+
+		/// <summary>
+		/// conditionがtrueの間、本体を実行する(conditionは反復ごとに評価し直される)
+		/// </summary>
+		class WhileNode : public LoopNode
+		{
+		private:
+
+			int32 m_index = 0;
+
+			void beginLoop() override;
+
+			bool nextLoop() override;
+
+		public:
+
+			WhileNode();
+		};
+
+		/// <summary>
+		/// 配列の要素ごとに本体を実行する
+		/// </summary>
+		/// <remarks>
+		/// 配列は反復を始めたときにコピーする(本体の実行で入力が変化しても影響しない)
+		/// </remarks>
+		class ForEachNode : public LoopNode
+		{
+		private:
+
+			Array<double> m_elements;
+
+			size_t m_index = 0;
+
+			void beginLoop() override;
+
+			bool nextLoop() override;
+
+		public:
+
+			ForEachNode();
+		};
+
+		/// <summary>
+		/// 配列の要素ごとに本体を評価し、resultの値を要素の順に集めてresultsに出力する
+		/// </summary>
+		/// <remarks>
+		/// 本体はresultの生成元のうちelementかindexに依存するノードで、それ以外の生成元は実行計画が先に1度だけ評価する。
+		/// 本体は接続が変更されたときだけ命令列に変換し、要素はワーカーごとのレジスタでNode::childRunSlotsを呼んで評価する
+		/// (登録した関数と組み込みの算術/比較ノードは対応している)。
+		/// 実行計画にスレッドプールが渡されていて、本体のノードが全てThreadSafeなら要素を分割して並列に評価する。
+		/// ExecutionPlanで実行するノードとして使う(Bytecode、Batchでは本体を評価できない)。
+		/// 要素とresultの型はForEachNodeと同じdoubleのみ(arrayはArray&lt;double&gt;、resultsもArray&lt;double&gt;)。
+		/// 本体の接続の誤りはNodeErrorCode::Body*として記録し、接続が変更されるまで変換し直さない。
+		/// </remarks>
+		class ParallelForEachNode : public Node
+		{
+		private:
+
+			static constexpr uint32 ElementRegister = 0;
+
+			static constexpr uint32 IndexRegister = 1;
+
+			static constexpr uint32 InvalidRegister = UINT32_MAX;
+
+			struct Instruction
+			{
+				const Node* node;
+				//m_operandsの先頭(入力ソケットの数だけ続く)
+				uint32 operandBegin;
+				//最初の出力ソケットのレジスタ(出力ソケットの数だけ続く)
+				uint32 result;
+			};
+
+			//本体のレジスタ、または本体の外の出力ソケット
+			struct Operand
+			{
+				uint32 reg;
+				const ValueSocket* socket;
+			};
+
+			//ワーカーごとの値の領域
+			struct Worker
+			{
+				Array<ValueSlot> registers;
+
+				//m_operandsと同じ並び
+				Array<const ValueSlot*> operands;
+
+				const ValueSlot* result;
+
+				//childRunSlotsに対応していなかった本体のノード
+				const Node* unsupported;
+
+				std::exception_ptr exception;
+			};
+
+			//本体を変換したときのISocket::TopologyVersion
+			uint64 m_topologyVersion = 0;
+
+			//本体を変換できなかった理由(接続が変更されるまで毎回記録する)
+			NodeError m_bodyError;
+
+			Array<Instruction> m_code;
+
+			Array<Operand> m_operands;
+
+			Operand m_result;
+
+			uint32 m_registerCount = 0;
+
+			//本体のノードが全てThreadSafeならtrue
+			bool m_threadSafe = true;
+
+			Array<Worker> m_workers;
+
+			Array<double> m_results;
+
+			//本体を命令列に変換する(変換できなければm_bodyErrorに理由を記録してfalseを返す)
+			bool compileBody();
+
+			bool bodyError(NodeErrorCode code, const Node* node = nullptr, size_t socketIdx = 0);
+
+			void prepare(Worker& worker);
+
+			void runRange(Worker& worker, const Array<double>& elements, size_t begin, size_t end);
+
+			void childRun() override;
+
+		public:
+
+			ParallelForEachNode();
+		};
+	}
+}
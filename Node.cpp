@@ -1,5 +1,6 @@
 #include "Node.hpp"
 
+#ifndef NODEEDITOR_HEADLESS
 Triangle EquilateralTriangle(const Vec2& center, const double& r, const double& theta)
 {
 	return Triangle(Circular(r, theta), Circular(r, theta + 120_deg), Circular(r, theta + 240_deg))
@@ -62,6 +63,7 @@ void NodeEditor::Node::calcRect(const Config& cfg)
 
 void NodeEditor::Node::drawBackground(const Config& cfg)
 {
+	double hue = m_backHue;
 	double s = 0;
 
 	const auto& roundRect = m_rect.rounded(cfg.RectR);
@@ -71,8 +73,18 @@ void NodeEditor::Node::drawBackground(const Config& cfg)
 		s = (1 - m_backColStw.elapsed() / 1s) * 0.8;
 	}
 
+#ifdef NODEEDITOR_PROFILE
+	//平均の実行時間に応じた色(1µs以下は緑、1ms以上は赤)
+	if (cfg.ShowProfile && m_profile.calls)
+	{
+		const double heat = Clamp((std::log10(Max(m_profile.averageNs(), 1.0)) - 3.0) / 3.0, 0.0, 1.0);
+		hue = 120 * (1 - heat);
+		s = 0.8;
+	}
+#endif
+
 	//四角の描画
-	roundRect.draw(HSV(m_backHue, s, 0.7));
+	roundRect.draw(HSV(hue, s, 0.7));
 	if (Selecting)
 	{
 		roundRect.drawFrame(0, 2, Palette::Orange);
@@ -88,6 +100,12 @@ void NodeEditor::Node::setBackCol(const double hue)
 	m_backColStw.restart();
 	m_backHue = hue;
 }
+#else
+void NodeEditor::Node::setBackCol(const double)
+{
+
+}
+#endif
 
 void NodeEditor::Node::cfgInputSockets(Array<std::pair<Type, String>> cfg)
 {
@@ -125,48 +143,201 @@ void NodeEditor::Node::cfgNextExecSocket(const Array<String>& names)
 	}
 }
 
-void NodeEditor::Node::run()
+bool NodeEditor::Node::execute(const ValueSocket* const* sources)
 {
-	m_errorMsg.reset();
-	try
+	m_error = NodeError();
+
+	for (size_t i = 0; i < m_inputSockets.size(); i++)
 	{
-		for (auto& inSocket : m_inputSockets)
+		if (!sources[i])
 		{
-			if (!inSocket->ConnectedSocket)
-			{
-				throw Error(U"ノード名:\"{}\", \"入力ソケット:\"{}\"のノードが指定されていません"_fmt(Name, inSocket->Name));
-			}
-			inSocket->ConnectedSocket[0]->Parent.run();
-			inSocket->setValue(dynamic_pointer_cast<ValueSocket>(inSocket->ConnectedSocket[0])->value());
+			return setError(NodeErrorCode::InputNotConnected, i);
 		}
+		m_inputSockets[i]->bind(*sources[i]);
+	}
 
-		setBackCol(220);
+	return runChild();
+}
+
+bool NodeEditor::Node::runChild()
+{
+	setBackCol(220);
+	try
+	{
+		const detail::TraceScope trace(Trace::Category::Node, *this);
+		NODEEDITOR_PROFILE_SCOPE(m_profile);
 		childRun();
+	}
+	catch (Error& ex)
+	{
+		m_error.message = ex.what();
+		return setError(NodeErrorCode::Exception);
+	}
+	catch (std::exception& ex)
+	{
+		m_error.message = Unicode::FromUTF8(ex.what());
+		return setError(NodeErrorCode::Exception);
+	}
+
+	//childRunの中でsetErrorしたエラーを出力の確認で上書きしない
+	if (m_error)
+	{
+		return false;
+	}
+
+	//中断した場合は再開して完了したときに出力を確認する
+	if (suspended())
+	{
+		return true;
+	}
+
+	return checkOutputs();
+}
+
+bool NodeEditor::Node::resumeRun()
+{
+	try
+	{
+		const detail::TraceScope trace(Trace::Category::Node, *this);
+		NODEEDITOR_PROFILE_SCOPE(m_profile);
+		resumeChild();
+	}
+	catch (Error& ex)
+	{
+		m_error.message = ex.what();
+		return setError(NodeErrorCode::Exception);
+	}
+	catch (std::exception& ex)
+	{
+		//Async::Backgroundの関数などから送出された標準の例外
+		m_error.message = Unicode::FromUTF8(ex.what());
+		return setError(NodeErrorCode::Exception);
+	}
+
+	if (suspended())
+	{
+		return true;
+	}
+
+	setBackCol(220);
+	return checkOutputs();
+}
 
-		for (auto& outSocket : m_outputSockets)
+bool NodeEditor::Node::checkOutputs()
+{
+	for (size_t i = 0; i < m_outputSockets.size(); i++)
+	{
+		if (!m_outputSockets[i]->hasValue())
 		{
-			if (!outSocket->value().has_value())
-			{
-				throw Error(U"ノード名:\"{}\", \"出力ソケット:\"{}\"の出力が指定されていません"_fmt(Name, outSocket->Name));
-			}
+			return setError(NodeErrorCode::OutputNotSet, i);
 		}
+	}
+
+	m_outputValid = true;
+	return true;
+}
+
+bool NodeEditor::Node::setError(NodeErrorCode code, size_t socketIdx)
+{
+	setBackCol(20);
+	m_error.code = code;
+	m_error.socketIdx = socketIdx;
+	m_outputValid = false;
+
+	//毎回同じエラーになる場合はメッセージを作り直さない
+	if (m_error.code != m_errorTextSource.code || m_error.socketIdx != m_errorTextSource.socketIdx || m_error.message != m_errorTextSource.message)
+	{
+		m_errorText = formatError();
+		m_errorTextSource = m_error;
+	}
+	return false;
+}
+
+String NodeEditor::Node::formatError() const
+{
+	switch (m_error.code)
+	{
+	case NodeErrorCode::InputNotConnected:
+		return U"ノード名:\"{}\", \"入力ソケット:\"{}\"のノードが指定されていません"_fmt(Name, m_error.socketIdx < m_inputSockets.size() ? m_inputSockets[m_error.socketIdx]->Name : U"");
+	case NodeErrorCode::OutputNotSet:
+		return U"ノード名:\"{}\", \"出力ソケット:\"{}\"の出力が指定されていません"_fmt(Name, m_error.socketIdx < m_outputSockets.size() ? m_outputSockets[m_error.socketIdx]->Name : U"");
+	case NodeErrorCode::Exception:
+		return m_error.message;
+	case NodeErrorCode::StepLimitExceeded:
+		return U"ノード名:\"{}\", 1回の実行で{}ステップを超えたため中断しました"_fmt(Name, ExecutionPlan::StepLimit());
+	case NodeErrorCode::ExecCycle:
+		return U"ノード名:\"{}\", 実行ソケットの接続が循環しているため実行しませんでした"_fmt(Name);
+	case NodeErrorCode::InputFailed:
+		return U"ノード名:\"{}\", \"入力ソケット:\"{}\"の生成元が失敗したため実行しませんでした"_fmt(Name, m_error.socketIdx < m_inputSockets.size() ? m_inputSockets[m_error.socketIdx]->Name : U"");
+	case NodeErrorCode::BodyNotConnected:
+		return U"ノード名:\"{}\", 本体のノード:\"{}\"の入力がありません"_fmt(Name, m_error.message);
+	case NodeErrorCode::BodyCycle:
+		return U"ノード名:\"{}\", 本体の接続が循環しています"_fmt(Name);
+	case NodeErrorCode::BodyUnsupported:
+		return U"ノード名:\"{}\", ノード:\"{}\"は本体として評価できません"_fmt(Name, m_error.message);
+	default:
+		return U"";
+	}
+}
 
-		//次のノードを実行
-		if (m_nextNodeSockets)
+bool NodeEditor::Node::upToDate(const ValueSocket* const* sources) const
+{
+	//入力を持たないノードは、入力の変化から出力が変わらないことを判断できない
+	if (!Pure || !Deterministic || !m_outputValid || m_inputSockets.isEmpty())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < m_inputSockets.size(); i++)
+	{
+		if (!sources[i] || sources[i]->version() != m_inputSockets[i]->version())
 		{
-			for (auto& nextSocket : m_nextNodeSockets[NextExecIdx]->ConnectedSocket)
-			{
-				nextSocket->Parent.run();
-			}
+			return false;
 		}
 	}
-	catch (Error& ex)
+	return true;
+}
+
+NodeEditor::ExecutionPlan& NodeEditor::Node::preparePlan()
+{
+	//接続が変更されたときだけ実行計画を作り直す
+	if (!m_plan || !m_plan->isValid())
 	{
-		setBackCol(20);
-		m_errorMsg = ex.what();
+		m_plan = ExecutionPlan::Compile(*this, m_plan.get());
 	}
+	return *m_plan;
+}
+
+void NodeEditor::Node::run()
+{
+	preparePlan().run();
+}
+
+void NodeEditor::Node::run(ThreadPool& pool)
+{
+	preparePlan().run(&pool);
+}
+
+bool NodeEditor::Node::runFor(const Duration& budget)
+{
+	return preparePlan().runFor(budget);
 }
 
+bool NodeEditor::Node::runFor(const Duration& budget, ThreadPool& pool)
+{
+	return preparePlan().runFor(budget, &pool);
+}
+
+void NodeEditor::Node::resume()
+{
+	preparePlan().resume();
+}
+
+void NodeEditor::Node::resume(ThreadPool& pool)
+{
+	preparePlan().resume(&pool);
+}
+
+#ifndef NODEEDITOR_HEADLESS
 void NodeEditor::Node::update(const Config& cfg, Input& input)
 {
 	calcSize(cfg);
@@ -209,10 +380,10 @@ void NodeEditor::Node::draw(const Config& cfg)
 	drawBackground(cfg);
 
 	//エラーメッセージの吹き出し描画
-	if (m_errorMsg)
+	if (const auto source = errorSource())
 	{
 		const auto bottomCenter = m_rect.topCenter();
-		const auto text = cfg.font(m_errorMsg.value());
+		const auto text = cfg.font(source->m_errorText);
 		const auto topCenter = bottomCenter - Vec2(0, 10);
 		const RectF balloonRect(Arg::bottomCenter = topCenter, text.region().size + SizeF(20, 0));
 
@@ -221,6 +392,14 @@ void NodeEditor::Node::draw(const Config& cfg)
 		text.drawAt(balloonRect.center(), Palette::Black);
 	}
 
+#ifdef NODEEDITOR_PROFILE
+	//実行回数と平均の実行時間
+	if (cfg.ShowProfile && m_profile.calls)
+	{
+		cfg.font(U"{} calls / {:.1f}us"_fmt(m_profile.calls, m_profile.averageNs() / 1000)).draw(Arg::topCenter = m_rect.bottomCenter(), Palette::White);
+	}
+#endif
+
 	//ノードの描画
 	Vec2 fontBasePos = m_contentRect.tl();
 
@@ -317,6 +496,7 @@ void NodeEditor::Node::draw(const Config& cfg)
 		childDraw(cfg);
 	}
 }
+#endif
 
 NodeEditor::Node::~Node()
 {
@@ -1,21 +1,126 @@
 #pragma once
 #include<Siv3D.hpp>
+#include<concepts>
+#include"Serializable.hpp"
+#include"Profile.hpp"
+#include"Trace.hpp"
+#ifndef NODEEDITOR_HEADLESS
 #include"Config.hpp"
 #include"Input.hpp"
+#endif
 #include"3rdparty/nameof.hpp"
 
 namespace NodeEditor
 {
 	class ISocket;
+
+	class Column;
+
+	namespace detail
+	{
+		class NodeGenerator;
+	}
+
+	namespace Builtin
+	{
+		class ParallelForEachNode;
+	}
 }
 #include"NodeSocket.hpp"
+#include"ExecutionPlan.hpp"
 
 namespace NodeEditor
 {
+	/// <summary>
+	/// ノードの実行時のエラーの種類
+	/// </summary>
+	enum class NodeErrorCode : uint8
+	{
+		None,
+		//入力ソケットが接続されていない
+		InputNotConnected,
+		//childRunが出力ソケットに値を設定しなかった
+		OutputNotSet,
+		//childRunが例外を送出した
+		Exception,
+		//1回の実行のステップ数が上限に達した
+		StepLimitExceeded,
+		//実行ソケットの接続が循環しているため、計画を実行しなかった
+		ExecCycle,
+		//入力の生成元がこのパスで失敗した(古い値で実行しない)
+		InputFailed,
+		//ParallelForEachの本体のノードの入力ソケットが接続されていない(生成元が値を出力しなかった場合を含む)
+		BodyNotConnected,
+		//ParallelForEachの本体の接続が循環している(本体からresultsを参照している場合を含む)
+		BodyCycle,
+		//ParallelForEachの本体にchildRunSlotsに対応していないノードがある
+		BodyUnsupported,
+	};
+
+	/// <summary>
+	/// ノードの実行時のエラー
+	/// </summary>
+	/// <remarks>
+	/// 実行中は種類と位置だけを記録し、メッセージは表示するときに組み立てる
+	/// </remarks>
+	struct NodeError
+	{
+		NodeErrorCode code = NodeErrorCode::None;
+
+		//原因のソケットの番号(InputNotConnected, OutputNotSet, InputFailed)
+		size_t socketIdx = 0;
+
+		//送出された例外のメッセージ(Exception)、原因のノードの名前(BodyNotConnected, BodyUnsupported)
+		String message;
+
+		explicit operator bool() const
+		{
+			return code != NodeErrorCode::None;
+		}
+	};
+
+	/// <summary>
+	/// ノードの種類や関数を登録するときに指定する性質
+	/// </summary>
+	/// <remarks>
+	/// 登録した種類から生成したノード(読み込んだグラフのノードを含む)に適用され、実行計画が評価の省略や並列化に使う
+	/// </remarks>
+	struct NodeOptions
+	{
+		//入力だけから出力が決まり副作用がない(noneならノードの設定に従う。関数は副作用があるものとして扱う)
+		Optional<bool> pure;
+
+		//他のノードと同時に別スレッドから呼ばれてもよい(noneならノードの設定に従う。関数は呼ばれてはならないものとして扱う)
+		Optional<bool> threadSafe;
+
+		//同じ入力に対して常に同じ出力を返す
+		//falseなら純粋でも前回の出力を使い回さず、定数の畳み込みや同じ入力のノードとの統合もしない
+		bool deterministic = true;
+
+		//1回の評価にかかるおよその時間[ns](0なら不明。Node::Costを参照)
+		double cost = 0;
+
+		//ノードの一覧に表示する
+		bool visible = true;
+	};
+
 	class Node : public ISerializable
 	{
+		friend class ExecutionPlan;
+
+		friend class Bytecode;
+
+		friend class Batch;
+
+		friend class Graph;
+
+		friend class detail::NodeGenerator;
+
+		friend class Builtin::ParallelForEachNode;
+
 	private:
 
+#ifndef NODEEDITOR_HEADLESS
 		SizeF m_size;
 
 		bool m_isGrab = false;
@@ -23,6 +128,7 @@ namespace NodeEditor
 		Stopwatch m_backColStw = Stopwatch(Duration(1s), true);
 
 		double m_backHue = 0;
+#endif
 
 		//Serialize
 		Array<std::shared_ptr<ValueSocket>> m_inputSockets;
@@ -36,6 +142,7 @@ namespace NodeEditor
 		//Serialize
 		Array<std::shared_ptr<ExecSocket>> m_nextNodeSockets;
 
+#ifndef NODEEDITOR_HEADLESS
 		RectF m_rect;
 
 		RectF m_titleRect;
@@ -46,18 +153,63 @@ namespace NodeEditor
 
 		RectF m_childRect;
 
-		Optional<String> m_errorMsg;
-
 		bool m_clicked = false;
+#endif
+
+		NodeError m_error;
+
+		//m_errorのメッセージ(吹き出しに毎フレーム表示するので、エラーが変わったときだけ作り直す)
+		String m_errorText;
+
+		//m_errorTextを作ったときのエラー
+		NodeError m_errorTextSource;
+
+		//constantChangedを呼んだ回数(このノードを畳み込んだ計画は、変わっていたら定数を計算し直す)
+		uint64 m_constantVersion = 0;
+
+		//NODEEDITOR_PROFILEの有無でNodeの配置が変わらないよう、計測しないときも持つ
+		NodeProfile m_profile;
+
+		//このノードを起点とした実行計画のキャッシュ
+		std::shared_ptr<ExecutionPlan> m_plan;
+
+		//最後に評価されたパス番号
+		uint64 m_evalPass = 0;
 
+		//前回の実行が成功し、出力が有効ならtrue
+		bool m_outputValid = false;
+
+#ifndef NODEEDITOR_HEADLESS
 		void calcSize(const Config& cfg);
 
 		void calcRect(const Config& cfg);
 
 		void drawBackground(const Config& cfg);
+#endif
 
+		//実行結果をエディタ上の背景色で示す(ヘッドレスでは何もしない)
 		void setBackCol(const double hue);
 
+		//入力値の受け取り、childRun、出力の確認のみを行う(次のノードは実行しない)
+		bool execute(const ValueSocket* const* sources);
+
+		//childRunと出力の確認のみを行う
+		bool runChild();
+
+		//中断している処理の再開と、完了した場合は出力の確認を行う
+		bool resumeRun();
+
+		bool checkOutputs();
+
+		bool setError(NodeErrorCode code, size_t socketIdx = 0);
+
+		String formatError() const;
+
+		//Pure(かつDeterministic)で入力を持つノードで、前回の実行から入力が変化していなければtrue
+		bool upToDate(const ValueSocket* const* sources) const;
+
+		ExecutionPlan& preparePlan();
+
 	protected:
 
 		SizeF ChildSize = SizeF(0, 0);
@@ -66,11 +218,63 @@ namespace NodeEditor
 
 		bool CanDelete = true;
 
+		//入力が変化しない限り出力も変化しない(副作用がない)ノードならtrue
+		//入力が変化していないときはchildRunを省略して前回の出力を使う
+		bool Pure = false;
+
+		//入力を持たず、値を編集しない限り出力が変化しないノードならtrue
+		//Pureなノードだけを介してつながる下流のノードとともに、実行計画の生成時に定数として畳み込まれる
+		//値を編集したときはconstantChangedを呼ぶこと
+		bool Constant = false;
+
+		//他のノードと同時に別スレッドで実行してもよいノードならtrue
+		bool ThreadSafe = false;
+
+		//同じ入力に対して常に同じ出力を返すノードならtrue(乱数や時刻を出力するノードはfalseにする)
+		//falseのノードはPureでも評価を省略せず、定数として畳み込まない
+		bool Deterministic = true;
+
+		//1回の評価にかかるおよその時間[ns](0なら不明)
+		//並列実行時、ThreadSafeでもExecutionPlan::MinParallelCostに満たないノードはスレッドプールに渡さない
+		//使われるのはこの判定だけで、評価の順序や優先度には影響しない
+		double Cost = 0;
+
+		//入力の生成元のうち、このノードの出力に依存するもの(本体)を自身で評価するノードならtrue
+		//実行計画は本体を命令列に含めず、それ以外の生成元だけを先に評価する
+		bool EvaluatesBody = false;
+
+		//インスタンスごとに異なる状態(メンバ変数)を持つノードならtrue
+		//InstanceSetでは実行の前後にloadState/saveStateで状態を切り替えて1つのノードを使い回す
+		bool InstanceState = false;
+
 		virtual void childRun() {};
 
+		/// <summary>
+		/// バッチ実行でcount個の入力の列から出力の列を計算する
+		/// </summary>
+		/// <returns>対応していなければfalse(要素ごとにchildRunが呼ばれる)</returns>
+		virtual bool childRunColumns(const Column* const*, Column* const*, size_t)
+		{
+			return false;
+		}
+
+		/// <summary>
+		/// 入力の値から出力の値を計算する(ソケットやメンバ変数を変更せずに、outputsに出力ソケットの数だけ書き込む)
+		/// </summary>
+		/// <remarks>
+		/// ParallelForEachNodeの本体として、ThreadSafeなノードは複数のスレッドから同時に呼ばれる
+		/// </remarks>
+		/// <returns>対応していなければfalse</returns>
+		virtual bool childRunSlots(const ValueSlot* const*, ValueSlot*) const
+		{
+			return false;
+		}
+
+#ifndef NODEEDITOR_HEADLESS
 		virtual void childUpdate(const Config&, Input&) {};
 
 		virtual void childDraw(const Config&) {};
+#endif
 
 		virtual void childSerialize(JSONWriter& writer) const
 		{
@@ -80,16 +284,73 @@ namespace NodeEditor
 
 		virtual void childDeserialize(const JSONValue&) {};
 
+		/// <summary>
+		/// インスタンスごとの状態を書き出す(InstanceStateなノードのみ呼ばれる)
+		/// </summary>
+		virtual void saveState(ValueSlot&) const {};
+
+		/// <summary>
+		/// saveStateで書き出した状態を読み込む
+		/// </summary>
+		virtual void loadState(const ValueSlot&) {};
+
+		/// <summary>
+		/// 実行ソケットの処理を中断しているならtrue(中断している間は次のノードに進まない)
+		/// </summary>
+		virtual bool suspended() const
+		{
+			return false;
+		}
+
+		/// <summary>
+		/// 中断している処理を再開できる状態なら再開する
+		/// </summary>
+		virtual void resumeChild() {};
+
+		/// <summary>
+		/// 中断している処理を破棄する(中断したまま実行計画から外れ、再開されなくなったときに呼ばれる)
+		/// </summary>
+		virtual void abortSuspended() {};
+
+		/// <summary>
+		/// 反復の途中ならtrue(実行した後に確認し、trueなら次の実行ソケットの先を全て実行してから再びこのノードを実行する)
+		/// </summary>
+		virtual bool looping() const
+		{
+			return false;
+		}
+
+		/// <summary>
+		/// 反復を打ち切る(実行中のパスが破棄されたときや、ステップ数が上限に達したときに呼ばれる)
+		/// </summary>
+		virtual void abortLoop() {};
+
+		//Constantなノードの値を編集したことを通知する(このノードを畳み込んだ計画だけが、次の実行で定数を計算し直す)
+		void constantChanged()
+		{
+			m_constantVersion++;
+		}
+
 		template<class T>
 		void setOutput(const size_t index, const T& input)
 		{
-			m_outputSockets[index]->setValue(std::any(input));
+			auto& outSocket = m_outputSockets[index];
+			if constexpr (std::equality_comparable<T>)
+			{
+				//値が変わらないときはバージョンを更新しない
+				if (const auto current = outSocket->value().tryGet<T>(); current && *current == input)
+				{
+					return;
+				}
+			}
+			outSocket->setValue(input);
 		}
 
+		//入力ソケットの型は接続時に確認済みのため、型を確認せずに参照する
 		template<class T>
-		T getInput(const size_t index) const
+		const T& getInput(const size_t index) const
 		{
-			return std::any_cast<T>(m_inputSockets[index]->value());
+			return m_inputSockets[index]->value().get<T>();
 		}
 
 		void cfgInputSockets(Array<std::pair<Type, String>> cfg);
@@ -113,6 +374,12 @@ namespace NodeEditor
 		//Serialize
 		size_t ID = 0;
 
+		//関数テーブルに登録された関数のノードならその番号
+		Optional<uint32> FunctionId;
+
+		//FunctionIdが指す関数テーブルの番号(FunctionTable::id)
+		uint64 FunctionTableId = 0;
+
 		bool Selecting = false;
 
 		Node()
@@ -122,15 +389,88 @@ namespace NodeEditor
 
 		void run();
 
+		/// <summary>
+		/// ThreadSafeなノードをpool上で並列に評価しながら実行する
+		/// </summary>
+		void run(ThreadPool& pool);
+
+		/// <summary>
+		/// budgetの時間だけ実行し、時間切れになったらノードの境界で止める(続きは次の呼び出しで実行する)
+		/// </summary>
+		/// <remarks>
+		/// 中断しているノードの再開もbudgetの中で行うので、resumeを別に呼ぶ必要はない。
+		/// </remarks>
+		/// <returns>パスが最後まで終わったらtrue</returns>
+		bool runFor(const Duration& budget);
+
+		bool runFor(const Duration& budget, ThreadPool& pool);
+
+		/// <summary>
+		/// このノードを起点とした実行で中断したノードを再開し、完了したものから次のノードを実行する
+		/// </summary>
+		void resume();
+
+		void resume(ThreadPool& pool);
+
+#ifndef NODEEDITOR_HEADLESS
 		void update(const Config& cfg, Input& input);
 
 		void draw(const Config& cfg);
+#endif
 
 		bool canDelete() const
 		{
 			return CanDelete;
 		}
 
+		/// <summary>
+		/// 直前の実行で発生したエラー
+		/// </summary>
+		const NodeError& getError() const
+		{
+			return m_error;
+		}
+
+		/// <summary>
+		/// 直前の実行で発生したエラーのメッセージ(エラーが無ければ空)
+		/// </summary>
+		String getErrorMessage() const
+		{
+			return m_error ? m_errorText : String();
+		}
+
+		/// <summary>
+		/// エディタで吹き出しに表示するエラーを持つノード(エラーが無ければnullptr)
+		/// </summary>
+		/// <remarks>
+		/// 通常は自身。サブグラフのノードは内部のノードを描画しないので、失敗した内部のノードを返す
+		/// </remarks>
+		virtual const Node* errorSource() const
+		{
+			return m_error ? this : nullptr;
+		}
+
+		/// <summary>
+		/// 実行時間の集計(NODEEDITOR_PROFILEを定義していなければ常に0)
+		/// </summary>
+		const NodeProfile& getProfile() const
+		{
+			return m_profile;
+		}
+
+		void resetProfile()
+		{
+			m_profile = NodeProfile();
+		}
+
+		/// <summary>
+		/// このノードを起点とした実行計画(run()を呼ぶまではnullptr)
+		/// </summary>
+		std::shared_ptr<const ExecutionPlan> getPlan() const
+		{
+			return m_plan;
+		}
+
 		template<class T>
 		void setInput(const size_t idx, const T& input)
 		{
@@ -139,7 +479,7 @@ namespace NodeEditor
 			{
 				throw Error(U"入力できない型の値を入力しました");
 			}
-			inSocket->value(std::any(input));
+			inSocket->setValue(input);
 		}
 
 		template<class T>
@@ -150,13 +490,18 @@ namespace NodeEditor
 			{
 				throw Error(U"このノードの出力はありません");
 			}
-			if (!outSocket->value().has_value())
+			if (!outSocket->hasValue())
 			{
 				run();
 			}
-			return std::any_cast<T>(outSocket->value());
+			if (const auto value = outSocket->value().tryGet<T>())
+			{
+				return *value;
+			}
+			throw Error(U"出力の型が異なります");
 		}
 
+#ifndef NODEEDITOR_HEADLESS
 		RectF getRect() const
 		{
 			return RectF(Location, m_size);
@@ -166,6 +511,7 @@ namespace NodeEditor
 		{
 			return m_clicked;
 		}
+#endif
 
 		~Node();
 
@@ -273,36 +619,64 @@ namespace NodeEditor
 
 	namespace detail
 	{
-		template<class Type>
+		//CallableはFuncTypeの形で呼び出せる関数オブジェクト(std::functionを介さずに保持する)
+		template<class FuncType, class Callable = std::function<FuncType>>
 		class FunctionNode;
 
 		//戻り値ありの関数
-		template<class Result, class... Args>
-		class FunctionNode<Result(Args...)> : public NodeEditor::Node
+		template<class Result, class... Args, class Callable>
+		class FunctionNode<Result(Args...), Callable> : public NodeEditor::Node
 		{
 		private:
 
-			std::function<Result(Args...)> m_function;
+			Callable m_function;
+
+			//入力ソケットiを引数iに渡す(値は接続先の出力ソケットを参照するのでコピーしない)
+			template<size_t... Idx>
+			void call(std::index_sequence<Idx...>)
+			{
+				setOutput<Result>(0, m_function(getInput<std::decay_t<Args>>(Idx)...));
+			}
 
 			void childRun() override
 			{
-				size_t argIdx = sizeof...(Args) - 1;
-				setOutput<Result>(0, m_function(getInput<Args>(argIdx--)...));
+				call(std::index_sequence_for<Args...>());
+			}
+
+			template<size_t... Idx>
+			void callSlots(const ValueSlot* const* inputs, ValueSlot* outputs, std::index_sequence<Idx...>) const
+			{
+				outputs[0].set(m_function(inputs[Idx]->get<std::decay_t<Args>>()...));
+			}
+
+			//constで呼び出せない関数オブジェクト(mutableなラムダ式など)は同時に呼ぶと状態が競合するので対応しない
+			bool childRunSlots(const ValueSlot* const* inputs, ValueSlot* outputs) const override
+			{
+				if constexpr (std::is_invocable_v<const Callable&, const std::decay_t<Args>&...>)
+				{
+					callSlots(inputs, outputs, std::index_sequence_for<Args...>());
+					return true;
+				}
+				else
+				{
+					return false;
+				}
 			}
 
 		public:
 
-			FunctionNode(const String& name, const Array<String>& socketNames, std::function<Result(Args...)> function)
+			FunctionNode(const String& name, const Array<String>& socketNames, Callable function, bool threadSafe = false)
+				:m_function(std::move(function))
 			{
 				if (socketNames.size() != (sizeof...(Args) + 1))
 				{
 					throw Error(U"");
 				}
 
-				m_function = function;
-
 				Name = name;
 
+				ThreadSafe = threadSafe;
+
 				size_t argIdx = 0;
 				cfgOutputSockets({ {Type::getType<Result>(),socketNames[argIdx++]} });
 				cfgInputSockets({ {Type::getType<Args>(),socketNames[argIdx++]}... });
@@ -312,32 +686,38 @@ namespace NodeEditor
 		};
 
 		//戻り値なしの関数
-		template<class... Args>
-		class FunctionNode<void(Args...)> : public NodeEditor::Node
+		template<class... Args, class Callable>
+		class FunctionNode<void(Args...), Callable> : public NodeEditor::Node
 		{
 		private:
 
-			std::function<void(Args...)> m_function;
+			Callable m_function;
+
+			template<size_t... Idx>
+			void call(std::index_sequence<Idx...>)
+			{
+				m_function(getInput<std::decay_t<Args>>(Idx)...);
+			}
 
 			void childRun() override
 			{
-				size_t argIdx = sizeof...(Args) - 1;
-				m_function(getInput<Args>(argIdx--)...);
+				call(std::index_sequence_for<Args...>());
 			}
 
 		public:
 
-			FunctionNode(const String& name, const Array<String>& socketNames, std::function<void(Args...)> function)
+			FunctionNode(const String& name, const Array<String>& socketNames, Callable function, bool threadSafe = false)
+				:m_function(std::move(function))
 			{
 				if (socketNames.size() != sizeof...(Args))
 				{
 					throw Error(U"");
 				}
 
-				m_function = function;
-
 				Name = name;
 
+				ThreadSafe = threadSafe;
+
 				size_t argIdx = 0;
 				cfgInputSockets({ {Type::getType<Args>(),socketNames[argIdx++]}... });
 				cfgPrevExecSocket({ U"" });
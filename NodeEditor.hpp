@@ -5,151 +5,13 @@
 #include"Config.hpp"
 #include"Node.hpp"
 #include"NodeSocket.hpp"
+#include"Graph.hpp"
 #include"Group.hpp"
 
 namespace NodeEditor
 {
 	namespace detail
 	{
-		Array<String> split(const String& str, const String& key)
-		{
-			Array<String> result;
-			size_t start = 0, end = 0;
-			while ((end = str.indexOf(key, start)) != String::npos)
-			{
-				result << str.substr(start, end - start);
-				start = end + key.length();
-			}
-			result << str.substr(start, str.length());
-			return result;
-		}
-
-		class NodeGenerator
-		{
-		private:
-
-			using GeneratorType = std::function<std::shared_ptr<Node>(void)>;
-
-			std::regex prefixRegex = std::regex("^(?:class |struct )?(.*)$");
-
-			template<class SubType>
-			GeneratorType createGenerator(const String& className)
-			{
-				return [=]()
-				{
-					auto inode = std::make_shared<SubType>();
-					inode->Class = className;
-					return inode;
-				};
-			}
-
-			template<class FuncType>
-			GeneratorType createFuncGenerator(const String& className, const String& name, const Array<String>& argNames, const std::function<FuncType>& function)
-			{
-				return [=]()
-				{
-					auto inode = std::make_shared<detail::FunctionNode<FuncType>>(name, argNames, function);
-					inode->Class = className;
-					return inode;
-				};
-			}
-
-			Array<String> parseNames(const String& name)
-			{
-				std::cmatch match;
-				std::string stdstring = name.toUTF8();
-				std::regex_match(stdstring.c_str(), match, prefixRegex);
-
-				return detail::split(Unicode::FromUTF8(match[1].str()), U"::");
-			}
-
-		public:
-
-			struct NodeClass
-			{
-				bool isFunction;
-				bool visible;
-				GeneratorType generator;
-			};
-
-			struct Group
-			{
-				std::unordered_map<String, NodeClass> classes;
-				std::unordered_map<String, Group> namespaces;
-				String ToString(const String& prefix = U"")
-				{
-					String str;
-					for (auto& keyval : classes)
-					{
-						str += prefix + keyval.first + U"\n";
-					}
-					for (auto& keyval : namespaces)
-					{
-						str += keyval.second.ToString(prefix + keyval.first + U"::");
-					}
-					return str;
-				}
-			};
-
-			Group global;
-
-			template<class SubType>
-			void registerType(bool visible = true)
-			{
-				Type type = Type::getType<SubType>();
-
-				auto names = parseNames(Unicode::FromUTF8(typeid(SubType).name()));
-
-				auto targetNamespace = std::ref(global);
-				for (size_t i = 0; i < names.size() - 1; i++)
-				{
-					targetNamespace = targetNamespace.get().namespaces[names[i]];
-				}
-				targetNamespace.get().classes.emplace(names[names.size() - 1], NodeClass{ false,visible,createGenerator<SubType>(names.join(U"::",U"",U"")) });
-			}
-
-			template<class FuncType>
-			void registerFunction(const String& name, const Array<String>& argNames, const std::function<FuncType>& function)
-			{
-				auto names = parseNames(name);
-
-				auto targetNamespace = std::ref(global);
-				for (size_t i = 0; i < names.size() - 1; i++)
-				{
-					targetNamespace = targetNamespace.get().namespaces[names[i]];
-				}
-				targetNamespace.get().classes.emplace(names[names.size() - 1], NodeClass{ true,true,createFuncGenerator<FuncType>(names.join(U"::",U"",U""),names[names.size() - 1],argNames,function) });
-			}
-
-			Optional<std::shared_ptr<Node>> getNode(const Type& type)
-			{
-				return getNode(parseNames(type.name()));
-			}
-
-			Optional<std::shared_ptr<Node>> getNode(const String& names)
-			{
-				return getNode(parseNames(names));
-			}
-
-			Optional<std::shared_ptr<Node>> getNode(const Array<String>& names)
-			{
-				auto targetNamespace = std::ref(global);
-				for (size_t i = 0; i < names.size() - 1; i++)
-				{
-					targetNamespace = targetNamespace.get().namespaces[names[i]];
-				}
-				auto result = targetNamespace.get().classes.find(names[names.size() - 1]);
-				if (result == targetNamespace.get().classes.end())
-				{
-					return none;
-				}
-				else
-				{
-					return result->second.generator();
-				}
-			}
-		};
-
 		class NodeListWindow
 		{
 		private:
@@ -214,7 +76,7 @@ namespace NodeEditor
 					}
 					for (auto& keyval : m_currentNs.second.classes)
 					{
-						if (keyval.second.visible)
+						if (keyval.second.options.visible)
 						{
 							if (input.leftClicked(RectF(fontPos, width, cfg.font.height())))
 							{
@@ -267,7 +129,7 @@ namespace NodeEditor
 					}
 					for (auto& keyval : m_currentNs.second.classes)
 					{
-						if (keyval.second.visible)
+						if (keyval.second.options.visible)
 						{
 							RectF btnRect(fontPos, width, cfg.font.height());
 							auto tex = keyval.second.isFunction ? m_functionTexture : m_classTexture;
@@ -450,12 +312,10 @@ namespace NodeEditor
 
 		int32 m_updateFrameCnt = -1;
 
-		Array<std::shared_ptr<Node>> m_nodelist;
+		Graph m_graph;
 
 		Array<std::shared_ptr<Group>> m_grouplist;
 
-		uint32 m_nextId = 1;
-
 		std::shared_ptr<ISocket> m_grabFrom;
 
 		bool m_isGrab = false;
@@ -474,17 +334,29 @@ namespace NodeEditor
 
 		Input m_input;
 
-		detail::NodeGenerator m_inodeGenerator;
-
 		detail::NodeListWindow m_nodelistWindow;
 
 		detail::EditorCamera2D m_camera = detail::EditorCamera2D({ 0, 0 });
 
 		std::shared_ptr<ISocket> m_candidateSocket;//接続先の候補(見つからないときはnullptr)
 
+		//実行されないノード(接続かノード数が変わったときだけ求め直す)
+		std::unordered_set<const Node*> m_deadNodes;
+
+		uint64 m_deadNodesTopology = 0;
+
+		size_t m_deadNodesCount = 0;
+
+		//操作に失敗したときのメッセージ(表示し始めてからNoticeSeconds秒だけ表示する)
+		String m_notice;
+
+		Stopwatch m_noticeTimer;
+
+		static constexpr double NoticeSeconds = 5.0;
+
 		void deselectAll()
 		{
-			for (auto& node : m_nodelist)
+			for (auto& node : m_graph.nodes())
 			{
 				node->Selecting = false;
 			}
@@ -498,7 +370,7 @@ namespace NodeEditor
 			if (m_isGrab)
 			{
 				//接続の候補を検索
-				std::for_each(std::rbegin(m_nodelist), std::rend(m_nodelist), [this](auto& node)
+				std::for_each(std::rbegin(m_graph.nodes()), std::rend(m_graph.nodes()), [this](auto& node)
 					{
 						for (auto& socket : node->getSockets())
 						{
@@ -514,7 +386,7 @@ namespace NodeEditor
 			}
 			else
 			{
-				std::for_each(std::rbegin(m_nodelist), std::rend(m_nodelist), [this](auto& node)
+				std::for_each(std::rbegin(m_graph.nodes()), std::rend(m_graph.nodes()), [this](auto& node)
 					{
 						for (auto& socket : node->getSockets())
 						{
@@ -557,7 +429,7 @@ namespace NodeEditor
 		void drawCables()
 		{
 			Vec2 start, end;
-			for (auto& node : m_nodelist)
+			for (auto& node : m_graph.nodes())
 			{
 				for (auto& inSocket : node->getAllInputSockets())
 				{
@@ -600,7 +472,7 @@ namespace NodeEditor
 		void updateNodes()
 		{
 			bool selectAppend = KeyShift.pressed() || KeyControl.pressed();
-			std::for_each(std::rbegin(m_nodelist), std::rend(m_nodelist), [&](std::shared_ptr<Node>& node)
+			std::for_each(std::rbegin(m_graph.nodes()), std::rend(m_graph.nodes()), [&](std::shared_ptr<Node>& node)
 				{
 					node->update(m_config, m_input);
 					if (node->clicked())
@@ -617,9 +489,35 @@ namespace NodeEditor
 		//ノードの描画
 		void drawNodes()
 		{
-			for (auto& node : m_nodelist)
+			if (m_config.DimDeadNodes)
+			{
+				updateDeadNodes();
+			}
+
+			for (auto& node : m_graph.nodes())
 			{
 				node->draw(m_config);
+
+				if (m_config.DimDeadNodes && m_deadNodes.contains(node.get()))
+				{
+					node->getRect().rounded(m_config.RectR).draw(ColorF(0.2, 0.6));
+				}
+			}
+		}
+
+		void updateDeadNodes()
+		{
+			if (m_deadNodesTopology == ISocket::TopologyVersion() && m_deadNodesCount == m_graph.nodes().size())
+			{
+				return;
+			}
+			m_deadNodesTopology = ISocket::TopologyVersion();
+			m_deadNodesCount = m_graph.nodes().size();
+
+			m_deadNodes.clear();
+			for (const auto& node : m_graph.deadNodes())
+			{
+				m_deadNodes.emplace(node.get());
 			}
 		}
 
@@ -645,7 +543,7 @@ namespace NodeEditor
 						Abs(cursor.x - m_rangeSelectionBegin.x),
 						Abs(cursor.y - m_rangeSelectionBegin.y)
 					);
-					for (auto& node : m_nodelist)
+					for (auto& node : m_graph.nodes())
 					{
 						node->Selecting = m_rangeSelectionRange.contains(node->getRect());
 					}
@@ -687,7 +585,7 @@ namespace NodeEditor
 		{
 			std::for_each(std::rbegin(m_grouplist), std::rend(m_grouplist), [&](std::shared_ptr<Group>& group)
 				{
-					group->update(m_config, m_input, m_nodelist);
+					group->update(m_config, m_input, m_graph.nodes());
 				});
 		}
 
@@ -705,7 +603,7 @@ namespace NodeEditor
 		{
 			if (KeyDelete.down())
 			{
-				m_nodelist.remove_if([this](std::shared_ptr<Node> node)
+				m_graph.nodes().remove_if([this](std::shared_ptr<Node> node)
 					{
 						bool result = node->canDelete() && node->Selecting;
 						if (result)
@@ -715,19 +613,68 @@ namespace NodeEditor
 						return result;
 					});
 			}
+
+			//Ctrl+Gで選択したノードをサブグラフにまとめ、Ctrl+Shift+Gで選択したサブグラフを展開する
+			if (KeyControl.pressed() && KeyG.down())
+			{
+				Array<std::shared_ptr<Node>> selected;
+				for (const auto& node : m_graph.nodes())
+				{
+					if (node->Selecting && node->canDelete())
+					{
+						selected << node;
+					}
+				}
+
+				try
+				{
+					if (KeyShift.pressed())
+					{
+						for (const auto& node : selected)
+						{
+							if (const auto subgraph = std::dynamic_pointer_cast<SubgraphNode>(node))
+							{
+								m_graph.expand(subgraph);
+							}
+						}
+					}
+					else if (selected)
+					{
+						m_graph.collapse(selected);
+					}
+				}
+				catch (const Error& ex)
+				{
+					//種類が登録されていないノードを含むなどでまとめられなかった(グラフは変更されていない)
+					showNotice(ex.what());
+				}
+			}
 		}
 
-		void addNode(std::shared_ptr<Node> node, const Vec2& pos = Vec2(0, 0))
+		void showNotice(const String& message)
 		{
-			m_nodelist << node;
-			node->ID = m_nextId++;
-			node->Location = pos;
+			m_notice = message;
+			m_noticeTimer.restart();
+		}
+
+		//操作に失敗したときのメッセージの描画(エディタの左下)
+		void drawNotice()
+		{
+			if (m_notice.isEmpty() || m_noticeTimer.sF() > NoticeSeconds)
+			{
+				return;
+			}
+
+			const auto text = m_config.font(m_notice);
+			const RectF rect(Arg::bottomLeft = Vec2(10, m_texture.height() - 10), text.region().size + SizeF(20, 10));
+			rect.draw(Palette::White);
+			text.drawAt(rect.center(), Palette::Black);
 		}
 
 	public:
 
 		NodeEditor(Size size)
-			:m_nodelistWindow(m_inodeGenerator)
+			:m_nodelistWindow(m_graph.generator())
 		{
 			resize(size);
 		}
@@ -737,6 +684,11 @@ namespace NodeEditor
 			m_texture = RenderTexture(size);
 		}
 
+		Config& config()
+		{
+			return m_config;
+		}
+
 		/// <summary>
 		/// 更新処理
 		/// </summary>
@@ -763,7 +715,7 @@ namespace NodeEditor
 					auto node = m_nodelistWindow.update(m_config, m_input);
 					if (node)
 					{
-						addNode(node, m_nodelistWindow.m_location);
+						m_graph.addNode(node, m_nodelistWindow.m_location);
 						if (m_grabFrom)
 						{
 							for (auto socket : node->getSockets())
@@ -825,88 +777,103 @@ namespace NodeEditor
 
 					m_nodelistWindow.draw(m_config);
 				}
+
+				drawNotice();
 			}
 			m_texture.draw(location);
 		}
 
+		/// <summary>
+		/// ノードの種類を登録する
+		/// </summary>
+		/// <param name="options">生成したノードに適用する性質(指定しなければノードのコンストラクタの設定に従う)</param>
+		template<class NodeType>
+		void registerNodeType(const NodeOptions& options)
+		{
+			m_graph.registerNodeType<NodeType>(options);
+		}
+
 		template<class NodeType>
 		void registerNodeType(bool visible = true)
 		{
-			m_inodeGenerator.registerType<NodeType>(visible);
+			m_graph.registerNodeType<NodeType>(visible);
 		}
 
-		template<class FuncType>
-		void registerNodeFunction(const String& name, const Array<String>& argNames, const std::function<FuncType>& function)
+		/// <summary>
+		/// 組み込みの算術/比較/ループのノードを登録する
+		/// </summary>
+		void registerBuiltinNodes()
 		{
-			m_inodeGenerator.registerFunction<FuncType>(name, argNames, function);
+			m_graph.registerBuiltinNodes();
+		}
+
+		/// <summary>
+		/// 関数をノードとして登録する
+		/// </summary>
+		/// <param name="function">FuncTypeの形で呼び出せる関数オブジェクト(ラムダ式などはstd::functionに変換せずに保持する)</param>
+		/// <param name="options">関数の性質(既定では副作用があるものとして毎回呼び出し、別スレッドからは呼ばない。入力だけから戻り値が決まる関数はpureを指定する)</param>
+		template<class FuncType, class Callable>
+		void registerNodeFunction(const String& name, const Array<String>& argNames, Callable function, const NodeOptions& options)
+		{
+			m_graph.registerNodeFunction<FuncType, Callable>(name, argNames, function, options);
+		}
+
+		/// <param name="threadSafe">関数が他のノードと同時に別スレッドから呼ばれてもよい場合はtrue</param>
+		template<class FuncType, class Callable>
+		void registerNodeFunction(const String& name, const Array<String>& argNames, Callable function, bool threadSafe = false)
+		{
+			m_graph.registerNodeFunction<FuncType, Callable>(name, argNames, function, threadSafe);
+		}
+
+		/// <summary>
+		/// entryを起点とするグラフをレジスタマシン用の命令列に変換する
+		/// </summary>
+		/// <remarks>
+		/// 登録された関数のノードは関数テーブルから直接呼び出される。
+		/// 命令列はこのNodeEditorの関数テーブルを参照するので、NodeEditorより長く使わないこと。
+		/// </remarks>
+		std::shared_ptr<Bytecode> compile(Node& entry) const
+		{
+			return m_graph.compile(entry);
 		}
 
 		template<class NodeType>
 		Optional<std::shared_ptr<NodeType>> addNode(const Vec2& pos = Vec2(0, 0))
 		{
-			auto result = addNode(Type::getType<NodeType>(), pos);
-			if (result)
-			{
-				return std::dynamic_pointer_cast<NodeType>(*result);
-			}
-			else
-			{
-				return none;
-			}
+			return m_graph.addNode<NodeType>(pos);
 		}
 
 		Optional<std::shared_ptr<Node>> addNode(const String& name, const Vec2& pos = Vec2(0, 0))
 		{
-			auto inode = m_inodeGenerator.getNode(name);
-			if (inode)
-			{
-				m_nodelist << *inode;
-				(*inode)->ID = m_nextId++;
-				(*inode)->Location = pos;
-			}
-			return inode;
+			return m_graph.addNode(name, pos);
 		}
 
 		Optional<std::shared_ptr<Node>> addNode(const Type& type, const Vec2& pos = Vec2(0, 0))
 		{
-			auto inode = m_inodeGenerator.getNode(type);
-			if (inode)
-			{
-				m_nodelist << *inode;
-				(*inode)->ID = m_nextId++;
-				(*inode)->Location = pos;
-			}
-			return inode;
+			return m_graph.addNode(type, pos);
 		}
 
 		Optional<std::shared_ptr<Node>> searchNode(size_t id)
 		{
-			for (auto& node : m_nodelist)
-			{
-				if (node->ID == id)
-				{
-					return node;
-				}
-			}
-			return none;
+			return m_graph.searchNode(id);
 		}
 
 		Optional<std::shared_ptr<Node>> searchNode(const String& className)
 		{
-			for (auto& node : m_nodelist)
-			{
-				if (node->Class == className)
-				{
-					return node;
-				}
-			}
-			return none;
+			return m_graph.searchNode(className);
+		}
+
+		/// <summary>
+		/// ノードの一覧(描画に依存しない部分)
+		/// </summary>
+		Graph& graph()
+		{
+			return m_graph;
 		}
 
 		void clear()
 		{
-			m_nextId = 1;
-			m_nodelist.clear();
+			m_graph.clear();
 			m_grouplist.clear();
 			m_grabFrom = nullptr;
 			m_isGrab = false;
@@ -917,52 +884,14 @@ namespace NodeEditor
 
 		String save()
 		{
-			JSONWriter writer;
-
-			writer.startObject();
-			{
-				writer.key(U"nodes").startArray();
-				for (const auto& node : m_nodelist)
-				{
-					node->serialize(writer);
-				}
-				writer.endArray();
-			}
-			writer.endObject();
-
-			return writer.get();
+			return m_graph.save();
 		}
 
 		void load(const JSONReader& json)
 		{
 			clear();
 
-			auto nodes = json[U"nodes"].arrayView();
-			auto nodesCount = json[U"nodes"].arrayCount();
-
-			m_nodelist.resize(nodesCount);
-
-			for (size_t i = 0; i < nodesCount; i++)
-			{
-				auto className = nodes[i][U"class"].getString();
-				auto inode = m_inodeGenerator.getNode(className);
-				if (inode)
-				{
-					auto node = (*inode);
-					node->deserialize(nodes[i]);
-					m_nodelist[i] = node;
-				}
-				else
-				{
-					throw new Error(U"クラス\"{}\"が見つかりませんでした"_fmt(className));
-				}
-			}
-
-			for (size_t i = 0; i < nodesCount; i++)
-			{
-				auto node = m_nodelist[i];
-				node->deserializeSockets(nodes[i], m_nodelist);
-			}
+			m_graph.load(json);
 		}
 	};
 }
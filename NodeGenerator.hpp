@@ -0,0 +1,255 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<regex>
+#include<unordered_map>
+#include"Node.hpp"
+#include"Bytecode.hpp"
+
+namespace NodeEditor
+{
+	namespace detail
+	{
+		inline Array<String> split(const String& str, const String& key)
+		{
+			Array<String> result;
+			size_t start = 0, end = 0;
+			while ((end = str.indexOf(key, start)) != String::npos)
+			{
+				result << str.substr(start, end - start);
+				start = end + key.length();
+			}
+			result << str.substr(start, str.length());
+			return result;
+		}
+
+		class NodeGenerator
+		{
+		private:
+
+			using GeneratorType = std::function<std::shared_ptr<Node>(void)>;
+
+			std::regex prefixRegex = std::regex("^(?:class |struct )?(.*)$");
+
+			//登録時の性質をノードに適用する(指定されていないものはノードの設定のまま)
+			static void applyOptions(Node& node, const NodeOptions& options)
+			{
+				if (options.pure)
+				{
+					node.Pure = *options.pure;
+				}
+				if (options.threadSafe)
+				{
+					node.ThreadSafe = *options.threadSafe;
+				}
+				node.Deterministic = node.Deterministic && options.deterministic;
+				if (options.cost > 0)
+				{
+					node.Cost = options.cost;
+				}
+			}
+
+			template<class SubType>
+			GeneratorType createGenerator(const String& className, const NodeOptions& options)
+			{
+				return [=]()
+				{
+					auto inode = std::make_shared<SubType>();
+					inode->Class = className;
+					applyOptions(*inode, options);
+					return inode;
+				};
+			}
+
+			template<class FuncType, class Callable>
+			GeneratorType createFuncGenerator(const String& className, const String& name, const Array<String>& argNames, const Callable& function, const NodeOptions& options, uint64 tableId, uint32 functionId)
+			{
+				return [=]()
+				{
+					auto inode = std::make_shared<detail::FunctionNode<FuncType, Callable>>(name, argNames, function);
+					inode->Class = className;
+					inode->FunctionId = functionId;
+					inode->FunctionTableId = tableId;
+					applyOptions(*inode, options);
+					return inode;
+				};
+			}
+
+			Array<String> parseNames(const String& name)
+			{
+				std::cmatch match;
+				std::string stdstring = name.toUTF8();
+				std::regex_match(stdstring.c_str(), match, prefixRegex);
+
+				return detail::split(Unicode::FromUTF8(match[1].str()), U"::");
+			}
+
+		public:
+
+			struct NodeClass
+			{
+				bool isFunction;
+				NodeOptions options;
+				GeneratorType generator;
+			};
+
+			struct Group
+			{
+				std::unordered_map<String, NodeClass> classes;
+				std::unordered_map<String, Group> namespaces;
+				String ToString(const String& prefix = U"")
+				{
+					String str;
+					for (auto& keyval : classes)
+					{
+						str += prefix + keyval.first + U"\n";
+					}
+					for (auto& keyval : namespaces)
+					{
+						str += keyval.second.ToString(prefix + keyval.first + U"::");
+					}
+					return str;
+				}
+			};
+
+			Group global;
+
+			//registerFunctionで登録された関数(Bytecodeから直接呼び出す)
+			FunctionTable functions;
+
+			template<class SubType>
+			void registerType(const NodeOptions& options = {})
+			{
+				Type type = Type::getType<SubType>();
+
+				auto names = parseNames(Unicode::FromUTF8(typeid(SubType).name()));
+
+				auto targetNamespace = std::ref(global);
+				for (size_t i = 0; i < names.size() - 1; i++)
+				{
+					targetNamespace = targetNamespace.get().namespaces[names[i]];
+				}
+				targetNamespace.get().classes.emplace(names[names.size() - 1], NodeClass{ false,options,createGenerator<SubType>(names.join(U"::",U"",U""),options) });
+			}
+
+			template<class FuncType, class Callable>
+			void registerFunction(const String& name, const Array<String>& argNames, const Callable& function, const NodeOptions& options = {})
+			{
+				auto names = parseNames(name);
+
+				auto targetNamespace = std::ref(global);
+				for (size_t i = 0; i < names.size() - 1; i++)
+				{
+					targetNamespace = targetNamespace.get().namespaces[names[i]];
+				}
+				const auto functionId = functions.add<FuncType>(names.join(U"::", U"", U""), function);
+				targetNamespace.get().classes.emplace(names[names.size() - 1], NodeClass{ true,options,createFuncGenerator<FuncType, Callable>(names.join(U"::",U"",U""),names[names.size() - 1],argNames,function,options,functions.id(),functionId) });
+			}
+
+			/// <summary>
+			/// 実行時に定義されるノードの種類(サブグラフなど)を登録する
+			/// </summary>
+			/// <remarks>
+			/// 同じ名前の種類が登録されていれば置き換える
+			/// </remarks>
+			void registerGenerator(const String& name, GeneratorType generator, const NodeOptions& options = {})
+			{
+				auto names = parseNames(name);
+
+				auto targetNamespace = std::ref(global);
+				for (size_t i = 0; i < names.size() - 1; i++)
+				{
+					targetNamespace = targetNamespace.get().namespaces[names[i]];
+				}
+				const auto className = names.join(U"::", U"", U"");
+				GeneratorType classGenerator = [=]()
+				{
+					auto inode = generator();
+					inode->Class = className;
+					applyOptions(*inode, options);
+					return inode;
+				};
+				targetNamespace.get().classes.insert_or_assign(names[names.size() - 1], NodeClass{ false,options,classGenerator });
+			}
+
+			/// <summary>
+			/// registerGeneratorで登録した種類を削除する
+			/// </summary>
+			void unregister(const String& name)
+			{
+				auto names = parseNames(name);
+
+				auto targetNamespace = std::ref(global);
+				for (size_t i = 0; i < names.size() - 1; i++)
+				{
+					targetNamespace = targetNamespace.get().namespaces[names[i]];
+				}
+				targetNamespace.get().classes.erase(names[names.size() - 1]);
+			}
+
+			/// <summary>
+			/// Graph::saveで保存したノードの配列からノードを生成して、ノードどうしの接続を復元する
+			/// </summary>
+			/// <remarks>
+			/// 保存されたノードの種類が登録されていない場合は例外を投げる
+			/// </remarks>
+			Array<std::shared_ptr<Node>> loadNodes(const JSONValue& json)
+			{
+				auto nodes = json.arrayView();
+				auto nodesCount = json.arrayCount();
+
+				Array<std::shared_ptr<Node>> result(nodesCount);
+
+				for (size_t i = 0; i < nodesCount; i++)
+				{
+					auto className = nodes[i][U"class"].getString();
+					auto inode = getNode(className);
+					if (inode)
+					{
+						auto node = (*inode);
+						node->deserialize(nodes[i]);
+						result[i] = node;
+					}
+					else
+					{
+						throw Error(U"クラス\"{}\"が見つかりませんでした"_fmt(className));
+					}
+				}
+
+				for (size_t i = 0; i < nodesCount; i++)
+				{
+					result[i]->deserializeSockets(nodes[i], result);
+				}
+
+				return result;
+			}
+
+			Optional<std::shared_ptr<Node>> getNode(const Type& type)
+			{
+				return getNode(parseNames(type.name()));
+			}
+
+			Optional<std::shared_ptr<Node>> getNode(const String& names)
+			{
+				return getNode(parseNames(names));
+			}
+
+			Optional<std::shared_ptr<Node>> getNode(const Array<String>& names)
+			{
+				auto targetNamespace = std::ref(global);
+				for (size_t i = 0; i < names.size() - 1; i++)
+				{
+					targetNamespace = targetNamespace.get().namespaces[names[i]];
+				}
+				auto result = targetNamespace.get().classes.find(names[names.size() - 1]);
+				if (result == targetNamespace.get().classes.end())
+				{
+					return none;
+				}
+				else
+				{
+					return result->second.generator();
+				}
+			}
+		};
+	}
+}
@@ -7,8 +7,11 @@ void NodeEditor::ISocket::disconnect(std::shared_ptr<ISocket> ptr)
 	for (auto outSocket : ptr->ConnectedSocket)
 	{
 		outSocket->ConnectedSocket.remove(ptr);
+		outSocket->detach();
 	}
 	ptr->ConnectedSocket.clear();
+	ptr->detach();
+	s_topologyVersion++;
 }
 
 bool NodeEditor::ISocket::canConnect(const ISocket& to)
@@ -32,6 +35,7 @@ void NodeEditor::ISocket::connectIO(std::shared_ptr<ISocket> in, std::shared_ptr
 
 	in->ConnectedSocket.push_back(out);
 	out->ConnectedSocket.push_back(in);
+	s_topologyVersion++;
 }
 
 void NodeEditor::ISocket::connect(std::shared_ptr<ISocket> from, std::shared_ptr<ISocket> to)
@@ -87,15 +91,78 @@ bool NodeEditor::ValueSocket::canConnectSameType(const ISocket& to)
 	return ValueType == valSocket.ValueType;
 }
 
-void NodeEditor::ValueSocket::setValue(std::any value)
+void NodeEditor::ValueSocket::setValue(const ValueSlot& value)
 {
-	if (!value.has_value() || value.type() != ValueType.TypeInfo())
+	if (value.typeId() != ValueType.id())
 	{
 		throw Error(U"指定された値が正しくありません");
 	}
 	m_value = value;
+	m_version = ++s_versionCounter;
+	if (m_source)
+	{
+		release();
+	}
+}
+
+void NodeEditor::ValueSocket::bind(const ValueSocket& source)
+{
+	if (m_source != &source)
+	{
+		if (m_source)
+		{
+			std::lock_guard lock(BindMutex(*m_source));
+			m_source->m_binders.remove(this);
+		}
+		{
+			std::lock_guard lock(BindMutex(source));
+			source.m_binders << this;
+		}
+		m_source = &source;
+		m_value.reset();
+	}
+	m_version = source.m_version;
+}
+
+void NodeEditor::ValueSocket::release()
+{
+	if (m_source)
+	{
+		std::lock_guard lock(BindMutex(*m_source));
+		m_source->m_binders.remove(this);
+		m_source = nullptr;
+	}
+}
+
+void NodeEditor::ValueSocket::detach()
+{
+	//参照していた値を引き継ぐ(大きな値は参照カウントが増えるだけ)
+	if (m_source)
+	{
+		m_value = m_source->m_value;
+		release();
+	}
+}
+
+NodeEditor::ValueSocket::~ValueSocket()
+{
+	//共通化されたノードやサブグラフの境界では接続していないソケットを参照しているので、
+	//先に破棄される側が参照を外す
+	if (m_source)
+	{
+		std::lock_guard lock(BindMutex(*m_source));
+		m_source->m_binders.remove(this);
+	}
+
+	std::lock_guard lock(BindMutex(*this));
+	for (auto binder : m_binders)
+	{
+		binder->m_value = m_value;
+		binder->m_source = nullptr;
+	}
 }
 
+#ifndef NODEEDITOR_HEADLESS
 Vec2 NodeEditor::ValueSocket::calcPos(const Config& cfg)
 {
 	switch (SocketType)
@@ -107,12 +174,14 @@ Vec2 NodeEditor::ValueSocket::calcPos(const Config& cfg)
 	}
 	return Vec2(0, 0);
 }
+#endif
 
 bool NodeEditor::ExecSocket::canConnectSameType(const ISocket&)
 {
 	return true;
 }
 
+#ifndef NODEEDITOR_HEADLESS
 Vec2 NodeEditor::ExecSocket::calcPos(const Config& cfg)
 {
 	switch (SocketType)
@@ -124,3 +193,4 @@ Vec2 NodeEditor::ExecSocket::calcPos(const Config& cfg)
 	}
 	return Vec2(0, 0);
 }
+#endif
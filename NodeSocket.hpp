@@ -1,16 +1,30 @@
 #pragma once
 #include<Siv3D.hpp>
+#include<array>
+#include<atomic>
+#include<mutex>
+#include"Serializable.hpp"
+#include"ValueSlot.hpp"
+#ifndef NODEEDITOR_HEADLESS
 #include"Config.hpp"
+#endif
 
 namespace NodeEditor
 {
 	class Node;
 
+	enum class IOType
+	{
+		Input, Output
+	};
+
 	class ISocket : public ISerializable
 	{
 	private:
 
 		static void connectIO(std::shared_ptr<ISocket> in, std::shared_ptr<ISocket> out);
+
+		static inline uint64 s_topologyVersion = 0;
 		
 	protected:
 
@@ -18,6 +32,9 @@ namespace NodeEditor
 		
 		virtual bool canConnectSameType(const ISocket& to) = 0;
 
+		//接続が切れたときに呼ばれる
+		virtual void detach() {}
+
 	public:
 
 		Node& Parent;
@@ -39,13 +56,23 @@ namespace NodeEditor
 
 		}
 
+#ifndef NODEEDITOR_HEADLESS
 		virtual Vec2 calcPos(const Config& cfg) = 0;
+#endif
 
 		bool canConnect(const ISocket& to);
 
 		static void disconnect(std::shared_ptr<ISocket> ptr);
 
 		static void connect(std::shared_ptr<ISocket> ptr, std::shared_ptr<ISocket> to);
+
+		/// <summary>
+		/// 接続/切断のたびに加算されるバージョン番号(実行計画の再構築判定用)
+		/// </summary>
+		static uint64 TopologyVersion()
+		{
+			return s_topologyVersion;
+		}
 		
 		//Jsonシリアライズ/デシリアライズ
 
@@ -58,10 +85,35 @@ namespace NodeEditor
 	{
 	private:
 
-		std::any m_value;
+		//値が変化するたびに割り当てられるバージョン番号(全てのソケットで一意)
+		static inline std::atomic<uint64> s_versionCounter = 0;
+
+		ValueSlot m_value;
+
+		uint64 m_version = 0;
+
+		//入力ソケットが値を参照している出力ソケット(参照していない場合はnullptr)
+		const ValueSocket* m_source = nullptr;
+
+		//この出力ソケットを参照している入力ソケット(接続していないソケットからも参照されるので、破棄するときに参照を外す)
+		mutable Array<ValueSocket*> m_binders;
+
+		//m_bindersを書き換えるときのロック(参照先が変わるときだけ取る)
+		//出力ソケットのアドレスで選ぶので、別のソケットやグラフの実行とはほとんど取り合わない
+		static inline std::array<std::mutex, 64> s_bindMutexes;
+
+		static std::mutex& BindMutex(const ValueSocket& source)
+		{
+			return s_bindMutexes[(reinterpret_cast<uintptr_t>(&source) / alignof(ValueSocket)) % s_bindMutexes.size()];
+		}
+
+		//参照している出力ソケットから参照を外す
+		void release();
 
 		bool canConnectSameType(const ISocket& to) override;
 
+		void detach() override;
+
 	public:
 
 		const Type ValueType;
@@ -73,14 +125,62 @@ namespace NodeEditor
 			singleConnect = socketType == IOType::Input;
 		}
 
-		std::any value() const
+		~ValueSocket();
+
+		/// <summary>
+		/// ソケットの値(出力ソケットを参照している入力ソケットでは、その出力ソケットの値)
+		/// </summary>
+		const ValueSlot& value() const
+		{
+			return m_source ? m_source->m_value : m_value;
+		}
+
+		bool hasValue() const
+		{
+			return value().hasValue();
+		}
+
+		/// <summary>
+		/// 値のバージョン番号
+		/// </summary>
+		/// <remarks>
+		/// 出力ソケットでは値が変化したときに更新され(別の出力ソケットを参照していればそのバージョン)、
+		/// 入力ソケットでは最後に参照した時点の出力ソケットのバージョンになる
+		/// </remarks>
+		uint64 version() const
+		{
+			return m_source && SocketType == IOType::Output ? m_source->m_version : m_version;
+		}
+
+		void setValue(const ValueSlot& value);
+
+		template<class T, std::enable_if_t<!std::is_same_v<std::decay_t<T>, ValueSlot>>* = nullptr>
+		void setValue(T&& value)
 		{
-			return m_value;
+			if (Type::getId<std::decay_t<T>>() != ValueType.id())
+			{
+				throw Error(U"指定された値が正しくありません");
+			}
+			m_value.set(std::forward<T>(value));
+			m_version = ++s_versionCounter;
+			if (m_source)
+			{
+				release();
+			}
 		}
 
-		void setValue(std::any value);
+		/// <summary>
+		/// 接続先の出力ソケットの値をコピーせずに参照し、そのバージョンを記録する
+		/// </summary>
+		/// <remarks>
+		/// 参照は接続が切れるかsetValueが呼ばれるまで続く。
+		/// 出力ソケットも、同じ値を出力する別の出力ソケットを参照できる(ExecutionPlanでまとめたノード)
+		/// </remarks>
+		void bind(const ValueSocket& source);
 
+#ifndef NODEEDITOR_HEADLESS
 		Vec2 calcPos(const Config& cfg) override;
+#endif
 	};
 
 	class ExecSocket : public ISocket
@@ -96,6 +196,8 @@ namespace NodeEditor
 			singleConnect = false;
 		}
 
+#ifndef NODEEDITOR_HEADLESS
 		Vec2 calcPos(const Config& cfg) override;
+#endif
 	};
 }
@@ -0,0 +1,68 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<chrono>
+
+namespace NodeEditor
+{
+	/// <summary>
+	/// ノードの実行時間の集計
+	/// </summary>
+	/// <remarks>
+	/// NODEEDITOR_PROFILEを定義したときのみ計測される。
+	/// 定義はエディタとランタイムのDebug構成だけで行い、Releaseでは計測しない。
+	/// </remarks>
+	struct NodeProfile
+	{
+		//実行した回数
+		uint64 calls = 0;
+
+		//childRun(関数テーブルから呼び出す場合は関数)にかかった時間の合計[ns]
+		uint64 totalNs = 0;
+
+		//直前の実行にかかった時間[ns]
+		uint64 lastNs = 0;
+
+		double averageNs() const
+		{
+			return calls ? static_cast<double>(totalNs) / calls : 0.0;
+		}
+	};
+
+#ifdef NODEEDITOR_PROFILE
+	namespace detail
+	{
+		//スコープを抜けるときに経過時間をprofileに加算する
+		class ProfileScope
+		{
+		private:
+
+			NodeProfile& m_profile;
+
+			std::chrono::steady_clock::time_point m_start;
+
+		public:
+
+			explicit ProfileScope(NodeProfile& profile)
+				:m_profile(profile),
+				m_start(std::chrono::steady_clock::now())
+			{
+
+			}
+
+			~ProfileScope()
+			{
+				const auto ns = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+				m_profile.calls++;
+				m_profile.totalNs += ns;
+				m_profile.lastNs = ns;
+			}
+		};
+	}
+#endif
+}
+
+#ifdef NODEEDITOR_PROFILE
+#define NODEEDITOR_PROFILE_SCOPE(profile) const ::NodeEditor::detail::ProfileScope nodeEditorProfileScope(profile)
+#else
+#define NODEEDITOR_PROFILE_SCOPE(profile)
+#endif
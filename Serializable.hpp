@@ -0,0 +1,14 @@
+#pragma once
+#include<Siv3D.hpp>
+
+namespace NodeEditor
+{
+	class ISerializable
+	{
+	public:
+
+		virtual void serialize(JSONWriter&) const = 0;
+
+		virtual void deserialize(const JSONValue&) = 0;
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include<Siv3D.hpp>
+#include"Node.hpp"
+
+//テスト(Tests)とベンチマーク(Benchmark)で共通の小さなノード
+namespace SampleNodes
+{
+	//実行ソケットの起点
+	class EntryNode : public NodeEditor::Node
+	{
+	public:
+
+		EntryNode()
+		{
+			Name = U"Entry";
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//評価されるたびに1ずつ増える値を出力する(入力の無い、Pureでない生成元)
+	template<class T = int32>
+	class CounterNode : public NodeEditor::Node
+	{
+	private:
+
+		void childRun() override
+		{
+			setOutput(0, ++value);
+		}
+
+	public:
+
+		T value = 0;
+
+		CounterNode()
+		{
+			Name = U"Counter";
+			cfgOutputSockets({ {Type::getType<T>(),U"value"} });
+		}
+	};
+
+	//実行されたときの全ての入力の合計を記録する
+	template<class T = int32>
+	class SinkNode : public NodeEditor::Node
+	{
+	private:
+
+		size_t m_inputCount;
+
+		void childRun() override
+		{
+			runs++;
+			value = 0;
+			for (size_t i = 0; i < m_inputCount; i++)
+			{
+				value += getInput<T>(i);
+			}
+			sum += value;
+		}
+
+		void childSerialize(JSONWriter& writer) const override
+		{
+			writer.write(sum);
+		}
+
+		void childDeserialize(const JSONValue& json) override
+		{
+			sum = json.get<T>();
+		}
+
+	public:
+
+		size_t runs = 0;
+
+		T value = 0;
+
+		//これまでに受け取った値の合計
+		T sum = 0;
+
+		explicit SinkNode(size_t inputCount = 1)
+			:m_inputCount(inputCount)
+		{
+			Name = U"Sink";
+			cfgInputSockets(Array<std::pair<Type, String>>(inputCount, { Type::getType<T>(),U"value" }));
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+}
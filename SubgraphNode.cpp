@@ -0,0 +1,220 @@
+#include"SubgraphNode.hpp"
+#include"NodeGenerator.hpp"
+
+std::shared_ptr<NodeEditor::SubgraphDefinition> NodeEditor::SubgraphDefinition::Create(const String& name, const Array<std::shared_ptr<Node>>& nodes)
+{
+	auto definition = std::make_shared<SubgraphDefinition>();
+	definition->Name = name;
+
+	std::unordered_set<const Node*> inside;
+	for (const auto& node : nodes)
+	{
+		inside.emplace(node.get());
+	}
+
+	const auto outside = [&inside](const std::shared_ptr<ISocket>& socket)
+	{
+		return inside.find(&socket->Parent) == inside.end();
+	};
+
+	//外の生成元の出力ソケットごとの入力の番号
+	std::unordered_map<const ISocket*, size_t> inputIndex;
+
+	JSONWriter writer;
+	writer.startObject();
+	{
+		writer.key(U"nodes").startArray();
+		for (const auto& node : nodes)
+		{
+			//外とつながるソケットも書き出されるが、instantiateでは内部のノードとの接続だけが復元される
+			node->serialize(writer);
+
+			for (const auto& inSocket : node->getInputSockets())
+			{
+				if (inSocket->ConnectedSocket && outside(inSocket->ConnectedSocket[0]))
+				{
+					const auto [itr, inserted] = inputIndex.emplace(inSocket->ConnectedSocket[0].get(), definition->Inputs.size());
+					if (inserted)
+					{
+						definition->Inputs << Port{ inSocket->Name, {} };
+					}
+					definition->Inputs[itr->second].sockets << SocketRef{ node->ID, inSocket->Index };
+				}
+			}
+
+			for (const auto& outSocket : node->getOutputSockets())
+			{
+				if (outSocket->ConnectedSocket.includes_if(outside))
+				{
+					definition->Outputs << Port{ outSocket->Name, { SocketRef{ node->ID, outSocket->Index } } };
+				}
+			}
+
+			for (const auto& prevSocket : node->getPrevNodeSockets())
+			{
+				if (prevSocket->ConnectedSocket.includes_if(outside))
+				{
+					definition->ExecInputs << Port{ prevSocket->Name, { SocketRef{ node->ID, prevSocket->Index } } };
+				}
+			}
+
+			for (const auto& nextSocket : node->getNextNodeSockets())
+			{
+				if (nextSocket->ConnectedSocket.includes_if(outside))
+				{
+					definition->ExecOutputs << Port{ nextSocket->Name, { SocketRef{ node->ID, nextSocket->Index } } };
+				}
+			}
+		}
+		writer.endArray();
+	}
+	writer.endObject();
+
+	definition->Body = writer.get();
+
+	return definition;
+}
+
+Array<std::shared_ptr<NodeEditor::Node>> NodeEditor::SubgraphDefinition::instantiate(detail::NodeGenerator& generator) const
+{
+	const auto body = Body.toUTF8();
+	const JSONReader json(ByteArray(body.data(), body.size()));
+
+	return generator.loadNodes(json[U"nodes"]);
+}
+
+void NodeEditor::SubgraphDefinition::serialize(JSONWriter& writer) const
+{
+	const auto writePorts = [&writer](const String& key, const Array<Port>& ports)
+	{
+		writer.key(key).startArray();
+		for (const auto& port : ports)
+		{
+			writer.startObject();
+			{
+				writer.key(U"name").write(port.name);
+				writer.key(U"sockets").startArray();
+				for (const auto& socket : port.sockets)
+				{
+					writer.startObject();
+					{
+						writer.key(U"nodeID").write(socket.nodeID);
+						writer.key(U"socketIndex").write(socket.socketIndex);
+					}
+					writer.endObject();
+				}
+				writer.endArray();
+			}
+			writer.endObject();
+		}
+		writer.endArray();
+	};
+
+	writer.startObject();
+	{
+		writer.key(U"name").write(Name);
+
+		writePorts(U"inputs", Inputs);
+
+		writePorts(U"outputs", Outputs);
+
+		writePorts(U"execInputs", ExecInputs);
+
+		writePorts(U"execOutputs", ExecOutputs);
+
+		writer.key(U"body").write(Body);
+	}
+	writer.endObject();
+}
+
+void NodeEditor::SubgraphDefinition::deserialize(const JSONValue& json)
+{
+	const auto readPorts = [&json](const String& key)
+	{
+		Array<Port> ports;
+		for (const auto& portJson : json[key].arrayView())
+		{
+			auto& port = ports.emplace_back();
+			port.name = portJson[U"name"].getString();
+			for (const auto& socketJson : portJson[U"sockets"].arrayView())
+			{
+				port.sockets << SocketRef{ socketJson[U"nodeID"].get<size_t>(), socketJson[U"socketIndex"].get<size_t>() };
+			}
+		}
+		return ports;
+	};
+
+	Name = json[U"name"].getString();
+
+	Inputs = readPorts(U"inputs");
+
+	Outputs = readPorts(U"outputs");
+
+	ExecInputs = readPorts(U"execInputs");
+
+	ExecOutputs = readPorts(U"execOutputs");
+
+	Body = json[U"body"].getString();
+}
+
+NodeEditor::SubgraphNode::SubgraphNode(std::shared_ptr<const SubgraphDefinition> definition, Array<std::shared_ptr<Node>> nodes)
+	:m_definition(std::move(definition)),
+	m_nodes(std::move(nodes))
+{
+	Name = m_definition->Name;
+
+	const auto findNode = [this](const SubgraphDefinition::SocketRef& socket) -> const Node&
+	{
+		for (const auto& node : m_nodes)
+		{
+			if (node->ID == socket.nodeID)
+			{
+				return *node;
+			}
+		}
+		throw Error(U"サブグラフ\"{}\"の内部にID{}のノードが見つかりませんでした"_fmt(Name, socket.nodeID));
+	};
+
+	Array<std::pair<Type, String>> inputs;
+	for (const auto& port : m_definition->Inputs)
+	{
+		auto& targets = m_inputTargets.emplace_back();
+		for (const auto& socket : port.sockets)
+		{
+			targets << findNode(socket).getInputSockets().at(socket.socketIndex);
+		}
+		inputs.emplace_back(targets.front()->ValueType, port.name);
+	}
+
+	Array<std::pair<Type, String>> outputs;
+	for (const auto& port : m_definition->Outputs)
+	{
+		const auto& socket = port.sockets.front();
+		m_outputSources << findNode(socket).getOutputSockets().at(socket.socketIndex);
+		outputs.emplace_back(m_outputSources.back()->ValueType, port.name);
+	}
+
+	Array<String> execInputs;
+	for (const auto& port : m_definition->ExecInputs)
+	{
+		auto& entries = m_execEntries.emplace_back();
+		for (const auto& socket : port.sockets)
+		{
+			entries << findNode(socket).getPrevNodeSockets().at(socket.socketIndex);
+		}
+		execInputs << port.name;
+	}
+
+	Array<String> execOutputs;
+	for (const auto& port : m_definition->ExecOutputs)
+	{
+		const auto& socket = port.sockets.front();
+		m_execExits << findNode(socket).getNextNodeSockets().at(socket.socketIndex);
+		execOutputs << port.name;
+	}
+
+	cfgPrevExecSocket(execInputs);
+	cfgInputSockets(inputs);
+	cfgNextExecSocket(execOutputs);
+	cfgOutputSockets(outputs);
+}
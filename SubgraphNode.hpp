@@ -0,0 +1,161 @@
+#pragma once
+#include<Siv3D.hpp>
+#include"Node.hpp"
+#include"Serializable.hpp"
+
+namespace NodeEditor
+{
+	namespace detail
+	{
+		class NodeGenerator;
+	}
+
+	/// <summary>
+	/// サブグラフ(複数のノードをまとめて1つのノードとして使うもの)の定義
+	/// </summary>
+	/// <remarks>
+	/// 内部のノードはGraph::saveと同じ形式で保持し、SubgraphNodeを生成するたびにそこから内部のノードを生成する。
+	/// 境界を越える接続はポートとして、内部のノードのIDとソケットの番号で記録する。
+	/// </remarks>
+	class SubgraphDefinition : public ISerializable
+	{
+	public:
+
+		//内部のノードのソケット
+		struct SocketRef
+		{
+			size_t nodeID;
+			size_t socketIndex;
+		};
+
+		struct Port
+		{
+			String name;
+
+			//入力(値/実行)ではつながっている内部のソケット全て、出力(値/実行)では1つ
+			Array<SocketRef> sockets;
+		};
+
+		String Name;
+
+		Array<Port> Inputs;
+
+		Array<Port> Outputs;
+
+		Array<Port> ExecInputs;
+
+		Array<Port> ExecOutputs;
+
+		//内部のノード(Graph::saveと同じ形式のJSON)
+		String Body;
+
+		/// <summary>
+		/// nodesをまとめた定義を作る
+		/// </summary>
+		/// <remarks>
+		/// nodesの外から入力される値は生成元のソケットごとに1つの入力に、nodesの外で使われる出力はソケットごとに1つの出力になる。
+		/// 実行ソケットはnodesの外とつながっているソケットごとに1つのポートになる。
+		/// </remarks>
+		static std::shared_ptr<SubgraphDefinition> Create(const String& name, const Array<std::shared_ptr<Node>>& nodes);
+
+		/// <summary>
+		/// 登録されるノードのクラス名
+		/// </summary>
+		String className() const
+		{
+			return U"Subgraph::" + Name;
+		}
+
+		/// <summary>
+		/// 内部のノードを生成して、内部どうしの接続を復元する
+		/// </summary>
+		/// <remarks>
+		/// 内部のノードの種類が登録されていない場合は例外を投げる
+		/// </remarks>
+		Array<std::shared_ptr<Node>> instantiate(detail::NodeGenerator& generator) const;
+
+		void serialize(JSONWriter& writer) const override;
+
+		void deserialize(const JSONValue& json) override;
+	};
+
+	/// <summary>
+	/// サブグラフの定義を参照し、エディタ上では1つのノードとして表示されるノード
+	/// </summary>
+	/// <remarks>
+	/// 内部のノードはインスタンスごとに生成して保持するが、Graphのノードの一覧には含めない(更新・描画・保存の対象にならない)。
+	/// 内部のノードのIDはGraphに追加したときに、グラフ内で重複しないように割り当て直される。
+	/// 内部のノードのエラーは、このノードの吹き出しに表示される(errorSource)。
+	/// 実行計画(ExecutionPlan、Bytecode、Batch)は生成時に境界の接続を内部のノードへ付け替えて展開するので、
+	/// このノード自身は実行されず、実行時の呼び出しのオーバーヘッドもない。
+	/// 出力の値はこのノードではなく、outputSourceの内部のソケットに設定される。
+	/// </remarks>
+	class SubgraphNode : public Node
+	{
+		friend class ExecutionPlan;
+
+		friend class Graph;
+
+	private:
+
+		std::shared_ptr<const SubgraphDefinition> m_definition;
+
+		Array<std::shared_ptr<Node>> m_nodes;
+
+		//入力ソケットごとの、値を受け取る内部の入力ソケット
+		Array<Array<std::shared_ptr<ValueSocket>>> m_inputTargets;
+
+		//出力ソケットごとの、値を出力する内部の出力ソケット
+		Array<std::shared_ptr<ValueSocket>> m_outputSources;
+
+		//前の実行ソケットごとの、実行する内部のノードの前の実行ソケット
+		Array<Array<std::shared_ptr<ExecSocket>>> m_execEntries;
+
+		//次の実行ソケットごとの、内部のノードの次の実行ソケット
+		Array<std::shared_ptr<ExecSocket>> m_execExits;
+
+	public:
+
+		SubgraphNode(std::shared_ptr<const SubgraphDefinition> definition, Array<std::shared_ptr<Node>> nodes);
+
+		const SubgraphDefinition& definition() const
+		{
+			return *m_definition;
+		}
+
+		/// <summary>
+		/// 内部のノード
+		/// </summary>
+		const Array<std::shared_ptr<Node>>& nodes() const
+		{
+			return m_nodes;
+		}
+
+		/// <summary>
+		/// 自身か内部のノード(入れ子のサブグラフの内部を含む)のうち、最初に見つかった失敗したノード
+		/// </summary>
+		const Node* errorSource() const override
+		{
+			if (const auto self = Node::errorSource())
+			{
+				return self;
+			}
+			for (const auto& node : m_nodes)
+			{
+				if (const auto source = node->errorSource())
+				{
+					return source;
+				}
+			}
+			return nullptr;
+		}
+
+		/// <summary>
+		/// index番目の出力の値を持つ内部の出力ソケット
+		/// </summary>
+		const ValueSocket& outputSource(size_t index) const
+		{
+			return *m_outputSources[index];
+		}
+	};
+}
@@ -84,6 +84,7 @@ namespace Value
 				if (result)
 				{
 					m_value = result.value();
+					constantChanged();
 				}
 				else
 				{
@@ -118,6 +119,7 @@ namespace Value
 		void childDeserialize(const JSONValue& json) override
 		{
 			m_value = json.get<decltype(m_value)>();
+			constantChanged();
 			if (m_textbox)
 			{
 				m_textbox->setText(Format(m_value));
@@ -133,6 +135,8 @@ namespace Value
 			ChildSize = SizeF(1, 0);
 
 			Name = U"Int32";
+
+			Constant = true;
 		}
 	};
 }
@@ -244,6 +248,31 @@ namespace Input
 	};
 }
 
+namespace Flow
+{
+	class DelayNode : public NodeEditor::AsyncNode
+	{
+	private:
+
+		NodeEditor::AsyncTask childRunAsync() override
+		{
+			const double seconds = getInput<double>(0);
+			co_await NodeEditor::Async::Delay(Duration(seconds));
+		}
+
+	public:
+
+		DelayNode()
+		{
+			cfgInputSockets({ {Type::getType<double>(),U"Seconds"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+
+			Name = U"Delay";
+		}
+	};
+}
+
 void RegisterNodes(NodeEditor::NodeEditor& editor, P2Body& player)
 {
 	editor.registerNodeType<UpdateFrameNode>(false);
@@ -253,6 +282,8 @@ void RegisterNodes(NodeEditor::NodeEditor& editor, P2Body& player)
 	editor.registerNodeType<Input::KeyDownNode>();
 	editor.registerNodeType<Input::KeyLeftNode>();
 	editor.registerNodeType<Input::KeyRightNode>();
+	editor.registerNodeType<Flow::DelayNode>();
+	editor.registerBuiltinNodes();
 
 	editor.registerNodeFunction<void(Point)>(U"Player::AddForce", { U"Point" }, [&](Point point)
 		{
@@ -262,7 +293,7 @@ void RegisterNodes(NodeEditor::NodeEditor& editor, P2Body& player)
 	editor.registerNodeFunction<Point(int, int)>(U"Point::Point(int,int)", { U"Point",U"x",U"y" }, [](int x, int y)
 		{
 			return Point(x, y);
-		});
+		}, NodeEditor::NodeOptions{ .pure = true, .threadSafe = true });
 }
 
 void Main()
@@ -278,6 +309,8 @@ void Main()
 	Size nodeEditorSize(Scene::Width(), editorHeight);
 
 	NodeEditor::NodeEditor editor(nodeEditorSize);
+	editor.config().ShowProfile = true;
+	editor.config().DimDeadNodes = true;
 
 	// 2D 物理演算
 	Camera2D camera(Vec2(0, 0), 20.0, Camera2DParameters::NoControl());
@@ -342,7 +375,8 @@ void Main()
 			gripRect.draw();
 		}
 
-		updateNode->run();
+		//重いグラフでもフレームが止まらないよう、1フレームに使う時間を制限して実行する
+		updateNode->runFor(5ms);
 		plus.setAngle(Periodic::Sawtooth0_1(2s) * Math::TwoPi);
 		camera.setTargetCenter(player.getPos());
 
@@ -0,0 +1,188 @@
+#include"Tests.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//valueを出力する(バッチ実行ではsetInputで列を与える)
+	class SourceNode : public Node
+	{
+	private:
+
+		void childRun() override
+		{
+			setOutput(0, value);
+		}
+
+	public:
+
+		double value = 0;
+
+		SourceNode()
+		{
+			Name = U"Source";
+			cfgOutputSockets({ {Type::getType<double>(),U"value"} });
+		}
+	};
+
+	//NaNどうしも同じ値として比べる
+	bool SameValue(double a, double b)
+	{
+		return (a == b) || (std::isnan(a) && std::isnan(b));
+	}
+
+	//列の演算は4要素ずつの部分と端数の部分のどちらでも、1要素ずつ計算した結果と一致する
+	Tests::Result ColumnKernels()
+	{
+		return Tests::Run(U"Batch", U"ColumnKernels", [](const Tests::Expect& expect)
+			{
+				using Arithmetic = void(*)(const double*, const double*, Array<double>&, size_t);
+				using Comparison = void(*)(const double*, const double*, Array<bool>&, size_t);
+
+				const std::pair<String, Arithmetic> arithmetics[] =
+				{
+					{ U"Add", Builtin::detail::AddColumns },
+					{ U"Subtract", Builtin::detail::SubtractColumns },
+					{ U"Multiply", Builtin::detail::MultiplyColumns },
+					{ U"Divide", Builtin::detail::DivideColumns },
+				};
+				const std::function<double(double, double)> arithmeticScalars[] =
+				{
+					[](double a, double b) { return a + b; },
+					[](double a, double b) { return a - b; },
+					[](double a, double b) { return a * b; },
+					[](double a, double b) { return a / b; },
+				};
+				const std::pair<String, Comparison> comparisons[] =
+				{
+					{ U"Less", Builtin::detail::LessColumns },
+					{ U"Greater", Builtin::detail::GreaterColumns },
+					{ U"Equal", Builtin::detail::EqualColumns },
+				};
+				const std::function<bool(double, double)> comparisonScalars[] =
+				{
+					[](double a, double b) { return a < b; },
+					[](double a, double b) { return a > b; },
+					[](double a, double b) { return a == b; },
+				};
+
+				//4の倍数でない長さと、NaN・0除算・等しい値を含める
+				for (const size_t count : { 0, 1, 3, 4, 5, 7, 8, 9, 1003 })
+				{
+					Array<double> a(count), b(count);
+					for (size_t i = 0; i < count; i++)
+					{
+						a[i] = static_cast<double>(i % 7) - 3.0;
+						b[i] = (i % 5 == 0) ? a[i] : static_cast<double>(i % 3) - 1.0;
+					}
+					if (count > 2)
+					{
+						a[count - 2] = std::numeric_limits<double>::quiet_NaN();
+					}
+
+					for (size_t op = 0; op < std::size(arithmetics); op++)
+					{
+						Array<double> result(count);
+						arithmetics[op].second(a.data(), b.data(), result, count);
+						for (size_t i = 0; i < count; i++)
+						{
+							if (!SameValue(result[i], arithmeticScalars[op](a[i], b[i])))
+							{
+								expect(false, U"{} count={}: {}番目が異なる"_fmt(arithmetics[op].first, count, i));
+								break;
+							}
+						}
+					}
+
+					for (size_t op = 0; op < std::size(comparisons); op++)
+					{
+						Array<bool> result(count);
+						comparisons[op].second(a.data(), b.data(), result, count);
+						for (size_t i = 0; i < count; i++)
+						{
+							if (result[i] != comparisonScalars[op](a[i], b[i]))
+							{
+								expect(false, U"{} count={}: {}番目が異なる"_fmt(comparisons[op].first, count, i));
+								break;
+							}
+						}
+					}
+				}
+			});
+	}
+
+	//列全体を計算するノードと要素ごとに実行する関数のノードが混ざっても、要素ごとの計算と一致する
+	Tests::Result BatchMatchesScalar()
+	{
+		return Tests::Run(U"Batch", U"BatchMatchesScalar", [](const Tests::Expect& expect)
+			{
+				constexpr size_t Count = 1001;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<double(double, double)>(U"Mix", { U"result",U"a",U"b" }, [](double a, double b)
+					{
+						return a * 10 + b;
+					}, NodeOptions{ .pure = true });
+
+				auto a = std::make_shared<SourceNode>();
+				auto b = std::make_shared<SourceNode>();
+				graph.addNode(a);
+				graph.addNode(b);
+				auto subtract = *graph.addNode<Builtin::SubtractNode>();
+				auto mix = *graph.addNode(U"Mix");
+				auto less = *graph.addNode<Builtin::LessNode>();
+
+				//(a - b) < Mix(a, b)
+				Fixtures::ConnectValue(a, 0, subtract, 0);
+				Fixtures::ConnectValue(b, 0, subtract, 1);
+				Fixtures::ConnectValue(a, 0, mix, 0);
+				Fixtures::ConnectValue(b, 0, mix, 1);
+				Fixtures::ConnectValue(subtract, 0, less, 0);
+				Fixtures::ConnectValue(mix, 0, less, 1);
+
+				Array<double> as(Count), bs(Count);
+				for (size_t i = 0; i < Count; i++)
+				{
+					as[i] = static_cast<double>(i % 11) - 5.0;
+					bs[i] = static_cast<double>(i % 13) * 0.5 - 3.0;
+				}
+
+				const auto batch = Batch::Compile(*less);
+				batch->setInput(*a->getOutputSockets()[0], Column(as));
+				batch->setInput(*b->getOutputSockets()[0], Column(bs));
+				expect(batch->run(Count), U"run失敗");
+
+				const auto difference = batch->column(*subtract->getOutputSockets()[0]);
+				const auto mixed = batch->column(*mix->getOutputSockets()[0]);
+				const auto result = batch->column(*less->getOutputSockets()[0]);
+				expect(difference && mixed && result && result->size() == Count, U"列が出力されない");
+				if (!difference || !mixed || !result)
+				{
+					return;
+				}
+				expect(difference->tryGet<double>() && result->tryGet<bool>(), U"組み込みのノードが列全体で計算されない");
+
+				for (size_t i = 0; i < Count; i++)
+				{
+					const double expectedDifference = as[i] - bs[i];
+					const double expectedMix = as[i] * 10 + bs[i];
+					if (difference->at(i).get<double>() != expectedDifference || mixed->at(i).get<double>() != expectedMix || result->at(i).get<bool>() != (expectedDifference < expectedMix))
+					{
+						expect(false, U"{}番目が異なる"_fmt(i));
+						break;
+					}
+				}
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunBatch()
+{
+	Array<Result> results;
+
+	results << ColumnKernels();
+	results << BatchMatchesScalar();
+
+	return results;
+}
@@ -0,0 +1,141 @@
+#include"Tests.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//関数の番号は登録したグラフの関数テーブルでだけ有効で、別のグラフで変換したノードはchildRunで実行する
+	Tests::Result FunctionTableOwnership()
+	{
+		return Tests::Run(U"Bytecode", U"FunctionTableOwnership", [](const Tests::Expect& expect)
+			{
+				//同じ順序で登録するので、TwiceとNegateには同じ番号が割り当てられる
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32)>(U"Twice", { U"result",U"a" }, [](int32 a)
+					{
+						return a * 2;
+					}, NodeOptions{ .pure = true });
+
+				Graph other;
+				Tests::RegisterNodes(other);
+				other.registerNodeFunction<int32(int32)>(U"Negate", { U"result",U"a" }, [](int32 a)
+					{
+						return -a;
+					}, NodeOptions{ .pure = true });
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto constant = *graph.addNode<Fixtures::ConstantNode>();
+				auto twice = *graph.addNode(U"Twice");
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+
+				std::dynamic_pointer_cast<Fixtures::ConstantNode>(constant)->setValue(3);
+				Fixtures::ConnectValue(constant, 0, twice, 0);
+				Fixtures::ConnectValue(twice, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				const auto own = graph.compile(*entry);
+				own->run();
+				expect(own->callCount() == 1, U"同じグラフ: calls={}"_fmt(own->callCount()));
+				expect(sink->value == 6, U"同じグラフ: sink={}"_fmt(sink->value));
+
+				const auto foreign = other.compile(*entry);
+				foreign->run();
+				expect(foreign->callCount() == 0, U"別のグラフ: calls={}"_fmt(foreign->callCount()));
+				expect(sink->value == 6, U"別のグラフ: sink={}"_fmt(sink->value));
+
+				//番号が範囲内でも、ノードを生成していないテーブルの関数は呼び出さない
+				FunctionTable empty;
+				empty.add<int32(int32)>(U"Zero", [](int32) { return 0; });
+				const auto unrelated = Bytecode::Compile(*entry, empty);
+				unrelated->run();
+				expect(unrelated->callCount() == 0 && sink->value == 6, U"別のテーブル: calls={}, sink={}"_fmt(unrelated->callCount(), sink->value));
+			});
+	}
+
+	//インスタンスごとの値を出力し、負の値なら例外を送出する
+	class CheckedNode : public Node
+	{
+	private:
+
+		int32 m_value = 0;
+
+		void childRun() override
+		{
+			if (m_value < 0)
+			{
+				throw Error(U"negative {}"_fmt(m_value));
+			}
+			setOutput(0, m_value);
+		}
+
+		void saveState(ValueSlot& state) const override
+		{
+			state.set(m_value);
+		}
+
+		void loadState(const ValueSlot& state) override
+		{
+			m_value = state.get<int32>();
+		}
+
+	public:
+
+		CheckedNode()
+		{
+			Name = U"Checked";
+			cfgOutputSockets({ {Type::getType<int32>(),U"value"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+
+			InstanceState = true;
+		}
+	};
+
+	//共有しているノードのエラーは、最後に実行したインスタンスのものではなくインスタンスごとに取得できる
+	Tests::Result InstanceErrors()
+	{
+		return Tests::Run(U"Bytecode", U"InstanceErrors", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto checked = std::make_shared<CheckedNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+
+				Fixtures::ConnectValue(checked, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, checked);
+				Fixtures::ConnectExec(checked, 0, sink);
+
+				FunctionTable functions;
+				InstanceSet set(Bytecode::Compile(*entry, functions), 3);
+				set.state(0, *checked).set(int32(1));
+				set.state(1, *checked).set(int32(-2));
+				set.state(2, *checked).set(int32(3));
+
+				set.run();
+				expect(!set.failed(0) && !set.failed(2), U"成功したインスタンスにエラーがある");
+				expect(set.failed(1), U"失敗したインスタンスにエラーがない");
+
+				const auto error = set.error(1, *checked);
+				expect(error.code == NodeErrorCode::Exception && error.message == U"negative -2", U"instance 1: code={}, message={}"_fmt(static_cast<int32>(error.code), error.message));
+				expect(!set.error(1, *sink), U"実行していないノードのエラーがある");
+
+				//ノード自身には最後に実行したインスタンスのエラー(無し)が残る
+				expect(!checked->getError(), U"最後のインスタンスのエラーでない");
+
+				//次の実行で成功すればエラーは消える
+				set.state(1, *checked).set(int32(2));
+				set.run();
+				expect(!set.failed(1) && !set.error(1, *checked), U"再実行後: エラーが残っている");
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunBytecode()
+{
+	Array<Result> results;
+
+	results << FunctionTableOwnership();
+	results << InstanceErrors();
+
+	return results;
+}
@@ -0,0 +1,950 @@
+#include"Tests.hpp"
+#include"AsyncNode.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//関数テーブルのfunctionId番の関数を呼ぶPureな関数のノード
+	template<class FuncType>
+	class PureFunctionNode : public detail::FunctionNode<FuncType>
+	{
+	public:
+
+		PureFunctionNode(uint32 functionId, const Array<String>& socketNames, std::function<FuncType> function)
+			:detail::FunctionNode<FuncType>(U"", socketNames, function)
+		{
+			this->Pure = true;
+			this->FunctionId = functionId;
+		}
+	};
+
+	//1回のパスで、複数のブロックから使われる生成元も、2つの経路から合流する生成元(ダイアモンド)も1度だけ評価される
+	Tests::Result ProducerOncePerPass()
+	{
+		return Tests::Run(U"ExecutionPlan", U"ProducerOncePerPass", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto counter = std::make_shared<Fixtures::CounterNode<>>();
+				auto twice = std::make_shared<Fixtures::DoubleNode>();
+				auto first = std::make_shared<Fixtures::SinkNode<>>();
+				auto second = std::make_shared<Fixtures::SinkNode<>>();
+				//counter -> twice -> join と counter -> other -> join の2つの経路が合流する
+				auto other = std::make_shared<Fixtures::DoubleNode>();
+				auto join = std::make_shared<Fixtures::SinkNode<>>(2);
+
+				Fixtures::ConnectValue(counter, 0, twice, 0);
+				Fixtures::ConnectValue(counter, 0, other, 0);
+				Fixtures::ConnectValue(twice, 0, first, 0);
+				Fixtures::ConnectValue(twice, 0, second, 0);
+				Fixtures::ConnectValue(twice, 0, join, 0);
+				Fixtures::ConnectValue(other, 0, join, 1);
+				Fixtures::ConnectExec(entry, 0, first);
+				Fixtures::ConnectExec(first, 0, second);
+				Fixtures::ConnectExec(second, 0, join);
+
+				entry->run();
+				expect(counter->value == 1, U"counter={}"_fmt(counter->value));
+				expect(twice->runs == 1 && other->runs == 1, U"twice.runs={}, other.runs={}"_fmt(twice->runs, other->runs));
+				expect(first->value == 2 && second->value == 2, U"first={}, second={}"_fmt(first->value, second->value));
+				expect(join->value == 4, U"join={}"_fmt(join->value));
+
+				entry->run();
+				expect(counter->value == 2, U"2回目: counter={}"_fmt(counter->value));
+				expect(twice->runs == 2 && other->runs == 2, U"2回目: twice.runs={}, other.runs={}"_fmt(twice->runs, other->runs));
+				expect(first->value == 4 && second->value == 4, U"2回目: first={}, second={}"_fmt(first->value, second->value));
+				expect(join->value == 8, U"2回目: join={}"_fmt(join->value));
+			});
+	}
+
+	//failがtrueなら例外を送出し、falseなら1を出力する
+	class FailingNode : public Node
+	{
+	private:
+
+		void childRun() override
+		{
+			if (fail)
+			{
+				throw Error(U"failed");
+			}
+			setOutput(0, 1);
+		}
+
+	public:
+
+		bool fail = true;
+
+		FailingNode()
+		{
+			Name = U"Failing";
+			cfgOutputSockets({ {Type::getType<int32>(),U"value"} });
+		}
+	};
+
+	//生成元が失敗したら、その出力を使うノードは前回の値で実行せずに失敗を伝える
+	Tests::Result SkipFailedProducer()
+	{
+		return Tests::Run(U"ExecutionPlan", U"SkipFailedProducer", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto failing = std::make_shared<FailingNode>();
+				auto twice = std::make_shared<Fixtures::DoubleNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+				auto next = std::make_shared<Fixtures::StepNode>();
+
+				Fixtures::ConnectValue(failing, 0, twice, 0);
+				Fixtures::ConnectValue(twice, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+				Fixtures::ConnectExec(sink, 0, next);
+
+				failing->fail = false;
+				entry->run();
+				expect(sink->runs == 1 && sink->value == 2, U"成功: sink.runs={}, value={}"_fmt(sink->runs, sink->value));
+
+				//前回の出力が残っていても使わない
+				failing->fail = true;
+				entry->run();
+				expect(failing->getError().code == NodeErrorCode::Exception, U"failing: code={}"_fmt(static_cast<int32>(failing->getError().code)));
+				expect(twice->getError().code == NodeErrorCode::InputFailed, U"twice: code={}"_fmt(static_cast<int32>(twice->getError().code)));
+				expect(sink->getError().code == NodeErrorCode::InputFailed && sink->getError().socketIdx == 0, U"sink: code={}"_fmt(static_cast<int32>(sink->getError().code)));
+				expect(sink->runs == 1 && twice->runs == 1, U"失敗: sink.runs={}, twice.runs={}"_fmt(sink->runs, twice->runs));
+				expect(next->runs == 0, U"失敗: next.runs={}"_fmt(next->runs));
+
+				failing->fail = false;
+				entry->run();
+				expect(!sink->getError() && sink->runs == 2 && next->runs == 1, U"復帰: sink.runs={}, next.runs={}"_fmt(sink->runs, next->runs));
+			});
+	}
+
+	//10万ステップの実行は上限の既定値で最後まで進み、上限を下げると超えたノードで中断してエラーを記録する
+	Tests::Result StepLimit()
+	{
+		return Tests::Run(U"ExecutionPlan", U"StepLimit", [](const Tests::Expect& expect)
+			{
+				constexpr size_t Count = 100000;
+
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				Array<std::shared_ptr<Fixtures::StepNode>> steps;
+				for (size_t i = 0; i < Count; i++)
+				{
+					steps << std::make_shared<Fixtures::StepNode>();
+					Fixtures::ConnectExec(i == 0 ? std::shared_ptr<Node>(entry) : steps[i - 1], 0, steps[i]);
+				}
+
+				const auto plan = ExecutionPlan::Compile(*entry);
+				plan->run();
+				expect(!plan->statistics().interrupted && plan->statistics().steps == Count + 1, U"steps={}"_fmt(plan->statistics().steps));
+				expect(steps.back()->runs == 1, U"last.runs={}"_fmt(steps.back()->runs));
+
+				//起点ノードを含めて50000ステップまで進み、50001ステップ目のノードで中断する
+				const size_t stepLimit = ExecutionPlan::StepLimit();
+				ExecutionPlan::SetStepLimit(Count / 2);
+				plan->run();
+				ExecutionPlan::SetStepLimit(stepLimit);
+
+				const auto& stopped = steps[Count / 2 - 1];
+				expect(plan->statistics().interrupted && plan->statistics().steps == Count / 2, U"上限: interrupted={}, steps={}"_fmt(plan->statistics().interrupted, plan->statistics().steps));
+				expect(stopped->getError().code == NodeErrorCode::StepLimitExceeded && stopped->runs == 1, U"上限: code={}, runs={}"_fmt(static_cast<int32>(stopped->getError().code), stopped->runs));
+				expect(steps[Count / 2 - 2]->runs == 2 && steps.back()->runs == 1, U"上限: before.runs={}, last.runs={}"_fmt(steps[Count / 2 - 2]->runs, steps.back()->runs));
+			});
+	}
+
+	//実行ソケットが循環している計画は実行せず、循環に含まれるノードにエラーを記録する
+	Tests::Result RefuseCycle()
+	{
+		return Tests::Run(U"ExecutionPlan", U"RefuseCycle", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto before = std::make_shared<Fixtures::StepNode>();
+				auto first = std::make_shared<Fixtures::StepNode>();
+				auto second = std::make_shared<Fixtures::StepNode>();
+
+				Fixtures::ConnectExec(entry, 0, before);
+				Fixtures::ConnectExec(before, 0, first);
+				Fixtures::ConnectExec(first, 0, second);
+				Fixtures::ConnectExec(second, 0, first);
+
+				const auto plan = ExecutionPlan::Compile(*entry);
+				expect(plan->hasCycle(), U"循環が検出されない");
+
+				plan->run();
+				expect(plan->statistics().interrupted && plan->statistics().steps == 0, U"steps={}"_fmt(plan->statistics().steps));
+				expect(before->runs == 0 && first->runs == 0 && second->runs == 0, U"before.runs={}, first.runs={}, second.runs={}"_fmt(before->runs, first->runs, second->runs));
+				expect(first->getError().code == NodeErrorCode::ExecCycle && second->getError().code == NodeErrorCode::ExecCycle, U"first: code={}, second: code={}"_fmt(static_cast<int32>(first->getError().code), static_cast<int32>(second->getError().code)));
+				expect(!before->getError(), U"循環していないノードにエラーが記録された");
+
+				const bool finished = plan->runFor(1s);
+				expect(finished && first->runs == 0, U"runFor: finished={}, first.runs={}"_fmt(finished, first->runs));
+			});
+	}
+
+	//Pureなノードは入力が変化していなければ前回の出力を使う
+	Tests::Result SkipUnchangedPure()
+	{
+		return Tests::Run(U"ExecutionPlan", U"SkipUnchangedPure", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto constant = std::make_shared<Fixtures::ConstantNode>();
+				auto twice = std::make_shared<Fixtures::DoubleNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+
+				constant->setValue(3);
+				Fixtures::ConnectValue(constant, 0, twice, 0);
+				Fixtures::ConnectValue(twice, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				const auto plan = ExecutionPlan::Compile(*entry);
+				plan->run();
+				plan->run();
+				expect(twice->runs == 1, U"twice.runs={}"_fmt(twice->runs));
+				expect(plan->statistics().skipped == 1, U"skipped={}"_fmt(plan->statistics().skipped));
+				expect(sink->value == 6, U"sink={}"_fmt(sink->value));
+
+				constant->setValue(5);
+				plan->run();
+				expect(twice->runs == 2, U"変更後: twice.runs={}"_fmt(twice->runs));
+				expect(sink->value == 10, U"変更後: sink={}"_fmt(sink->value));
+			});
+	}
+
+	//関数のノードは入力が無くても毎回呼び出す
+	Tests::Result CallImpureFunction()
+	{
+		return Tests::Run(U"ExecutionPlan", U"CallImpureFunction", [](const Tests::Expect& expect)
+			{
+				int32 ticks = 0;
+
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto tick = std::make_shared<detail::FunctionNode<int32()>>(U"Tick", Array<String>{ U"value" }, [&ticks]()
+					{
+						return ++ticks;
+					});
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+
+				Fixtures::ConnectValue(tick, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				for (int32 i = 1; i <= 3; i++)
+				{
+					entry->run();
+					expect(sink->value == i, U"{}回目: sink={}"_fmt(i, sink->value));
+				}
+				expect(entry->getPlan()->statistics().skipped == 0, U"skipped={}"_fmt(entry->getPlan()->statistics().skipped));
+				expect(entry->getPlan()->foldedCount() == 0, U"folded={}"_fmt(entry->getPlan()->foldedCount()));
+			});
+	}
+
+	//入力を持たないノードは、Pureでも入力が変化していないことを理由に省略しない
+	Tests::Result RunPureWithoutInputs()
+	{
+		return Tests::Run(U"ExecutionPlan", U"RunPureWithoutInputs", [](const Tests::Expect& expect)
+			{
+				class PureCounterNode : public Fixtures::CounterNode<>
+				{
+				public:
+
+					PureCounterNode()
+					{
+						Pure = true;
+					}
+				};
+
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto counter = std::make_shared<PureCounterNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+
+				Fixtures::ConnectValue(counter, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				const auto plan = ExecutionPlan::Compile(*entry);
+				plan->run();
+				plan->run();
+				expect(counter->value == 2 && sink->value == 2, U"counter={}, sink={}"_fmt(counter->value, sink->value));
+				expect(plan->statistics().skipped == 0, U"skipped={}"_fmt(plan->statistics().skipped));
+			});
+	}
+
+	//Constantなノードと下流のPureなノードは値を編集するまで再び評価しない(他のグラフの定数の編集では計算し直さない)
+	Tests::Result FoldConstants()
+	{
+		return Tests::Run(U"ExecutionPlan", U"FoldConstants", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto constant = std::make_shared<Fixtures::FoldableConstantNode>();
+				auto twice = std::make_shared<Fixtures::DoubleNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+
+				constant->setValue(3);
+				Fixtures::ConnectValue(constant, 0, twice, 0);
+				Fixtures::ConnectValue(twice, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				//別の計画の定数(接続の変更は全ての計画を作り直させるので、先に接続しておく)
+				auto otherEntry = std::make_shared<Fixtures::EntryNode>();
+				auto otherConstant = std::make_shared<Fixtures::FoldableConstantNode>();
+				auto otherSink = std::make_shared<Fixtures::SinkNode<>>();
+				Fixtures::ConnectValue(otherConstant, 0, otherSink, 0);
+				Fixtures::ConnectExec(otherEntry, 0, otherSink);
+
+				for (int32 i = 0; i < 3; i++)
+				{
+					entry->run();
+				}
+				expect(entry->getPlan()->foldedCount() == 2, U"folded={}"_fmt(entry->getPlan()->foldedCount()));
+				expect(constant->runs == 1 && twice->runs == 1, U"constant.runs={}, twice.runs={}"_fmt(constant->runs, twice->runs));
+				expect(sink->runs == 3 && sink->value == 6, U"sink.runs={}, sink={}"_fmt(sink->runs, sink->value));
+
+				constant->setValue(4);
+				entry->run();
+				expect(constant->runs == 2, U"変更後: constant.runs={}"_fmt(constant->runs));
+				expect(sink->value == 8, U"変更後: sink={}"_fmt(sink->value));
+
+				otherConstant->setValue(7);
+				otherEntry->run();
+				entry->run();
+				expect(otherSink->value == 7 && otherConstant->runs == 1, U"他の計画: sink={}, constant.runs={}"_fmt(otherSink->value, otherConstant->runs));
+				expect(constant->runs == 2 && twice->runs == 2, U"他の計画の編集後: constant.runs={}, twice.runs={}"_fmt(constant->runs, twice->runs));
+			});
+	}
+
+	//実行ソケットで到達しても出力が使われないPureなノードは実行しない
+	Tests::Result SkipDeadPure()
+	{
+		return Tests::Run(U"ExecutionPlan", U"SkipDeadPure", [](const Tests::Expect& expect)
+			{
+				//実行ソケットを持つPureなノード
+				class PureStepNode : public Fixtures::DoubleNode
+				{
+				public:
+
+					PureStepNode()
+					{
+						cfgPrevExecSocket({ U"" });
+						cfgNextExecSocket({ U"" });
+					}
+				};
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto constant = *graph.addNode<Fixtures::ConstantNode>();
+				auto twice = std::make_shared<PureStepNode>();
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+				graph.addNode(twice);
+
+				Fixtures::ConnectValue(constant, 0, twice, 0);
+				Fixtures::ConnectValue(constant, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, twice);
+				Fixtures::ConnectExec(twice, 0, sink);
+
+				entry->run();
+				expect(twice->runs == 0, U"twice.runs={}"_fmt(twice->runs));
+				expect(sink->runs == 1, U"sink.runs={}"_fmt(sink->runs));
+				expect(entry->getPlan()->deadCount() == 1, U"dead={}"_fmt(entry->getPlan()->deadCount()));
+				expect(graph.deadNodes().includes(twice), U"Graph::deadNodesに含まれない");
+			});
+	}
+
+	//起点ノードの無いグラフは実行されないので、どのノードも実行しないノードとして扱わない
+	Tests::Result NoDeadNodesWithoutRoots()
+	{
+		return Tests::Run(U"ExecutionPlan", U"NoDeadNodesWithoutRoots", [](const Tests::Expect& expect)
+			{
+				Graph graph;
+				Tests::RegisterNodes(graph);
+
+				auto constant = *graph.addNode<Fixtures::ConstantNode>();
+				auto twice = *graph.addNode<Fixtures::DoubleNode>();
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+
+				Fixtures::ConnectValue(constant, 0, twice, 0);
+				Fixtures::ConnectValue(twice, 0, sink, 0);
+				expect(graph.deadNodes().isEmpty(), U"起点なし: dead={}"_fmt(graph.deadNodes().size()));
+				expect(graph.deadNodes({}).isEmpty(), U"空の起点: dead={}"_fmt(graph.deadNodes({}).size()));
+
+				//起点ノードから到達できなければ実行されない
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				expect(graph.deadNodes().size() == 3, U"未接続の起点: dead={}"_fmt(graph.deadNodes().size()));
+
+				Fixtures::ConnectExec(entry, 0, sink);
+				expect(graph.deadNodes().isEmpty(), U"接続後: dead={}"_fmt(graph.deadNodes().size()));
+			});
+	}
+
+	//pureを指定せずに登録した関数は、出力が使われなくても副作用のために実行する
+	Tests::Result RunUnusedSideEffect()
+	{
+		return Tests::Run(U"ExecutionPlan", U"RunUnusedSideEffect", [](const Tests::Expect& expect)
+			{
+				Array<int32> log;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32)>(U"Log", { U"result",U"a" }, [&log](int32 a)
+					{
+						log << a;
+						return a;
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto constant = *graph.addNode<Fixtures::ConstantNode>();
+				auto logger = *graph.addNode(U"Log");
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+
+				constant->setValue(7);
+				Fixtures::ConnectValue(constant, 0, logger, 0);
+				Fixtures::ConnectValue(constant, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, logger);
+				Fixtures::ConnectExec(logger, 0, sink);
+
+				entry->run();
+				entry->run();
+				expect(log == Array<int32>{ 7, 7 }, U"log.size={}"_fmt(log.size()));
+				expect(entry->getPlan()->deadCount() == 0, U"dead={}"_fmt(entry->getPlan()->deadCount()));
+				expect(!graph.deadNodes().includes(logger), U"Graph::deadNodesに含まれる");
+			});
+	}
+
+	//同じ関数に同じ出力を入力したノードは1つだけ評価する
+	Tests::Result MergeCommon()
+	{
+		return Tests::Run(U"ExecutionPlan", U"MergeCommon", [](const Tests::Expect& expect)
+			{
+				size_t calls = 0;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+
+				const auto twice = [&calls](int32 a)
+				{
+					calls++;
+					return a * 2;
+				};
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto counter = *graph.addNode<Fixtures::CounterNode<>>();
+				auto first = std::make_shared<PureFunctionNode<int32(int32)>>(0, Array<String>{ U"result",U"a" }, twice);
+				auto second = std::make_shared<PureFunctionNode<int32(int32)>>(0, Array<String>{ U"result",U"a" }, twice);
+				auto add = std::make_shared<PureFunctionNode<int32(int32, int32)>>(1, Array<String>{ U"result",U"a",U"b" }, [](int32 a, int32 b)
+					{
+						return a + b;
+					});
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+				graph.addNode(first);
+				graph.addNode(second);
+				graph.addNode(add);
+
+				Fixtures::ConnectValue(counter, 0, first, 0);
+				Fixtures::ConnectValue(counter, 0, second, 0);
+				Fixtures::ConnectValue(first, 0, add, 0);
+				Fixtures::ConnectValue(second, 0, add, 1);
+				Fixtures::ConnectValue(add, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				entry->run();
+				expect(calls == 1, U"calls={}"_fmt(calls));
+				expect(entry->getPlan()->mergedCount() == 1, U"merged={}"_fmt(entry->getPlan()->mergedCount()));
+				expect(sink->value == 4, U"sink={}"_fmt(sink->value));
+
+				entry->run();
+				expect(sink->value == 8, U"2回目: sink={}"_fmt(sink->value));
+
+				//命令列も同じレジスタを読む(関数テーブルから生成したノードではないのでノードを呼ぶ)
+				graph.compile(*entry)->run();
+				expect(sink->value == 12, U"Bytecode: sink={}"_fmt(sink->value));
+			});
+	}
+
+	//別の分岐にある同じ関数・同じ入力のノードをまとめても、それぞれの分岐で最新の値を読む
+	Tests::Result MergeCommonAcrossBranch()
+	{
+		return Tests::Run(U"ExecutionPlan", U"MergeCommonAcrossBranch", [](const Tests::Expect& expect)
+			{
+				Graph graph;
+				Tests::RegisterNodes(graph);
+
+				const auto twice = [](int32 a)
+				{
+					return a * 2;
+				};
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto counter = *graph.addNode<Fixtures::CounterNode<>>();
+				auto toggle = *graph.addNode<Fixtures::ToggleNode>();
+				auto branch = *graph.addNode<Fixtures::BranchNode>();
+				auto first = std::make_shared<PureFunctionNode<int32(int32)>>(0, Array<String>{ U"result",U"a" }, twice);
+				auto second = std::make_shared<PureFunctionNode<int32(int32)>>(0, Array<String>{ U"result",U"a" }, twice);
+				auto onTrue = *graph.addNode<Fixtures::SinkNode<>>();
+				auto onFalse = *graph.addNode<Fixtures::SinkNode<>>();
+				graph.addNode(first);
+				graph.addNode(second);
+
+				Fixtures::ConnectValue(toggle, 0, branch, 0);
+				Fixtures::ConnectValue(counter, 0, first, 0);
+				Fixtures::ConnectValue(counter, 0, second, 0);
+				Fixtures::ConnectValue(first, 0, onTrue, 0);
+				Fixtures::ConnectValue(second, 0, onFalse, 0);
+				Fixtures::ConnectExec(entry, 0, branch);
+				Fixtures::ConnectExec(branch, 0, onTrue);
+				Fixtures::ConnectExec(branch, 1, onFalse);
+
+				const auto check = [&](const String& label, const std::function<void()>& run)
+				{
+					for (int32 pass = 0; pass < 4; pass++)
+					{
+						run();
+						const auto& sink = (pass % 2 == 0) ? onTrue : onFalse;
+						expect(sink->value == counter->value * 2, U"{} {}回目: counter={}, sink={}"_fmt(label, pass + 1, counter->value, sink->value));
+					}
+				};
+
+				check(U"ExecutionPlan", [&] { entry->run(); });
+				expect(entry->getPlan()->mergedCount() == 1, U"merged={}"_fmt(entry->getPlan()->mergedCount()));
+
+				const auto bytecode = graph.compile(*entry);
+				check(U"Bytecode", [&] { bytecode->run(); });
+			});
+	}
+
+	//まとめたノードの出力ソケットは、計画の外から読んでもまとめ先と同じ最新の値になる(まとめなくなったら自身の値に戻る)
+	Tests::Result ForwardMergedOutputs()
+	{
+		return Tests::Run(U"ExecutionPlan", U"ForwardMergedOutputs", [](const Tests::Expect& expect)
+			{
+				Graph graph;
+				Tests::RegisterNodes(graph);
+
+				const auto twice = [](int32 a)
+				{
+					return a * 2;
+				};
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto counter = *graph.addNode<Fixtures::CounterNode<>>();
+				auto other = *graph.addNode<Fixtures::CounterNode<>>();
+				auto first = std::make_shared<PureFunctionNode<int32(int32)>>(0, Array<String>{ U"result",U"a" }, twice);
+				auto second = std::make_shared<PureFunctionNode<int32(int32)>>(0, Array<String>{ U"result",U"a" }, twice);
+				auto sink = std::make_shared<Fixtures::SinkNode<>>(2);
+				graph.addNode(first);
+				graph.addNode(second);
+				graph.addNode(sink);
+
+				Fixtures::ConnectValue(counter, 0, first, 0);
+				Fixtures::ConnectValue(counter, 0, second, 0);
+				Fixtures::ConnectValue(first, 0, sink, 0);
+				Fixtures::ConnectValue(second, 0, sink, 1);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				const auto read = [](const std::shared_ptr<Node>& node)
+				{
+					const auto& output = node->getOutputSockets()[0];
+					return output->hasValue() ? output->value().get<int32>() : -1;
+				};
+
+				for (int32 pass = 1; pass <= 3; pass++)
+				{
+					entry->run();
+					expect(read(first) == pass * 2 && read(second) == pass * 2, U"{}回目: first={}, second={}"_fmt(pass, read(first), read(second)));
+					expect(first->getOutputSockets()[0]->version() == second->getOutputSockets()[0]->version(), U"{}回目: バージョンが異なる"_fmt(pass));
+				}
+				expect(entry->getPlan()->mergedCount() == 1, U"merged={}"_fmt(entry->getPlan()->mergedCount()));
+
+				Fixtures::ConnectValue(other, 0, second, 0);
+				entry->run();
+				expect(entry->getPlan()->mergedCount() == 0, U"分離後: merged={}"_fmt(entry->getPlan()->mergedCount()));
+				expect(read(first) == 8 && read(second) == 2, U"分離後: first={}, second={}"_fmt(read(first), read(second)));
+			});
+	}
+
+	//pureを指定して登録した関数は、入力が変化しなければ省略し、同じ入力のノードをまとめ、出力が使われなければ実行しない
+	//pureを指定せずに登録した関数は毎回呼び出す
+	Tests::Result RegisteredPureFunction()
+	{
+		return Tests::Run(U"ExecutionPlan", U"RegisteredPureFunction", [](const Tests::Expect& expect)
+			{
+				size_t calls = 0;
+				size_t echoes = 0;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32)>(U"Twice", { U"result",U"a" }, [&calls](int32 a)
+					{
+						calls++;
+						return a * 2;
+					}, NodeOptions{ .pure = true });
+				graph.registerNodeFunction<int32(int32)>(U"Echo", { U"result",U"a" }, [&echoes](int32 a)
+					{
+						echoes++;
+						return a;
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto constant = *graph.addNode<Fixtures::ConstantNode>();
+				auto other = *graph.addNode<Fixtures::ConstantNode>();
+				auto first = *graph.addNode(U"Twice");
+				auto second = *graph.addNode(U"Twice");
+				auto unused = *graph.addNode(U"Twice");
+				auto echo = *graph.addNode(U"Echo");
+				auto sink = std::make_shared<Fixtures::SinkNode<>>(3);
+				graph.addNode(sink);
+
+				constant->setValue(3);
+				Fixtures::ConnectValue(constant, 0, first, 0);
+				Fixtures::ConnectValue(constant, 0, second, 0);
+				Fixtures::ConnectValue(constant, 0, echo, 0);
+				Fixtures::ConnectValue(other, 0, unused, 0);
+				Fixtures::ConnectValue(first, 0, sink, 0);
+				Fixtures::ConnectValue(second, 0, sink, 1);
+				Fixtures::ConnectValue(echo, 0, sink, 2);
+				Fixtures::ConnectExec(entry, 0, unused);
+				Fixtures::ConnectExec(unused, 0, sink);
+
+				for (int32 i = 0; i < 3; i++)
+				{
+					entry->run();
+				}
+				expect(calls == 1, U"calls={}"_fmt(calls));
+				expect(echoes == 3, U"echoes={}"_fmt(echoes));
+				expect(sink->runs == 3 && sink->value == 15, U"sink.runs={}, sink={}"_fmt(sink->runs, sink->value));
+				expect(entry->getPlan()->mergedCount() == 1, U"merged={}"_fmt(entry->getPlan()->mergedCount()));
+				expect(entry->getPlan()->deadCount() == 1, U"dead={}"_fmt(entry->getPlan()->deadCount()));
+				expect(entry->getPlan()->statistics().skipped == 1, U"skipped={}"_fmt(entry->getPlan()->statistics().skipped));
+			});
+	}
+
+	//deterministicをfalseにして登録した関数は、pureでも省略せず、同じ入力のノードをまとめず、定数として畳み込まない
+	Tests::Result NonDeterministicFunction()
+	{
+		return Tests::Run(U"ExecutionPlan", U"NonDeterministicFunction", [](const Tests::Expect& expect)
+			{
+				int32 rolls = 0;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32)>(U"Roll", { U"result",U"a" }, [&rolls](int32 a)
+					{
+						return a + ++rolls;
+					}, NodeOptions{ .pure = true, .deterministic = false });
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto constant = *graph.addNode<Fixtures::FoldableConstantNode>();
+				auto first = *graph.addNode(U"Roll");
+				auto second = *graph.addNode(U"Roll");
+				auto sink = std::make_shared<Fixtures::SinkNode<>>(2);
+				graph.addNode(sink);
+
+				Fixtures::ConnectValue(constant, 0, first, 0);
+				Fixtures::ConnectValue(constant, 0, second, 0);
+				Fixtures::ConnectValue(first, 0, sink, 0);
+				Fixtures::ConnectValue(second, 0, sink, 1);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				for (int32 i = 0; i < 3; i++)
+				{
+					entry->run();
+				}
+				expect(rolls == 6, U"rolls={}"_fmt(rolls));
+				expect(entry->getPlan()->mergedCount() == 0, U"merged={}"_fmt(entry->getPlan()->mergedCount()));
+				expect(entry->getPlan()->foldedCount() == 1, U"folded={}"_fmt(entry->getPlan()->foldedCount()));
+				expect(entry->getPlan()->statistics().skipped == 0, U"skipped={}"_fmt(entry->getPlan()->statistics().skipped));
+			});
+	}
+
+	//runForの時間枠が短くてもノードの境界で止まって続きから実行し、runと同じ結果になる(生成元は1パスで1度だけ評価する)
+	Tests::Result SliceWithTinyBudget()
+	{
+		return Tests::Run(U"ExecutionPlan", U"SliceWithTinyBudget", [](const Tests::Expect& expect)
+			{
+				struct Built
+				{
+					std::shared_ptr<Node> entry;
+
+					std::shared_ptr<Fixtures::CounterNode<>> counter;
+
+					Array<std::shared_ptr<Fixtures::SinkNode<>>> sinks;
+				};
+
+				//entry → first → branch → (true: second, false: third)、各Sinkはcounterとそれを2倍した値を読む
+				const auto build = []()
+				{
+					Built built;
+					built.entry = std::make_shared<Fixtures::EntryNode>();
+					built.counter = std::make_shared<Fixtures::CounterNode<>>();
+					auto doubled = std::make_shared<Fixtures::DoubleNode>();
+					auto toggle = std::make_shared<Fixtures::ToggleNode>();
+					auto branch = std::make_shared<Fixtures::BranchNode>();
+					for (size_t i = 0; i < 3; i++)
+					{
+						built.sinks << std::make_shared<Fixtures::SinkNode<>>(2);
+						Fixtures::ConnectValue(built.counter, 0, built.sinks[i], 0);
+						Fixtures::ConnectValue(doubled, 0, built.sinks[i], 1);
+					}
+					Fixtures::ConnectValue(built.counter, 0, doubled, 0);
+					Fixtures::ConnectValue(toggle, 0, branch, 0);
+					Fixtures::ConnectExec(built.entry, 0, built.sinks[0]);
+					Fixtures::ConnectExec(built.sinks[0], 0, branch);
+					Fixtures::ConnectExec(branch, 0, built.sinks[1]);
+					Fixtures::ConnectExec(branch, 1, built.sinks[2]);
+					return built;
+				};
+
+				const auto expected = build();
+				const auto sliced = build();
+				const auto expectedPlan = ExecutionPlan::Compile(*expected.entry);
+				const auto slicedPlan = ExecutionPlan::Compile(*sliced.entry);
+
+				for (int32 pass = 1; pass <= 4; pass++)
+				{
+					expectedPlan->run();
+
+					//時間枠0でも1回の呼び出しで少なくとも1つのノードを実行する
+					size_t calls = 1;
+					while (!slicedPlan->runFor(0s) && calls < 100)
+					{
+						expect(slicedPlan->inProgress(), U"{}回目: 途中のパスが記録されない"_fmt(pass));
+						calls++;
+					}
+					expect(calls > 1 && calls < 100 && !slicedPlan->inProgress(), U"{}回目: calls={}"_fmt(pass, calls));
+
+					expect(sliced.counter->value == expected.counter->value, U"{}回目: counter: run={}, runFor={}"_fmt(pass, expected.counter->value, sliced.counter->value));
+					for (size_t i = 0; i < 3; i++)
+					{
+						const auto& a = expected.sinks[i];
+						const auto& b = sliced.sinks[i];
+						expect(a->runs == b->runs && a->sum == b->sum, U"{}回目: sink{}: run=({}, {}), runFor=({}, {})"_fmt(pass, i, a->runs, a->sum, b->runs, b->sum));
+					}
+				}
+				expect(expected.counter->value == 4, U"counter={}"_fmt(expected.counter->value));
+			});
+	}
+
+	//次のフレームまで中断する
+	class WaitNode : public AsyncNode
+	{
+	private:
+
+		AsyncTask childRunAsync() override
+		{
+			co_await Async::NextFrame();
+		}
+
+	public:
+
+		WaitNode()
+		{
+			Name = U"Wait";
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//runForは中断しているノードを同じ時間枠で再開してから、起点ノードからのパスを実行する
+	Tests::Result RunForResumesSuspended()
+	{
+		return Tests::Run(U"ExecutionPlan", U"RunForResumesSuspended", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto wait = std::make_shared<WaitNode>();
+				auto step = std::make_shared<Fixtures::StepNode>();
+
+				Fixtures::ConnectExec(entry, 0, wait);
+				Fixtures::ConnectExec(wait, 0, step);
+
+				const auto plan = ExecutionPlan::Compile(*entry);
+				const bool first = plan->runFor(1s);
+				expect(first && step->runs == 0 && plan->suspendedCount() == 1, U"first={}, step={}, suspended={}"_fmt(first, step->runs, plan->suspendedCount()));
+
+				//再開したwaitがstepに進み、起点ノードからのパスでwaitが再び中断する
+				const bool second = plan->runFor(1s);
+				expect(second && step->runs == 1 && plan->suspendedCount() == 1, U"second={}, step={}, suspended={}"_fmt(second, step->runs, plan->suspendedCount()));
+			});
+	}
+
+	//実行計画から外れたノードの中断は破棄し、再び接続したら最初から実行する(外れなかったノードは新しい計画で再開する)
+	Tests::Result ResumeAcrossRecompile()
+	{
+		return Tests::Run(U"ExecutionPlan", U"ResumeAcrossRecompile", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto wait = std::make_shared<WaitNode>();
+				auto step = std::make_shared<Fixtures::StepNode>();
+				auto extra = std::make_shared<Fixtures::StepNode>();
+
+				Fixtures::ConnectExec(entry, 0, wait);
+				Fixtures::ConnectExec(wait, 0, step);
+
+				entry->runFor(1s);
+				expect(entry->getPlan()->suspendedCount() == 1, U"接続: suspended={}"_fmt(entry->getPlan()->suspendedCount()));
+
+				ISocket::disconnect(wait->getPrevNodeSockets()[0]);
+				entry->runFor(1s);
+				expect(entry->getPlan()->suspendedCount() == 0 && step->runs == 0, U"切断: suspended={}, step={}"_fmt(entry->getPlan()->suspendedCount(), step->runs));
+
+				//破棄されていなければ中断中として飛ばされ、計画に加わらない
+				Fixtures::ConnectExec(entry, 0, wait);
+				entry->runFor(1s);
+				expect(entry->getPlan()->suspendedCount() == 1 && step->runs == 0, U"再接続: suspended={}, step={}"_fmt(entry->getPlan()->suspendedCount(), step->runs));
+
+				//waitに関係しない変更で作り直した計画でも、中断していたwaitを再開する
+				Fixtures::ConnectExec(step, 0, extra);
+				entry->runFor(1s);
+				expect(step->runs == 1 && extra->runs == 1, U"再開: step={}, extra={}"_fmt(step->runs, extra->runs));
+			});
+	}
+
+	//durationだけ待ってから次のノードに進む
+	class DelayNode : public AsyncNode
+	{
+	private:
+
+		AsyncTask childRunAsync() override
+		{
+			co_await Async::Delay(duration);
+		}
+
+	public:
+
+		Duration duration = 0s;
+
+		DelayNode()
+		{
+			Name = U"Delay";
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//中断しているノードがなくなるまでresumeを繰り返す
+	bool ResumeUntilDone(Node& entry, int32 limit = 5000)
+	{
+		for (int32 i = 0; i < limit; i++)
+		{
+			if (entry.getPlan()->suspendedCount() == 0)
+			{
+				return true;
+			}
+			System::Sleep(1);
+			entry.resume();
+		}
+		return false;
+	}
+
+	//Async::Delayは時間が経過するまで再開しない
+	Tests::Result AsyncDelay()
+	{
+		return Tests::Run(U"ExecutionPlan", U"AsyncDelay", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto delay = std::make_shared<DelayNode>();
+				auto step = std::make_shared<Fixtures::StepNode>();
+
+				Fixtures::ConnectExec(entry, 0, delay);
+				Fixtures::ConnectExec(delay, 0, step);
+
+				delay->duration = 50ms;
+				const auto begin = std::chrono::steady_clock::now();
+				entry->run();
+				entry->resume();
+				expect(step->runs == 0 && entry->getPlan()->suspendedCount() == 1, U"直後: step={}, suspended={}"_fmt(step->runs, entry->getPlan()->suspendedCount()));
+
+				const bool done = ResumeUntilDone(*entry);
+				const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+				expect(done && step->runs == 1, U"完了: done={}, step={}"_fmt(done, step->runs));
+				expect(elapsed >= 50, U"経過時間: {}ms"_fmt(elapsed));
+			});
+	}
+
+	//Async::Backgroundで計算した値を出力する(failならスレッドプール上で標準の例外を送出する)
+	class BackgroundNode : public AsyncNode
+	{
+	private:
+
+		AsyncTask childRunAsync() override
+		{
+			const bool shouldFail = fail;
+			const int32 result = co_await Async::Background(*pool, [shouldFail]() -> int32
+				{
+					if (shouldFail)
+					{
+						throw std::runtime_error("background failed");
+					}
+					return 42;
+				});
+			setOutput(0, result);
+		}
+
+	public:
+
+		ThreadPool* pool = nullptr;
+
+		bool fail = false;
+
+		BackgroundNode()
+		{
+			Name = U"Background";
+			cfgOutputSockets({ {Type::getType<int32>(),U"result"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//Async::Backgroundの戻り値は再開したノードの出力になり、送出された標準の例外はノードのエラーになる
+	Tests::Result AsyncBackground()
+	{
+		return Tests::Run(U"ExecutionPlan", U"AsyncBackground", [](const Tests::Expect& expect)
+			{
+				ThreadPool pool(2);
+
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto background = std::make_shared<BackgroundNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>();
+
+				background->pool = &pool;
+				Fixtures::ConnectValue(background, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, background);
+				Fixtures::ConnectExec(background, 0, sink);
+
+				entry->run();
+				bool done = ResumeUntilDone(*entry);
+				expect(done && !background->getError() && sink->runs == 1 && sink->value == 42, U"成功: done={}, sink.runs={}, value={}"_fmt(done, sink->runs, sink->value));
+
+				background->fail = true;
+				entry->run();
+				done = ResumeUntilDone(*entry);
+				expect(done && background->getError().code == NodeErrorCode::Exception, U"例外: done={}, code={}"_fmt(done, static_cast<int32>(background->getError().code)));
+				expect(background->getErrorMessage() == U"background failed", U"例外: message={}"_fmt(background->getErrorMessage()));
+				expect(sink->runs == 1, U"例外: sink.runs={}"_fmt(sink->runs));
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunExecutionPlan()
+{
+	Array<Result> results;
+
+	results << ProducerOncePerPass();
+	results << SkipFailedProducer();
+	results << StepLimit();
+	results << RefuseCycle();
+	results << SkipUnchangedPure();
+	results << CallImpureFunction();
+	results << RunPureWithoutInputs();
+	results << FoldConstants();
+	results << SkipDeadPure();
+	results << NoDeadNodesWithoutRoots();
+	results << RunUnusedSideEffect();
+	results << MergeCommon();
+	results << MergeCommonAcrossBranch();
+	results << ForwardMergedOutputs();
+	results << RegisteredPureFunction();
+	results << NonDeterministicFunction();
+	results << SliceWithTinyBudget();
+	results << RunForResumesSuspended();
+	results << ResumeAcrossRecompile();
+	results << AsyncDelay();
+	results << AsyncBackground();
+
+	return results;
+}
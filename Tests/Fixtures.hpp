@@ -0,0 +1,169 @@
+#pragma once
+#include<Siv3D.hpp>
+#include"Node.hpp"
+#include"Shared/SampleNodes.hpp"
+
+//テストで使う小さなノード
+namespace Fixtures
+{
+	//テストとベンチマークで共通のノード
+	using SampleNodes::EntryNode;
+	using SampleNodes::CounterNode;
+	using SampleNodes::SinkNode;
+
+	//値を変更するまで同じ値を出力する(Constantではないので、毎回評価される)
+	class ConstantNode : public NodeEditor::Node
+	{
+	private:
+
+		int32 m_value = 0;
+
+		void childRun() override
+		{
+			runs++;
+			setOutput(0, m_value);
+		}
+
+		void childSerialize(JSONWriter& writer) const override
+		{
+			writer.write(m_value);
+		}
+
+		void childDeserialize(const JSONValue& json) override
+		{
+			m_value = json.get<int32>();
+			constantChanged();
+		}
+
+	public:
+
+		size_t runs = 0;
+
+		ConstantNode()
+		{
+			Name = U"Constant";
+			cfgOutputSockets({ {Type::getType<int32>(),U"value"} });
+		}
+
+		void setValue(int32 value)
+		{
+			m_value = value;
+			constantChanged();
+		}
+	};
+
+	//値を編集するまで再び評価しなくてよいConstantなノード(定数の畳み込みの対象)
+	class FoldableConstantNode : public ConstantNode
+	{
+	public:
+
+		FoldableConstantNode()
+		{
+			Name = U"FoldableConstant";
+
+			Constant = true;
+		}
+	};
+
+	//入力を2倍するPureなノード
+	class DoubleNode : public NodeEditor::Node
+	{
+	private:
+
+		void childRun() override
+		{
+			runs++;
+			setOutput(0, getInput<int32>(0) * 2);
+		}
+
+	public:
+
+		size_t runs = 0;
+
+		DoubleNode()
+		{
+			Name = U"Double";
+			cfgInputSockets({ {Type::getType<int32>(),U"a"} });
+			cfgOutputSockets({ {Type::getType<int32>(),U"result"} });
+
+			Pure = true;
+		}
+	};
+
+	//実行された回数を数える
+	class StepNode : public NodeEditor::Node
+	{
+	private:
+
+		void childRun() override
+		{
+			runs++;
+		}
+
+	public:
+
+		size_t runs = 0;
+
+		StepNode()
+		{
+			Name = U"Step";
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//評価されるたびにtrueとfalseを交互に出力する
+	class ToggleNode : public NodeEditor::Node
+	{
+	private:
+
+		bool m_value = false;
+
+		void childRun() override
+		{
+			m_value = !m_value;
+			setOutput(0, m_value);
+		}
+
+	public:
+
+		ToggleNode()
+		{
+			Name = U"Toggle";
+			cfgOutputSockets({ {Type::getType<bool>(),U"value"} });
+		}
+	};
+
+	//conditionがtrueなら0番目、falseなら1番目の実行ソケットに進む
+	class BranchNode : public NodeEditor::Node
+	{
+	private:
+
+		void childRun() override
+		{
+			NextExecIdx = getInput<bool>(0) ? 0 : 1;
+		}
+
+	public:
+
+		BranchNode()
+		{
+			Name = U"Branch";
+			cfgInputSockets({ {Type::getType<bool>(),U"condition"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"true",U"false" });
+		}
+	};
+
+	//fromのoutput番目の出力ソケットをtoのinput番目の入力ソケットにつなぐ
+	inline void ConnectValue(const std::shared_ptr<NodeEditor::Node>& from, size_t output, const std::shared_ptr<NodeEditor::Node>& to, size_t input)
+	{
+		NodeEditor::ISocket::connect(to->getInputSockets()[input], from->getOutputSockets()[output]);
+	}
+
+	//fromのnext番目の次の実行ソケットをtoの前の実行ソケットにつなぐ
+	inline void ConnectExec(const std::shared_ptr<NodeEditor::Node>& from, size_t next, const std::shared_ptr<NodeEditor::Node>& to)
+	{
+		NodeEditor::ISocket::connect(from->getNextNodeSockets()[next], to->getPrevNodeSockets()[0]);
+	}
+}
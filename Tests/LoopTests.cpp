@@ -0,0 +1,416 @@
+#include"Tests.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//firstからlastの直前まで本体を実行し、最後にcompletedへ進む
+	Tests::Result For()
+	{
+		return Tests::Run(U"Loop", U"For", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto first = std::make_shared<Fixtures::ConstantNode>();
+				auto last = std::make_shared<Fixtures::ConstantNode>();
+				auto loop = std::make_shared<Builtin::ForNode>();
+				auto body = std::make_shared<Fixtures::SinkNode<>>();
+				auto completed = std::make_shared<Fixtures::StepNode>();
+
+				first->setValue(0);
+				last->setValue(5);
+				Fixtures::ConnectValue(first, 0, loop, 0);
+				Fixtures::ConnectValue(last, 0, loop, 1);
+				Fixtures::ConnectValue(loop, 0, body, 0);
+				Fixtures::ConnectExec(entry, 0, loop);
+				Fixtures::ConnectExec(loop, 0, body);
+				Fixtures::ConnectExec(loop, 1, completed);
+
+				entry->run();
+				expect(body->runs == 5 && body->sum == 10, U"body.runs={}, sum={}"_fmt(body->runs, body->sum));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+				expect(!entry->getPlan()->statistics().interrupted, U"中断された");
+
+				//次のパスでは最初から数え直す
+				entry->run();
+				expect(body->runs == 10 && body->sum == 20, U"2回目: body.runs={}, sum={}"_fmt(body->runs, body->sum));
+				expect(completed->runs == 2, U"2回目: completed.runs={}"_fmt(completed->runs));
+			});
+	}
+
+	//内側のループは外側の反復ごとに最初から実行する
+	Tests::Result NestedFor()
+	{
+		return Tests::Run(U"Loop", U"NestedFor", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto zero = std::make_shared<Fixtures::ConstantNode>();
+				auto three = std::make_shared<Fixtures::ConstantNode>();
+				auto four = std::make_shared<Fixtures::ConstantNode>();
+				auto outer = std::make_shared<Builtin::ForNode>();
+				auto inner = std::make_shared<Builtin::ForNode>();
+				auto body = std::make_shared<Fixtures::SinkNode<>>();
+				auto completed = std::make_shared<Fixtures::StepNode>();
+
+				three->setValue(3);
+				four->setValue(4);
+				Fixtures::ConnectValue(zero, 0, outer, 0);
+				Fixtures::ConnectValue(three, 0, outer, 1);
+				Fixtures::ConnectValue(zero, 0, inner, 0);
+				Fixtures::ConnectValue(four, 0, inner, 1);
+				Fixtures::ConnectValue(outer, 0, body, 0);
+				Fixtures::ConnectExec(entry, 0, outer);
+				Fixtures::ConnectExec(outer, 0, inner);
+				Fixtures::ConnectExec(inner, 0, body);
+				Fixtures::ConnectExec(outer, 1, completed);
+
+				entry->run();
+				expect(body->runs == 12, U"body.runs={}"_fmt(body->runs));
+				expect(body->sum == 12, U"sum={}"_fmt(body->sum));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+			});
+	}
+
+	//ステップ数の上限を変更し、テストの後で元に戻す
+	class StepLimitScope
+	{
+	private:
+
+		size_t m_previous = ExecutionPlan::StepLimit();
+
+	public:
+
+		explicit StepLimitScope(size_t limit)
+		{
+			ExecutionPlan::SetStepLimit(limit);
+		}
+
+		~StepLimitScope()
+		{
+			ExecutionPlan::SetStepLimit(m_previous);
+		}
+	};
+
+	//反復の回数
+	constexpr int32 LongCount = 1000000;
+
+	//本体が1ノードのループをLongCount回反復するパスのステップ数(entry、反復ごとのループと本体、最後のループ、completed)
+	constexpr size_t LongSteps = 2 * LongCount + 3;
+
+	//反復で辿ったノードもパスのステップ数に数え、上限を超えたら打ち切る(次のパスでは最初から反復する)
+	Tests::Result LongFor()
+	{
+		return Tests::Run(U"Loop", U"LongFor", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto first = std::make_shared<Fixtures::ConstantNode>();
+				auto last = std::make_shared<Fixtures::ConstantNode>();
+				auto loop = std::make_shared<Builtin::ForNode>();
+				auto body = std::make_shared<Fixtures::StepNode>();
+				auto completed = std::make_shared<Fixtures::StepNode>();
+
+				last->setValue(LongCount);
+				Fixtures::ConnectValue(first, 0, loop, 0);
+				Fixtures::ConnectValue(last, 0, loop, 1);
+				Fixtures::ConnectExec(entry, 0, loop);
+				Fixtures::ConnectExec(loop, 0, body);
+				Fixtures::ConnectExec(loop, 1, completed);
+
+				{
+					const StepLimitScope limit(LongSteps - 1);
+					entry->run();
+				}
+				expect(entry->getPlan()->statistics().interrupted, U"上限: 中断されない");
+				expect(body->runs < LongCount && completed->runs == 0, U"上限: body.runs={}, completed.runs={}"_fmt(body->runs, completed->runs));
+
+				const size_t before = body->runs;
+				{
+					const StepLimitScope limit(LongSteps);
+					entry->run();
+				}
+				expect(body->runs - before == LongCount, U"body.runs={}"_fmt(body->runs - before));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+				expect(entry->getPlan()->statistics().steps == LongSteps, U"steps={}"_fmt(entry->getPlan()->statistics().steps));
+				expect(!entry->getPlan()->statistics().interrupted, U"中断された");
+				expect(!loop->getError(), U"error={}"_fmt(static_cast<int32>(loop->getError().code)));
+			});
+	}
+
+	//Whileも1,000,000回反復でき、反復ごとにconditionを評価し直す
+	Tests::Result LongWhile()
+	{
+		return Tests::Run(U"Loop", U"LongWhile", [](const Tests::Expect& expect)
+			{
+				int32 remaining = LongCount;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<bool()>(U"Countdown", { U"condition" }, [&remaining]()
+					{
+						return 0 < remaining--;
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto condition = *graph.addNode(U"Countdown");
+				auto loop = *graph.addNode<Builtin::WhileNode>();
+				auto body = *graph.addNode<Fixtures::StepNode>();
+				auto completed = *graph.addNode<Fixtures::StepNode>();
+
+				Fixtures::ConnectValue(condition, 0, loop, 0);
+				Fixtures::ConnectExec(entry, 0, loop);
+				Fixtures::ConnectExec(loop, 0, body);
+				Fixtures::ConnectExec(loop, 1, completed);
+
+				const StepLimitScope limit(LongSteps);
+				entry->run();
+				expect(body->runs == LongCount, U"body.runs={}"_fmt(body->runs));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+				expect(!entry->getPlan()->statistics().interrupted, U"中断された");
+			});
+	}
+
+	//ForEachも1,000,000要素の配列を順に反復できる
+	Tests::Result LongForEach()
+	{
+		return Tests::Run(U"Loop", U"LongForEach", [](const Tests::Expect& expect)
+			{
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<Array<double>()>(U"Sequence", { U"array" }, []()
+					{
+						Array<double> elements(LongCount);
+						for (int32 i = 0; i < LongCount; i++)
+						{
+							elements[i] = i;
+						}
+						return elements;
+					}, NodeOptions{ .pure = true });
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto array = *graph.addNode(U"Sequence");
+				auto loop = *graph.addNode<Builtin::ForEachNode>();
+				auto body = std::make_shared<Fixtures::SinkNode<double>>();
+				auto completed = *graph.addNode<Fixtures::StepNode>();
+				graph.addNode(body);
+
+				Fixtures::ConnectValue(array, 0, loop, 0);
+				Fixtures::ConnectValue(loop, 0, body, 0);
+				Fixtures::ConnectExec(entry, 0, loop);
+				Fixtures::ConnectExec(loop, 0, body);
+				Fixtures::ConnectExec(loop, 1, completed);
+
+				const StepLimitScope limit(LongSteps);
+				entry->run();
+				//0からLongCount - 1までの和(doubleで正確に表せる)
+				const double expected = static_cast<double>(LongCount) * (LongCount - 1) / 2;
+				expect(body->runs == LongCount && body->sum == expected, U"body.runs={}, sum={}"_fmt(body->runs, body->sum));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+				expect(!entry->getPlan()->statistics().interrupted, U"中断された");
+			});
+	}
+
+	//conditionは反復ごとに評価し直され、falseになったらcompletedへ進む
+	Tests::Result While()
+	{
+		return Tests::Run(U"Loop", U"While", [](const Tests::Expect& expect)
+			{
+				int32 remaining = 3;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<bool()>(U"Countdown", { U"condition" }, [&remaining]()
+					{
+						return 0 < remaining--;
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto condition = *graph.addNode(U"Countdown");
+				auto loop = *graph.addNode<Builtin::WhileNode>();
+				auto body = *graph.addNode<Fixtures::SinkNode<>>();
+				auto completed = *graph.addNode<Fixtures::StepNode>();
+
+				Fixtures::ConnectValue(condition, 0, loop, 0);
+				Fixtures::ConnectValue(loop, 0, body, 0);
+				Fixtures::ConnectExec(entry, 0, loop);
+				Fixtures::ConnectExec(loop, 0, body);
+				Fixtures::ConnectExec(loop, 1, completed);
+
+				entry->run();
+				expect(body->runs == 3 && body->sum == 3, U"body.runs={}, sum={}"_fmt(body->runs, body->sum));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+				expect(!entry->getPlan()->statistics().interrupted, U"中断された");
+			});
+	}
+
+	//配列の要素と位置を順に出力する
+	Tests::Result ForEach()
+	{
+		return Tests::Run(U"Loop", U"ForEach", [](const Tests::Expect& expect)
+			{
+				Array<double> elements;
+				Array<int32> indices;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<Array<double>()>(U"Elements", { U"array" }, []()
+					{
+						return Array<double>{ 1.5, 2.5, 4.0 };
+					}, NodeOptions{ .pure = true });
+				graph.registerNodeFunction<void(double, int32)>(U"Record", { U"element",U"index" }, [&](double element, int32 index)
+					{
+						elements << element;
+						indices << index;
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto array = *graph.addNode(U"Elements");
+				auto loop = *graph.addNode<Builtin::ForEachNode>();
+				auto record = *graph.addNode(U"Record");
+				auto completed = *graph.addNode<Fixtures::StepNode>();
+
+				Fixtures::ConnectValue(array, 0, loop, 0);
+				Fixtures::ConnectValue(loop, 0, record, 0);
+				Fixtures::ConnectValue(loop, 1, record, 1);
+				Fixtures::ConnectExec(entry, 0, loop);
+				Fixtures::ConnectExec(loop, 0, record);
+				Fixtures::ConnectExec(loop, 1, completed);
+
+				entry->run();
+				expect(elements == Array<double>{ 1.5, 2.5, 4.0 }, U"elements={}"_fmt(elements));
+				expect(indices == Array<int32>{ 0, 1, 2 }, U"indices={}"_fmt(indices));
+				expect(completed->runs == 1, U"completed.runs={}"_fmt(completed->runs));
+			});
+	}
+
+	//ParallelForEachは要素ごとに本体を評価し、並列でも直列と同じ結果を返す
+	Tests::Result ParallelForEach()
+	{
+		return Tests::Run(U"Loop", U"ParallelForEach", [](const Tests::Expect& expect)
+			{
+				Array<double> recorded;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<Array<double>(int32)>(U"Range", { U"array",U"n" }, [](int32 n)
+					{
+						Array<double> array(n);
+						for (int32 i = 0; i < n; i++)
+						{
+							array[i] = i;
+						}
+						return array;
+					}, NodeOptions{ .pure = true });
+				graph.registerNodeFunction<double(double)>(U"Square", { U"result",U"a" }, [](double a)
+					{
+						return a * a;
+					}, NodeOptions{ .pure = true, .threadSafe = true });
+				graph.registerNodeFunction<void(Array<double>)>(U"Record", { U"array" }, [&recorded](Array<double> array)
+					{
+						recorded = std::move(array);
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto n = *graph.addNode<Fixtures::ConstantNode>();
+				auto range = *graph.addNode(U"Range");
+				auto loop = *graph.addNode<Builtin::ParallelForEachNode>();
+				auto square = *graph.addNode(U"Square");
+				auto record = *graph.addNode(U"Record");
+
+				const int32 count = 1000;
+				n->setValue(count);
+				Fixtures::ConnectValue(n, 0, range, 0);
+				Fixtures::ConnectValue(range, 0, loop, 0);
+				Fixtures::ConnectValue(loop, 0, square, 0);
+				Fixtures::ConnectValue(square, 0, loop, 1);
+				Fixtures::ConnectValue(loop, 2, record, 0);
+				Fixtures::ConnectExec(entry, 0, record);
+
+				const auto check = [&](const String& label)
+				{
+					bool ok = (recorded.size() == count);
+					for (size_t i = 0; ok && i < recorded.size(); i++)
+					{
+						ok = (recorded[i] == double(i * i));
+					}
+					expect(ok, U"{}: size={}"_fmt(label, recorded.size()));
+					expect(!loop->getError(), U"{}: {}"_fmt(label, loop->getError().message));
+				};
+
+				entry->run();
+				check(U"直列");
+
+				recorded.clear();
+				ThreadPool pool(4);
+				entry->run(pool);
+				check(U"並列");
+			});
+	}
+
+	//本体の接続の誤りはエラーとして記録し、接続を直すと評価できる
+	Tests::Result ParallelForEachBodyError()
+	{
+		return Tests::Run(U"Loop", U"ParallelForEachBodyError", [](const Tests::Expect& expect)
+			{
+				Array<double> recorded;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<Array<double>()>(U"Elements", { U"array" }, []()
+					{
+						return Array<double>{ 1.0, 2.0, 3.0 };
+					}, NodeOptions{ .pure = true });
+				graph.registerNodeFunction<double(double, double)>(U"Sum", { U"result",U"a",U"b" }, [](double a, double b)
+					{
+						return a + b;
+					}, NodeOptions{ .pure = true, .threadSafe = true });
+				graph.registerNodeFunction<void(Array<double>)>(U"Record", { U"array" }, [&recorded](Array<double> array)
+					{
+						recorded = std::move(array);
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto array = *graph.addNode(U"Elements");
+				auto loop = *graph.addNode<Builtin::ParallelForEachNode>();
+				auto sum = *graph.addNode(U"Sum");
+				auto record = *graph.addNode(U"Record");
+
+				Fixtures::ConnectValue(array, 0, loop, 0);
+				Fixtures::ConnectValue(loop, 0, sum, 0);
+				Fixtures::ConnectValue(loop, 2, record, 0);
+				Fixtures::ConnectExec(entry, 0, record);
+
+				//resultが未接続
+				entry->run();
+				expect(loop->getError().code == NodeErrorCode::InputNotConnected && loop->getError().socketIdx == 1, U"result: code={}"_fmt(static_cast<int32>(loop->getError().code)));
+
+				//本体のノードの入力が未接続(変換の失敗は次の実行でも同じように記録される)
+				Fixtures::ConnectValue(sum, 0, loop, 1);
+				for (int32 i = 0; i < 2; i++)
+				{
+					entry->run();
+					expect(loop->getError().code == NodeErrorCode::BodyNotConnected && loop->getError().message == U"Sum", U"{}回目: code={}, node={}"_fmt(i + 1, static_cast<int32>(loop->getError().code), loop->getError().message));
+				}
+
+				Fixtures::ConnectValue(loop, 0, sum, 1);
+				entry->run();
+				expect(!loop->getError(), U"接続後: code={}"_fmt(static_cast<int32>(loop->getError().code)));
+				expect(recorded == Array<double>{ 2.0, 4.0, 6.0 }, U"接続後: results={}"_fmt(recorded));
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunLoop()
+{
+	Array<Result> results;
+
+	results << For();
+	results << NestedFor();
+	results << LongFor();
+	results << While();
+	results << ForEach();
+	results << LongWhile();
+	results << LongForEach();
+	results << ParallelForEach();
+	results << ParallelForEachBodyError();
+
+	return results;
+}
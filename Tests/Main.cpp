@@ -0,0 +1,71 @@
+#include<Siv3D.hpp>
+#include<cstdio>
+#include<cstdlib>
+#include<iostream>
+#include"Tests.hpp"
+
+void Main()
+{
+	Array<Tests::Result> results;
+
+	results.append(Tests::RunNode());
+	results.append(Tests::RunExecutionPlan());
+	results.append(Tests::RunBytecode());
+	results.append(Tests::RunBatch());
+	results.append(Tests::RunLoop());
+	results.append(Tests::RunSubgraph());
+	results.append(Tests::RunThreadPool());
+	results.append(Tests::RunTrace());
+
+	//自動実行でも結果を確認できるようにJSONで書き出す
+	JSONWriter writer;
+	writer.startObject();
+	{
+		writer.key(U"results").startArray();
+		for (const auto& result : results)
+		{
+			writer.startObject();
+			writer.key(U"group").write(result.group);
+			writer.key(U"name").write(result.name);
+			writer.key(U"passed").write(result.passed());
+			writer.key(U"failures").startArray();
+			for (const auto& failure : result.failures)
+			{
+				writer.write(failure);
+			}
+			writer.endArray();
+			writer.endObject();
+		}
+		writer.endArray();
+	}
+	writer.endObject();
+
+	TextWriter(U"tests.json").write(writer.get());
+
+	//ヘッドレスのランタイムに対して実行するので、結果はコンソールに出力してすぐに終了する
+	Console.open();
+
+	const auto failed = results.count_if([](const Tests::Result& result) { return !result.passed(); });
+	Console << U"{}/{} passed"_fmt(results.size() - failed, results.size());
+
+	for (const auto& result : results)
+	{
+		if (!result.passed())
+		{
+			Console << U"FAILED {}/{}"_fmt(result.group, result.name);
+			for (const auto& failure : result.failures)
+			{
+				Console << U"  " + failure;
+			}
+		}
+	}
+
+	//CIやctestが失敗を判定できるよう、失敗があれば終了コードで知らせる
+	//(Siv3DのMainは戻り値を返せないので、出力を書き出してからその場で終了する)
+	if (failed)
+	{
+		std::fflush(stdout);
+		std::cout.flush();
+		std::_Exit(EXIT_FAILURE);
+	}
+}
@@ -0,0 +1,347 @@
+#include"Tests.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//ValueSlot::InlineSizeより大きく、共有の不変バッファで保持される値
+	using Block = std::array<int32, 16>;
+
+	//valueを出力する
+	class BlockNode : public Node
+	{
+	private:
+
+		void childRun() override
+		{
+			setOutput(0, value);
+		}
+
+	public:
+
+		Block value{};
+
+		BlockNode()
+		{
+			Name = U"Block";
+			cfgOutputSockets({ {Type::getType<Block>(),U"value"} });
+		}
+	};
+
+	//読んだ入力の値のアドレスを記録する
+	class ReadNode : public Node
+	{
+	private:
+
+		void childRun() override
+		{
+			address = &getInput<Block>(0);
+		}
+
+	public:
+
+		const Block* address = nullptr;
+
+		ReadNode()
+		{
+			Name = U"Read";
+			cfgInputSockets({ {Type::getType<Block>(),U"value"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//入力ソケットは接続先の出力ソケットの値をコピーせずに読み、切断後も同じバッファを持ち続ける
+	Tests::Result ReadInputInPlace()
+	{
+		return Tests::Run(U"Node", U"ReadInputInPlace", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto block = std::make_shared<BlockNode>();
+				auto read = std::make_shared<ReadNode>();
+
+				block->value[0] = 1;
+				Fixtures::ConnectValue(block, 0, read, 0);
+				Fixtures::ConnectExec(entry, 0, read);
+
+				entry->run();
+				const Block* output = &block->getOutputSockets()[0]->value().get<Block>();
+				expect(read->address == output, U"入力の値がコピーされた");
+
+				ISocket::disconnect(read->getInputSockets()[0]);
+				const auto& input = read->getInputSockets()[0]->value();
+				expect(input.hasValue() && &input.get<Block>() == output, U"切断後: 値がコピーされた");
+				expect(input.hasValue() && input.get<Block>()[0] == 1, U"切断後: 値が変わった");
+			});
+	}
+
+	//setがtrueなら出力し、messageが空でなければ例外を送出する
+	class FaultyNode : public Node
+	{
+	private:
+
+		void childRun() override
+		{
+			if (!message.isEmpty())
+			{
+				throw Error(message);
+			}
+			if (set)
+			{
+				setOutput(0, 1);
+			}
+		}
+
+	public:
+
+		bool set = false;
+
+		String message;
+
+		FaultyNode()
+		{
+			Name = U"Faulty";
+			cfgOutputSockets({ {Type::getType<int32>(),U"result"} });
+			cfgPrevExecSocket({ U"" });
+			cfgNextExecSocket({ U"" });
+		}
+	};
+
+	//実行の失敗はエラーコードと原因のソケットで記録し、メッセージはエラーが変わったときに作る
+	Tests::Result RecordErrorCodes()
+	{
+		return Tests::Run(U"Node", U"RecordErrorCodes", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				auto sink = std::make_shared<Fixtures::SinkNode<>>(2);
+				auto faulty = std::make_shared<FaultyNode>();
+
+				Fixtures::ConnectValue(faulty, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, faulty);
+				Fixtures::ConnectExec(faulty, 0, sink);
+
+				const auto code = [](const std::shared_ptr<Node>& node)
+				{
+					return static_cast<int32>(node->getError().code);
+				};
+
+				//出力を設定しない
+				entry->run();
+				expect(faulty->getError().code == NodeErrorCode::OutputNotSet && faulty->getError().socketIdx == 0, U"OutputNotSet: code={}"_fmt(code(faulty)));
+				expect(faulty->getErrorMessage().includes(U"\"result\""), U"OutputNotSet: message={}"_fmt(faulty->getErrorMessage()));
+				expect(sink->runs == 0, U"OutputNotSet: sink.runs={}"_fmt(sink->runs));
+
+				//例外のメッセージはそのまま表示し、変わったら作り直す
+				faulty->message = U"first";
+				entry->run();
+				expect(faulty->getError().code == NodeErrorCode::Exception && faulty->getErrorMessage() == U"first", U"Exception: code={}, message={}"_fmt(code(faulty), faulty->getErrorMessage()));
+				faulty->message = U"second";
+				entry->run();
+				expect(faulty->getErrorMessage() == U"second", U"Exception: message={}"_fmt(faulty->getErrorMessage()));
+
+				//2番目の入力が未接続
+				faulty->message.clear();
+				faulty->set = true;
+				entry->run();
+				expect(!faulty->getError() && faulty->getErrorMessage().isEmpty(), U"復帰: code={}, message={}"_fmt(code(faulty), faulty->getErrorMessage()));
+				expect(sink->getError().code == NodeErrorCode::InputNotConnected && sink->getError().socketIdx == 1, U"InputNotConnected: code={}, socket={}"_fmt(code(sink), sink->getError().socketIdx));
+				expect(sink->getErrorMessage().includes(U"\"value\""), U"InputNotConnected: message={}"_fmt(sink->getErrorMessage()));
+				expect(sink->runs == 0, U"InputNotConnected: sink.runs={}"_fmt(sink->runs));
+
+				Fixtures::ConnectValue(faulty, 0, sink, 1);
+				entry->run();
+				expect(!sink->getError() && sink->runs == 1 && sink->value == 2, U"接続後: code={}, sink.runs={}, value={}"_fmt(code(sink), sink->runs, sink->value));
+			});
+	}
+
+	//関数のノードは入力ソケットiを引数iに渡す(引数の評価順序に依存しない)
+	Tests::Result FunctionArgumentOrder()
+	{
+		return Tests::Run(U"Node", U"FunctionArgumentOrder", [](const Tests::Expect& expect)
+			{
+				Array<std::pair<int32, int32>> log;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32, int32, int32)>(U"Digits", { U"result",U"a",U"b",U"c" }, [](int32 a, int32 b, int32 c)
+					{
+						return a * 100 + b * 10 + c;
+					}, NodeOptions{ .pure = true });
+				graph.registerNodeFunction<void(int32, int32)>(U"Log", { U"a",U"b" }, [&log](int32 a, int32 b)
+					{
+						log << std::pair{ a, b };
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto digits = *graph.addNode(U"Digits");
+				auto logger = *graph.addNode(U"Log");
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+
+				for (int32 i = 0; i < 3; i++)
+				{
+					auto constant = *graph.addNode<Fixtures::ConstantNode>();
+					std::dynamic_pointer_cast<Fixtures::ConstantNode>(constant)->setValue(i + 1);
+					Fixtures::ConnectValue(constant, 0, digits, i);
+					if (i < 2)
+					{
+						Fixtures::ConnectValue(constant, 0, logger, i);
+					}
+				}
+				Fixtures::ConnectValue(digits, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, logger);
+				Fixtures::ConnectExec(logger, 0, sink);
+
+				entry->run();
+				expect(sink->value == 123, U"ExecutionPlan: sink={}"_fmt(sink->value));
+				expect(log.size() == 1 && log[0] == std::pair{ 1, 2 }, U"ExecutionPlan: log.size={}"_fmt(log.size()));
+
+				//命令列は関数テーブルから引数のレジスタを渡して呼び出す
+				const auto bytecode = graph.compile(*entry);
+				bytecode->run();
+				expect(bytecode->callCount() == 2, U"Bytecode: calls={}"_fmt(bytecode->callCount()));
+				expect(sink->value == 123, U"Bytecode: sink={}"_fmt(sink->value));
+				expect(log.size() == 2 && log[1] == std::pair{ 1, 2 }, U"Bytecode: log.size={}"_fmt(log.size()));
+			});
+	}
+
+	//登録時に指定した性質は、追加したノードにも読み込んだノードにも適用される(boolを渡す登録ではthreadSafeを指定する)
+	Tests::Result ApplyNodeOptions()
+	{
+		return Tests::Run(U"Node", U"ApplyNodeOptions", [](const Tests::Expect& expect)
+			{
+				const auto caller = std::this_thread::get_id();
+				size_t calls = 0;
+				std::atomic<size_t> pooled = 0;
+
+				const auto registerFunctions = [&](Graph& graph)
+				{
+					Tests::RegisterNodes(graph);
+					graph.registerNodeFunction<int32(int32)>(U"Twice", { U"result",U"a" }, [&calls](int32 a)
+						{
+							calls++;
+							return a * 2;
+						}, NodeOptions{ .pure = true });
+					graph.registerNodeFunction<int32(int32)>(U"Where", { U"result",U"a" }, [&pooled, caller](int32 a)
+						{
+							pooled += std::this_thread::get_id() != caller;
+							return a;
+						}, true);
+				};
+
+				//直列に2回、スレッドプールで1回実行する(Twiceは初回だけ呼ばれ、Whereはプールでだけ別スレッドから呼ばれる)
+				ThreadPool pool(2);
+				const auto check = [&](const String& label, Node& entry)
+				{
+					calls = 0;
+					pooled = 0;
+					entry.run();
+					entry.run();
+					entry.run(pool);
+					expect(calls == 1, U"{}: calls={}"_fmt(label, calls));
+					expect(pooled == 1, U"{}: pooled={}"_fmt(label, pooled.load()));
+				};
+
+				Graph graph;
+				registerFunctions(graph);
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto constant = *graph.addNode<Fixtures::ConstantNode>();
+				auto twice = *graph.addNode(U"Twice");
+				auto where = *graph.addNode(U"Where");
+				auto first = *graph.addNode<Fixtures::SinkNode<>>();
+				auto second = *graph.addNode<Fixtures::SinkNode<>>();
+
+				constant->setValue(3);
+				Fixtures::ConnectValue(constant, 0, twice, 0);
+				Fixtures::ConnectValue(constant, 0, where, 0);
+				Fixtures::ConnectValue(twice, 0, first, 0);
+				Fixtures::ConnectValue(where, 0, second, 0);
+				Fixtures::ConnectExec(entry, 0, first);
+				Fixtures::ConnectExec(first, 0, second);
+
+				check(U"addNode", *entry);
+				expect(first->value == 6 && second->value == 3, U"first={}, second={}"_fmt(first->value, second->value));
+
+				Graph loaded;
+				registerFunctions(loaded);
+				const auto text = graph.save().toUTF8();
+				loaded.load(JSONReader(ByteArray(text.data(), text.size())));
+
+				std::shared_ptr<Fixtures::EntryNode> loadedEntry;
+				for (const auto& node : loaded.nodes())
+				{
+					if (auto p = std::dynamic_pointer_cast<Fixtures::EntryNode>(node))
+					{
+						loadedEntry = p;
+					}
+				}
+				expect(static_cast<bool>(loadedEntry), U"ノードが読み込まれていない");
+				if (!loadedEntry)
+				{
+					return;
+				}
+
+				check(U"load", *loadedEntry);
+			});
+	}
+
+	//NODEEDITOR_PROFILEを定義した構成では実行した回数と時間を記録する(定義しない構成では何も記録しない)
+	Tests::Result RecordProfile()
+	{
+		return Tests::Run(U"Node", U"RecordProfile", [](const Tests::Expect& expect)
+			{
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32)>(U"Increment", { U"result",U"a" }, [](int32 a)
+					{
+						return a + 1;
+					});
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto counter = *graph.addNode<Fixtures::CounterNode<>>();
+				auto increment = *graph.addNode(U"Increment");
+				auto sink = *graph.addNode<Fixtures::SinkNode<>>();
+
+				Fixtures::ConnectValue(counter, 0, increment, 0);
+				Fixtures::ConnectValue(increment, 0, sink, 0);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				//ExecutionPlanで3回、命令列で2回(関数は関数テーブルから直接呼び出す)
+				for (int32 i = 0; i < 3; i++)
+				{
+					entry->run();
+				}
+				const auto bytecode = graph.compile(*entry);
+				bytecode->run();
+				bytecode->run();
+				expect(bytecode->callCount() == 1, U"calls={}"_fmt(bytecode->callCount()));
+
+#ifdef NODEEDITOR_PROFILE
+				constexpr uint64 Expected = 5;
+#else
+				constexpr uint64 Expected = 0;
+#endif
+				for (const auto& node : Array<std::shared_ptr<Node>>{ counter, increment, sink })
+				{
+					const auto& profile = node->getProfile();
+					expect(profile.calls == Expected && profile.totalNs >= profile.lastNs, U"{}: calls={}, total={}ns, last={}ns"_fmt(node->Name, profile.calls, profile.totalNs, profile.lastNs));
+				}
+
+				sink->resetProfile();
+				expect(sink->getProfile().calls == 0 && sink->getProfile().totalNs == 0, U"reset: calls={}"_fmt(sink->getProfile().calls));
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunNode()
+{
+	Array<Result> results;
+
+	results << ReadInputInPlace();
+	results << RecordErrorCodes();
+	results << FunctionArgumentOrder();
+	results << ApplyNodeOptions();
+	results << RecordProfile();
+
+	return results;
+}
@@ -0,0 +1,251 @@
+#include"Tests.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//constant -> first -> second -> sink を実行する、entry -> sink のグラフ
+	struct QuadGraph
+	{
+		Graph graph;
+
+		std::shared_ptr<Fixtures::EntryNode> entry;
+
+		std::shared_ptr<Fixtures::ConstantNode> constant;
+
+		std::shared_ptr<Fixtures::DoubleNode> first;
+
+		std::shared_ptr<Fixtures::DoubleNode> second;
+
+		std::shared_ptr<Fixtures::SinkNode<>> sink;
+
+		QuadGraph()
+		{
+			Tests::RegisterNodes(graph);
+
+			entry = *graph.addNode<Fixtures::EntryNode>();
+			constant = *graph.addNode<Fixtures::ConstantNode>();
+			first = *graph.addNode<Fixtures::DoubleNode>();
+			second = *graph.addNode<Fixtures::DoubleNode>();
+			sink = *graph.addNode<Fixtures::SinkNode<>>();
+
+			constant->setValue(3);
+			Fixtures::ConnectValue(constant, 0, first, 0);
+			Fixtures::ConnectValue(first, 0, second, 0);
+			Fixtures::ConnectValue(second, 0, sink, 0);
+			Fixtures::ConnectExec(entry, 0, sink);
+		}
+	};
+
+	//まとめたノードは元のノードをそのまま内部に持ち、まとめる前と同じ値を計算する
+	Tests::Result Collapse()
+	{
+		return Tests::Run(U"Subgraph", U"Collapse", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				const size_t before = g.graph.nodes().size();
+
+				const auto subgraph = g.graph.collapse({ g.first, g.second }, U"Quad");
+				const auto& definition = subgraph->definition();
+				expect(definition.className() == U"Subgraph::Quad", U"class={}"_fmt(definition.className()));
+				expect(definition.Inputs.size() == 1 && definition.Outputs.size() == 1, U"inputs={}, outputs={}"_fmt(definition.Inputs.size(), definition.Outputs.size()));
+				expect(g.graph.nodes().size() == before - 1, U"nodes={}"_fmt(g.graph.nodes().size()));
+				expect(subgraph->nodes().includes(g.first) && subgraph->nodes().includes(g.second), U"元のノードが使われていない");
+
+				g.entry->run();
+				expect(g.sink->value == 12, U"sink={}"_fmt(g.sink->value));
+
+				g.constant->setValue(5);
+				g.entry->run();
+				expect(g.sink->value == 20, U"変更後: sink={}"_fmt(g.sink->value));
+			});
+	}
+
+	//登録された定義から別のインスタンスを生成できる
+	Tests::Result Instantiate()
+	{
+		return Tests::Run(U"Subgraph", U"Instantiate", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				const auto subgraph = g.graph.collapse({ g.first, g.second }, U"Quad");
+
+				auto instance = g.graph.addNode(subgraph->definition().className());
+				expect(instance.has_value(), U"addNodeに失敗");
+				if (!instance)
+				{
+					return;
+				}
+
+				auto constant = *g.graph.addNode<Fixtures::ConstantNode>();
+				auto sink = *g.graph.addNode<Fixtures::SinkNode<>>();
+				constant->setValue(10);
+				Fixtures::ConnectValue(constant, 0, *instance, 0);
+				Fixtures::ConnectValue(*instance, 0, sink, 0);
+				Fixtures::ConnectExec(g.sink, 0, sink);
+
+				g.entry->run();
+				expect(g.sink->value == 12, U"sink={}"_fmt(g.sink->value));
+				expect(sink->value == 40, U"2つ目: sink={}"_fmt(sink->value));
+			});
+	}
+
+	//サブグラフを含むグラフを保存して読み込むと同じ値を計算する
+	Tests::Result SaveLoad()
+	{
+		return Tests::Run(U"Subgraph", U"SaveLoad", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				g.graph.collapse({ g.first, g.second }, U"Quad");
+
+				Graph loaded;
+				Tests::RegisterNodes(loaded);
+				const auto text = g.graph.save().toUTF8();
+				loaded.load(JSONReader(ByteArray(text.data(), text.size())));
+				expect(loaded.subgraphs().size() == 1, U"subgraphs={}"_fmt(loaded.subgraphs().size()));
+
+				std::shared_ptr<Fixtures::EntryNode> entry;
+				std::shared_ptr<Fixtures::SinkNode<>> sink;
+				for (const auto& node : loaded.nodes())
+				{
+					if (auto p = std::dynamic_pointer_cast<Fixtures::EntryNode>(node))
+					{
+						entry = p;
+					}
+					if (auto p = std::dynamic_pointer_cast<Fixtures::SinkNode<>>(node))
+					{
+						sink = p;
+					}
+				}
+				expect(entry && sink, U"ノードが読み込まれていない");
+				if (!entry || !sink)
+				{
+					return;
+				}
+
+				entry->run();
+				expect(sink->value == 12, U"sink={}"_fmt(sink->value));
+			});
+	}
+
+	//グラフのノードとサブグラフの内部のノード(入れ子を含む)のID
+	void CollectIds(const Array<std::shared_ptr<Node>>& nodes, Array<size_t>& ids)
+	{
+		for (const auto& node : nodes)
+		{
+			ids << node->ID;
+			if (const auto subgraph = std::dynamic_pointer_cast<SubgraphNode>(node))
+			{
+				CollectIds(subgraph->nodes(), ids);
+			}
+		}
+	}
+
+	//サブグラフのインスタンスごとに内部のノードのIDが割り当てられ、読み込んだグラフでも重複しない
+	Tests::Result UniqueInnerIds()
+	{
+		return Tests::Run(U"Subgraph", U"UniqueInnerIds", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				const auto subgraph = g.graph.collapse({ g.first, g.second }, U"Quad");
+				g.graph.addNode(subgraph->definition().className());
+				g.graph.addNode(subgraph->definition().className());
+
+				const auto check = [&](const String& label, const Graph& graph)
+				{
+					Array<size_t> ids;
+					CollectIds(graph.nodes(), ids);
+					const size_t count = ids.size();
+					expect(count == graph.nodes().size() + 3 * 2, U"{}: ids={}"_fmt(label, count));
+					expect(HashSet<size_t>(ids.begin(), ids.end()).size() == count, U"{}: 重複したID"_fmt(label));
+				};
+
+				check(U"addNode", g.graph);
+
+				Graph loaded;
+				Tests::RegisterNodes(loaded);
+				const auto text = g.graph.save().toUTF8();
+				loaded.load(JSONReader(ByteArray(text.data(), text.size())));
+				check(U"load", loaded);
+			});
+	}
+
+	//内部のノードのエラーは、描画されるサブグラフのノードから参照できる
+	Tests::Result InnerErrors()
+	{
+		return Tests::Run(U"Subgraph", U"InnerErrors", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				const auto subgraph = g.graph.collapse({ g.first, g.second }, U"Quad");
+
+				//サブグラフの入力を外すと、内部の最初のノードが失敗する
+				ISocket::disconnect(subgraph->getInputSockets()[0]);
+				g.entry->run();
+				expect(!subgraph->getError(), U"サブグラフのノード自身にエラーが記録された");
+				expect(subgraph->errorSource() == g.first.get(), U"内部のノードのエラーを参照できない");
+				expect(g.first->getError().code == NodeErrorCode::InputNotConnected, U"code={}"_fmt(static_cast<int32>(g.first->getError().code)));
+
+				Fixtures::ConnectValue(g.constant, 0, subgraph, 0);
+				g.entry->run();
+				expect(subgraph->errorSource() == nullptr, U"接続後: エラーが残っている");
+				expect(g.sink->value == 12, U"接続後: sink={}"_fmt(g.sink->value));
+			});
+	}
+
+	//展開すると内部のノードがグラフに戻り、接続も元に戻る
+	Tests::Result Expand()
+	{
+		return Tests::Run(U"Subgraph", U"Expand", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				const size_t before = g.graph.nodes().size();
+				const auto subgraph = g.graph.collapse({ g.first, g.second }, U"Quad");
+				g.entry->run();
+
+				const auto expanded = g.graph.expand(subgraph);
+				expect(expanded.size() == 2, U"expanded={}"_fmt(expanded.size()));
+				expect(g.graph.nodes().size() == before, U"nodes={}"_fmt(g.graph.nodes().size()));
+
+				g.constant->setValue(4);
+				g.entry->run();
+				expect(g.sink->value == 16, U"sink={}"_fmt(g.sink->value));
+			});
+	}
+
+	//実行ソケットでつながったノードをまとめても同じ順で実行する
+	Tests::Result CollapseExec()
+	{
+		return Tests::Run(U"Subgraph", U"CollapseExec", [](const Tests::Expect& expect)
+			{
+				QuadGraph g;
+				auto a = *g.graph.addNode<Fixtures::StepNode>();
+				auto b = *g.graph.addNode<Fixtures::StepNode>();
+				auto c = *g.graph.addNode<Fixtures::StepNode>();
+				Fixtures::ConnectExec(g.sink, 0, a);
+				Fixtures::ConnectExec(a, 0, b);
+				Fixtures::ConnectExec(b, 0, c);
+
+				const auto subgraph = g.graph.collapse({ a, b }, U"AB");
+				expect(subgraph->getPrevNodeSockets().size() == 1 && subgraph->getNextNodeSockets().size() == 1,
+					U"prev={}, next={}"_fmt(subgraph->getPrevNodeSockets().size(), subgraph->getNextNodeSockets().size()));
+
+				g.entry->run();
+				expect(a->runs == 1 && b->runs == 1 && c->runs == 1, U"a={}, b={}, c={}"_fmt(a->runs, b->runs, c->runs));
+				expect(g.sink->runs == 1, U"sink.runs={}"_fmt(g.sink->runs));
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunSubgraph()
+{
+	Array<Result> results;
+
+	results << Collapse();
+	results << Instantiate();
+	results << SaveLoad();
+	results << UniqueInnerIds();
+	results << InnerErrors();
+	results << Expand();
+	results << CollapseExec();
+
+	return results;
+}
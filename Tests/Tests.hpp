@@ -0,0 +1,111 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<functional>
+#include"Graph.hpp"
+#include"Fixtures.hpp"
+
+namespace Tests
+{
+	/// <summary>
+	/// テストケース1つの結果
+	/// </summary>
+	struct Result
+	{
+		String group;
+
+		String name;
+
+		//満たされなかった条件のメッセージ(空なら成功)
+		Array<String> failures;
+
+		bool passed() const
+		{
+			return failures.isEmpty();
+		}
+	};
+
+	//条件がfalseならメッセージを失敗として記録する
+	using Expect = std::function<void(bool, const String&)>;
+
+	/// <summary>
+	/// funcを実行して、expectで記録された失敗と送出された例外を集める
+	/// </summary>
+	/// <param name="func">Expectを受け取る関数</param>
+	template<class Func>
+	Result Run(const String& group, const String& name, Func&& func)
+	{
+		Result result{ group, name, {} };
+		const Expect expect = [&result](bool condition, const String& message)
+		{
+			if (!condition)
+			{
+				result.failures << message;
+			}
+		};
+
+		try
+		{
+			func(expect);
+		}
+		catch (const Error& ex)
+		{
+			result.failures << U"例外: " + ex.what();
+		}
+		return result;
+	}
+
+	//テスト用のノードの種類を登録する
+	inline void RegisterNodes(NodeEditor::Graph& graph)
+	{
+		graph.registerBuiltinNodes();
+		graph.registerNodeType<Fixtures::EntryNode>();
+		graph.registerNodeType<Fixtures::CounterNode<>>();
+		graph.registerNodeType<Fixtures::ConstantNode>();
+		graph.registerNodeType<Fixtures::FoldableConstantNode>();
+		graph.registerNodeType<Fixtures::DoubleNode>();
+		graph.registerNodeType<Fixtures::SinkNode<>>();
+		graph.registerNodeType<Fixtures::StepNode>();
+		graph.registerNodeType<Fixtures::ToggleNode>();
+		graph.registerNodeType<Fixtures::BranchNode>();
+	}
+
+	/// <summary>
+	/// 入力ソケットが接続先の値をコピーせずに読むこと、エラーコードとメッセージの記録、関数の引数の順序、登録時に指定した性質の適用(読み込んだノードを含む)、実行回数と時間の計測
+	/// </summary>
+	Array<Result> RunNode();
+
+	/// <summary>
+	/// 入力の生成元の評価回数、失敗した生成元の伝播、ステップ数の上限、循環した計画の拒否、入力が変化しないノードの省略(関数と入力の無いノードは省略しない)、定数の畳み込み、実行しないノード(副作用のある関数は実行し、起点の無いグラフには無い)、同じ入力のノードの統合(分岐をまたぐ場合と、まとめたノードの出力を含む)、pureやdeterministicを指定して登録した関数、短い時間枠で区切った実行、中断したノードの再開(作り直した計画、Async::Delay、Async::Background)
+	/// </summary>
+	Array<Result> RunExecutionPlan();
+
+	/// <summary>
+	/// 命令列が関数を呼び出すのは、ノードを生成したグラフの関数テーブルで変換した場合だけであること、インスタンスごとのエラー
+	/// </summary>
+	Array<Result> RunBytecode();
+
+	/// <summary>
+	/// 列の演算のSSE2の部分と端数の部分、列全体を計算するノードと要素ごとに実行するノードの混在
+	/// </summary>
+	Array<Result> RunBatch();
+
+	/// <summary>
+	/// For/While/ForEach/ParallelForEachの反復、1,000,000回の反復とステップ数の上限
+	/// </summary>
+	Array<Result> RunLoop();
+
+	/// <summary>
+	/// サブグラフのまとめ/展開と実行、保存/読み込み、インスタンスごとの内部のノードのID、内部のノードのエラーの参照
+	/// </summary>
+	Array<Result> RunSubgraph();
+
+	/// <summary>
+	/// スレッドプールへの大量のタスクの追加、並列実行と直列実行の結果の一致、評価時間の短いノードを呼び出したスレッドで評価すること
+	/// </summary>
+	Array<Result> RunThreadPool();
+
+	/// <summary>
+	/// 実行の記録のJSONへの書き出し、リングバッファの上書き、スレッドごとの記録
+	/// </summary>
+	Array<Result> RunTrace();
+}
@@ -0,0 +1,196 @@
+#include"Tests.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//複数のスレッドとワーカー内から大量に追加したタスクが、全て1度ずつ実行される
+	Tests::Result SubmitStress()
+	{
+		return Tests::Run(U"ThreadPool", U"SubmitStress", [](const Tests::Expect& expect)
+			{
+				constexpr size_t ThreadCount = 4;
+				constexpr size_t TasksPerThread = 10000;
+				constexpr size_t NestedCount = 4;
+				constexpr size_t Total = ThreadCount * TasksPerThread * (NestedCount + 1);
+
+				std::atomic<size_t> done = 0;
+				std::mutex mutex;
+				std::condition_variable cv;
+
+				const auto finish = [&]()
+				{
+					if (++done == Total)
+					{
+						std::lock_guard lock(mutex);
+						cv.notify_all();
+					}
+				};
+
+				ThreadPool pool(4);
+				{
+					Array<std::thread> threads;
+					for (size_t t = 0; t < ThreadCount; t++)
+					{
+						threads.emplace_back([&]()
+							{
+								for (size_t i = 0; i < TasksPerThread; i++)
+								{
+									//ワーカー内から追加したタスクはそのワーカーのキューに積まれ、他のワーカーに盗まれうる
+									pool.submit([&]()
+										{
+											for (size_t n = 0; n < NestedCount; n++)
+											{
+												pool.submit(finish);
+											}
+											finish();
+										});
+								}
+							});
+					}
+					for (auto& thread : threads)
+					{
+						thread.join();
+					}
+				}
+
+				std::unique_lock lock(mutex);
+				const bool completed = cv.wait_for(lock, std::chrono::seconds(30), [&]() { return done == Total; });
+				expect(completed, U"done={}/{}"_fmt(done.load(), Total));
+			});
+	}
+
+	//ThreadSafeなノードをスレッドプールで並列に評価しても、直列に評価したときと同じ結果になる
+	Tests::Result ParallelMatchesSerial()
+	{
+		return Tests::Run(U"ThreadPool", U"ParallelMatchesSerial", [](const Tests::Expect& expect)
+			{
+				constexpr size_t Width = 16;
+				constexpr size_t Depth = 8;
+
+				struct Built
+				{
+					std::shared_ptr<Node> entry;
+
+					std::shared_ptr<Fixtures::SinkNode<>> sink;
+				};
+
+				//各段のノードは前の段のi番目とi+1番目を読む(入力の順序で結果が変わる関数でつなぐ)
+				const auto build = [&](Graph& graph)
+				{
+					Tests::RegisterNodes(graph);
+					graph.registerNodeFunction<int32(int32, int32)>(U"Mix", { U"result",U"a",U"b" }, [](int32 a, int32 b)
+						{
+							return (a % 1000003) * 31 + b % 1000003;
+						}, NodeOptions{ .pure = true, .threadSafe = true });
+
+					Built built;
+					built.entry = *graph.addNode<Fixtures::EntryNode>();
+					built.sink = std::make_shared<Fixtures::SinkNode<>>(Width);
+					graph.addNode(built.sink);
+
+					Array<std::shared_ptr<Node>> layer;
+					for (size_t i = 0; i < Width; i++)
+					{
+						auto counter = *graph.addNode<Fixtures::CounterNode<>>();
+						//列ごとに異なる値から数え始める
+						std::dynamic_pointer_cast<Fixtures::CounterNode<>>(counter)->value = static_cast<int32>(i * 7);
+						layer << counter;
+					}
+					for (size_t d = 0; d < Depth; d++)
+					{
+						Array<std::shared_ptr<Node>> next;
+						for (size_t i = 0; i < Width; i++)
+						{
+							auto mix = *graph.addNode(U"Mix");
+							Fixtures::ConnectValue(layer[i], 0, mix, 0);
+							Fixtures::ConnectValue(layer[(i + 1) % Width], 0, mix, 1);
+							next << mix;
+						}
+						layer = std::move(next);
+					}
+					for (size_t i = 0; i < Width; i++)
+					{
+						Fixtures::ConnectValue(layer[i], 0, built.sink, i);
+					}
+					Fixtures::ConnectExec(built.entry, 0, built.sink);
+					return built;
+				};
+
+				Graph serialGraph;
+				Graph parallelGraph;
+				const auto serial = build(serialGraph);
+				const auto parallel = build(parallelGraph);
+
+				const auto serialPlan = ExecutionPlan::Compile(*serial.entry);
+				const auto parallelPlan = ExecutionPlan::Compile(*parallel.entry);
+
+				ThreadPool pool(4);
+				for (int32 pass = 1; pass <= 20; pass++)
+				{
+					serialPlan->run();
+					parallelPlan->run(&pool);
+					expect(serial.sink->value == parallel.sink->value, U"{}回目: serial={}, parallel={}"_fmt(pass, serial.sink->value, parallel.sink->value));
+				}
+				expect(serial.sink->runs == 20 && parallel.sink->runs == 20, U"serial.runs={}, parallel.runs={}"_fmt(serial.sink->runs, parallel.sink->runs));
+			});
+	}
+
+	//ThreadSafeでもCostがExecutionPlan::MinParallelCostに満たないノードは呼び出したスレッドで評価し、Costが不明なノードはプールに渡す
+	Tests::Result KeepCheapNodesOnCaller()
+	{
+		return Tests::Run(U"ThreadPool", U"KeepCheapNodesOnCaller", [](const Tests::Expect& expect)
+			{
+				const auto caller = std::this_thread::get_id();
+				std::atomic<size_t> cheapPooled = 0;
+				std::atomic<size_t> unknownPooled = 0;
+
+				Graph graph;
+				Tests::RegisterNodes(graph);
+				graph.registerNodeFunction<int32(int32)>(U"Cheap", { U"result",U"a" }, [&cheapPooled, caller](int32 a)
+					{
+						cheapPooled += std::this_thread::get_id() != caller;
+						return a;
+					}, NodeOptions{ .threadSafe = true, .cost = ExecutionPlan::MinParallelCost / 2 });
+				graph.registerNodeFunction<int32(int32)>(U"Unknown", { U"result",U"a" }, [&unknownPooled, caller](int32 a)
+					{
+						unknownPooled += std::this_thread::get_id() != caller;
+						return a;
+					}, NodeOptions{ .threadSafe = true });
+
+				auto entry = *graph.addNode<Fixtures::EntryNode>();
+				auto counter = *graph.addNode<Fixtures::CounterNode<>>();
+				auto cheap = *graph.addNode(U"Cheap");
+				auto unknown = *graph.addNode(U"Unknown");
+				auto sink = std::make_shared<Fixtures::SinkNode<>>(2);
+				graph.addNode(sink);
+
+				Fixtures::ConnectValue(counter, 0, cheap, 0);
+				Fixtures::ConnectValue(counter, 0, unknown, 0);
+				Fixtures::ConnectValue(cheap, 0, sink, 0);
+				Fixtures::ConnectValue(unknown, 0, sink, 1);
+				Fixtures::ConnectExec(entry, 0, sink);
+
+				const auto plan = ExecutionPlan::Compile(*entry);
+				ThreadPool pool(2);
+				for (int32 pass = 1; pass <= 3; pass++)
+				{
+					plan->run(&pool);
+					expect(sink->value == pass * 2, U"{}回目: sink={}"_fmt(pass, sink->value));
+				}
+				expect(cheapPooled == 0, U"cheap: pooled={}"_fmt(cheapPooled.load()));
+				expect(unknownPooled == 3, U"unknown: pooled={}"_fmt(unknownPooled.load()));
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunThreadPool()
+{
+	Array<Result> results;
+
+	results << SubmitStress();
+	results << ParallelMatchesSerial();
+	results << KeepCheapNodesOnCaller();
+
+	return results;
+}
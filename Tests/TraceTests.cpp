@@ -0,0 +1,184 @@
+#include"Tests.hpp"
+#include"Trace.hpp"
+
+using namespace NodeEditor;
+
+namespace
+{
+	//記録の状態をテストの前の状態に戻す
+	class TraceSession
+	{
+	public:
+
+		explicit TraceSession(size_t capacity = Trace::DefaultCapacity)
+		{
+			Trace::SetCapacity(capacity);
+			Trace::SetEnabled(true);
+		}
+
+		~TraceSession()
+		{
+			Trace::SetEnabled(false);
+			Trace::SetCapacity(Trace::DefaultCapacity);
+		}
+	};
+
+	//entry → steps[0] → steps[1] → …(記録を区別できるよう、steps[i]のIDはi + 1)
+	Array<std::shared_ptr<Fixtures::StepNode>> BuildChain(const std::shared_ptr<Node>& entry, size_t count)
+	{
+		Array<std::shared_ptr<Fixtures::StepNode>> steps;
+		for (size_t i = 0; i < count; i++)
+		{
+			steps << std::make_shared<Fixtures::StepNode>();
+			steps[i]->ID = i + 1;
+			Fixtures::ConnectExec(i == 0 ? entry : steps[i - 1], 0, steps[i]);
+		}
+		return steps;
+	}
+
+	//ToJSONの出力はtrace event形式で、開始時刻の順に並ぶ
+	Tests::Result WriteJSON()
+	{
+		return Tests::Run(U"Trace", U"WriteJSON", [](const Tests::Expect& expect)
+			{
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				const auto steps = BuildChain(entry, 3);
+				const auto plan = ExecutionPlan::Compile(*entry);
+
+				//記録していない間の実行は残らない
+				Trace::Clear();
+				plan->run();
+				{
+					const TraceSession session;
+					plan->run();
+				}
+				plan->run();
+
+				const auto text = Trace::ToJSON().toUTF8();
+				const JSONReader json(ByteArray(text.data(), text.size()));
+				expect(json[U"displayTimeUnit"].getString() == U"ns", U"displayTimeUnit={}"_fmt(json[U"displayTimeUnit"].getString()));
+
+				size_t passes = 0;
+				size_t stepEvents = 0;
+				bool recordedLast = false;
+				bool sorted = true;
+				double previous = -1;
+				for (const auto& event : json[U"traceEvents"].arrayView())
+				{
+					const auto category = event[U"cat"].getString();
+					passes += category == U"pass";
+					stepEvents += category == U"step";
+					if (category == U"node" && event[U"args"][U"id"].get<uint64>() == steps.back()->ID)
+					{
+						recordedLast = event[U"name"].getString() == U"Step" && event[U"args"][U"class"].getString() == steps.back()->Class;
+					}
+
+					expect(event[U"ph"].getString() == U"X" && event[U"dur"].get<double>() >= 0, U"ph={}, dur={}"_fmt(event[U"ph"].getString(), event[U"dur"].get<double>()));
+					const double ts = event[U"ts"].get<double>();
+					sorted &= previous <= ts;
+					previous = ts;
+				}
+				expect(passes == 1, U"passes={}"_fmt(passes));
+				expect(stepEvents == steps.size() + 1, U"steps={}"_fmt(stepEvents));
+				expect(recordedLast, U"最後のノードの記録がない");
+				expect(sorted, U"開始時刻の順に並んでいない");
+			});
+	}
+
+	//容量を超えた記録は古いものから上書きされ、新しいものが容量の数だけ残る
+	Tests::Result Wraparound()
+	{
+		return Tests::Run(U"Trace", U"Wraparound", [](const Tests::Expect& expect)
+			{
+				constexpr size_t Capacity = 4;
+
+				auto entry = std::make_shared<Fixtures::EntryNode>();
+				const auto steps = BuildChain(entry, 10);
+				const auto plan = ExecutionPlan::Compile(*entry);
+
+				{
+					const TraceSession session(Capacity);
+					plan->run();
+				}
+
+				const auto text = Trace::ToJSON().toUTF8();
+				const JSONReader json(ByteArray(text.data(), text.size()));
+				const auto events = json[U"traceEvents"];
+				expect(events.arrayCount() == Capacity, U"events={}"_fmt(events.arrayCount()));
+
+				//最後に終わる区間はパス全体で、最初のノードの記録は上書きされている
+				bool recordedPass = false;
+				bool recordedLast = false;
+				bool recordedFirst = false;
+				for (const auto& event : events.arrayView())
+				{
+					const auto id = event[U"args"][U"id"].get<uint64>();
+					recordedPass |= event[U"cat"].getString() == U"pass";
+					recordedLast |= id == steps.back()->ID;
+					recordedFirst |= id == steps.front()->ID;
+				}
+				expect(recordedPass && recordedLast && !recordedFirst, U"pass={}, last={}, first={}"_fmt(recordedPass, recordedLast, recordedFirst));
+			});
+	}
+
+	//スレッドごとのバッファに記録し、書き出すときに全てのスレッドの記録をまとめる
+	Tests::Result RecordPerThread()
+	{
+		return Tests::Run(U"Trace", U"RecordPerThread", [](const Tests::Expect& expect)
+			{
+				constexpr size_t ThreadCount = 4;
+				constexpr size_t EventsPerThread = 1000;
+
+				Fixtures::StepNode node;
+
+				{
+					const TraceSession session;
+
+					Array<std::thread> threads;
+					for (size_t t = 0; t < ThreadCount; t++)
+					{
+						threads.emplace_back([&]()
+							{
+								for (size_t i = 0; i < EventsPerThread; i++)
+								{
+									const detail::TraceScope trace(Trace::Category::Node, node);
+								}
+							});
+					}
+					for (auto& thread : threads)
+					{
+						thread.join();
+					}
+				}
+
+				const auto text = Trace::ToJSON().toUTF8();
+				const JSONReader json(ByteArray(text.data(), text.size()));
+				const auto events = json[U"traceEvents"];
+				expect(events.arrayCount() == ThreadCount * EventsPerThread, U"events={}"_fmt(events.arrayCount()));
+
+				HashSet<uint32> threadIds;
+				for (const auto& event : events.arrayView())
+				{
+					threadIds.emplace(event[U"tid"].get<uint32>());
+				}
+				expect(threadIds.size() == ThreadCount, U"tid={}"_fmt(threadIds.size()));
+
+				//終了したスレッドのバッファはClearで破棄される
+				Trace::Clear();
+				const auto cleared = Trace::ToJSON().toUTF8();
+				const JSONReader clearedJson(ByteArray(cleared.data(), cleared.size()));
+				expect(clearedJson[U"traceEvents"].arrayCount() == 0, U"Clear: events={}"_fmt(clearedJson[U"traceEvents"].arrayCount()));
+			});
+	}
+}
+
+Array<Tests::Result> Tests::RunTrace()
+{
+	Array<Result> results;
+
+	results << WriteJSON();
+	results << Wraparound();
+	results << RecordPerThread();
+
+	return results;
+}
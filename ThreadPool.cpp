@@ -0,0 +1,107 @@
+#include"ThreadPool.hpp"
+
+thread_local NodeEditor::ThreadPool* NodeEditor::ThreadPool::t_pool = nullptr;
+
+thread_local size_t NodeEditor::ThreadPool::t_workerIdx = 0;
+
+NodeEditor::ThreadPool::ThreadPool(size_t threadCount)
+{
+	threadCount = Max<size_t>(threadCount, 1);
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		m_threads.emplace_back([this, i]() { workerLoop(i); });
+	}
+}
+
+NodeEditor::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_sleepCv.notify_all();
+
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void NodeEditor::ThreadPool::submit(std::function<void()> task)
+{
+	//ワーカー内から呼ばれた場合は自分のキューに積む
+	const size_t workerIdx = t_pool == this ? t_workerIdx : m_nextWorker++ % m_workers.size();
+	{
+		//キューに積んでから数を増やす(起きたワーカーが空のキューを探して待ち続けないように、キューと同じロックの中で更新する)
+		auto& worker = *m_workers[workerIdx];
+		std::lock_guard lock(worker.mutex);
+		worker.tasks.push_back(std::move(task));
+		m_pending++;
+	}
+
+	{
+		std::lock_guard lock(m_sleepMutex);
+	}
+	m_sleepCv.notify_one();
+}
+
+bool NodeEditor::ThreadPool::tryPop(size_t workerIdx, std::function<void()>& task)
+{
+	//自分のキューは後ろから取り出す
+	{
+		auto& worker = *m_workers[workerIdx];
+		std::lock_guard lock(worker.mutex);
+		if (!worker.tasks.empty())
+		{
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+			m_pending--;
+			return true;
+		}
+	}
+
+	//他のワーカーのキューは前から盗む
+	for (size_t i = 1; i < m_workers.size(); i++)
+	{
+		auto& victim = *m_workers[(workerIdx + i) % m_workers.size()];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			m_pending--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void NodeEditor::ThreadPool::workerLoop(size_t workerIdx)
+{
+	t_pool = this;
+	t_workerIdx = workerIdx;
+
+	std::function<void()> task;
+	while (true)
+	{
+		if (tryPop(workerIdx, task))
+		{
+			task();
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock lock(m_sleepMutex);
+		m_sleepCv.wait(lock, [this]() { return m_stop || m_pending > 0; });
+		if (m_stop && m_pending == 0)
+		{
+			return;
+		}
+	}
+}
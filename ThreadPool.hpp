@@ -0,0 +1,72 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<mutex>
+#include<thread>
+
+namespace NodeEditor
+{
+	/// <summary>
+	/// ワークスティーリング方式のスレッドプール
+	/// </summary>
+	/// <remarks>
+	/// ワーカーごとにタスクのキューを持ち、自分のキューが空になると他のワーカーのキューから取り出す。
+	/// ワーカー内から追加されたタスクはそのワーカーのキューに積まれる。
+	/// </remarks>
+	class ThreadPool
+	{
+	private:
+
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		static thread_local ThreadPool* t_pool;
+
+		static thread_local size_t t_workerIdx;
+
+		Array<std::unique_ptr<Worker>> m_workers;
+
+		Array<std::thread> m_threads;
+
+		std::mutex m_sleepMutex;
+
+		std::condition_variable m_sleepCv;
+
+		//キューに積まれていて、まだ取り出されていないタスク数(キューのロック中にだけ増減する)
+		std::atomic<size_t> m_pending = 0;
+
+		std::atomic<size_t> m_nextWorker = 0;
+
+		bool m_stop = false;
+
+		bool tryPop(size_t workerIdx, std::function<void()>& task);
+
+		void workerLoop(size_t workerIdx);
+
+	public:
+
+		explicit ThreadPool(size_t threadCount = Max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+
+		ThreadPool(const ThreadPool&) = delete;
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool();
+
+		size_t threadCount() const
+		{
+			return m_threads.size();
+		}
+
+		/// <summary>
+		/// タスクを追加する
+		/// </summary>
+		void submit(std::function<void()> task);
+	};
+}
@@ -0,0 +1,156 @@
+#include"Trace.hpp"
+#include"Node.hpp"
+
+NodeEditor::Trace::Buffer& NodeEditor::Trace::ThreadBuffer()
+{
+	//スレッドごとに小さな番号を振る(trace eventのtid)
+	static std::atomic<uint32> s_threadCounter = 0;
+
+	static thread_local const std::shared_ptr<Buffer> t_buffer = []()
+	{
+		auto buffer = std::make_shared<Buffer>();
+		buffer->thread = s_threadCounter++;
+
+		std::lock_guard lock(s_mutex);
+		buffer->capacity = s_capacity;
+		s_buffers << buffer;
+		return buffer;
+	}();
+
+	return *t_buffer;
+}
+
+void NodeEditor::Trace::SetCapacity(size_t capacity)
+{
+	std::lock_guard lock(s_mutex);
+	s_capacity = Max<size_t>(capacity, 1);
+	for (const auto& buffer : s_buffers)
+	{
+		std::lock_guard bufferLock(buffer->mutex);
+		buffer->capacity = s_capacity;
+		buffer->events.clear();
+		buffer->count = 0;
+	}
+}
+
+void NodeEditor::Trace::Clear()
+{
+	std::lock_guard lock(s_mutex);
+
+	//一覧だけが持っているバッファは、スレッドが終了していて再び使われない
+	s_buffers.remove_if([](const std::shared_ptr<Buffer>& buffer) { return buffer.use_count() == 1; });
+
+	for (const auto& buffer : s_buffers)
+	{
+		std::lock_guard bufferLock(buffer->mutex);
+		buffer->events.clear();
+		buffer->count = 0;
+	}
+}
+
+void NodeEditor::Trace::Record(Category category, const Node& node, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+	auto& buffer = ThreadBuffer();
+
+	//他のスレッドが記録していても待たない(待つのはToJSONやClearと重なったときだけ)
+	std::lock_guard lock(buffer.mutex);
+
+	if (buffer.events.size() < buffer.capacity)
+	{
+		buffer.events.emplace_back();
+	}
+
+	//一周したら古いものから上書きする(文字列の領域は使い回されるので、名前が容量に収まればメモリを確保しない)
+	auto& event = buffer.events[buffer.count % buffer.capacity];
+	event.category = category;
+	event.id = node.ID;
+	event.className = node.Class;
+	event.name = node.Name;
+	event.begin = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(begin - s_origin).count());
+	event.duration = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+	buffer.count++;
+}
+
+String NodeEditor::Trace::ToJSON()
+{
+	std::lock_guard lock(s_mutex);
+
+	//書き出している間は全てのスレッドの記録を止める
+	Array<std::unique_lock<std::mutex>> bufferLocks;
+	Array<std::pair<const Event*, uint32>> events;
+	for (const auto& buffer : s_buffers)
+	{
+		bufferLocks.emplace_back(buffer->mutex);
+
+		//古いものから順に集める
+		const size_t first = buffer->count > buffer->events.size() ? buffer->count % buffer->capacity : 0;
+		for (size_t i = 0; i < buffer->events.size(); i++)
+		{
+			events.emplace_back(&buffer->events[(first + i) % buffer->events.size()], buffer->thread);
+		}
+	}
+	std::stable_sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.first->begin < b.first->begin; });
+
+	JSONWriter writer;
+
+	writer.startObject();
+	{
+		writer.key(U"displayTimeUnit").write(U"ns");
+
+		writer.key(U"traceEvents").startArray();
+		{
+			for (const auto& [entry, thread] : events)
+			{
+				const auto& event = *entry;
+
+				writer.startObject();
+				{
+					switch (event.category)
+					{
+					case Category::Node:
+						writer.key(U"cat").write(U"node");
+						writer.key(U"name").write(!event.name.isEmpty() ? event.name : event.className);
+						break;
+					case Category::Step:
+						writer.key(U"cat").write(U"step");
+						writer.key(U"name").write(U"step: " + (!event.name.isEmpty() ? event.name : event.className));
+						break;
+					case Category::Pass:
+						writer.key(U"cat").write(U"pass");
+						writer.key(U"name").write(U"pass");
+						break;
+					}
+					writer.key(U"ph").write(U"X");
+					writer.key(U"ts").write(event.begin / 1000.0);
+					writer.key(U"dur").write(event.duration / 1000.0);
+					writer.key(U"pid").write(1);
+					writer.key(U"tid").write(thread);
+
+					writer.key(U"args").startObject();
+					{
+						writer.key(U"id").write(event.id);
+						writer.key(U"class").write(event.className);
+						writer.key(U"name").write(event.name);
+					}
+					writer.endObject();
+				}
+				writer.endObject();
+			}
+		}
+		writer.endArray();
+	}
+	writer.endObject();
+
+	return writer.get();
+}
+
+bool NodeEditor::Trace::Save(const FilePath& path)
+{
+	TextWriter writer(path);
+	if (!writer)
+	{
+		return false;
+	}
+	writer.write(ToJSON());
+	return true;
+}
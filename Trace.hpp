@@ -0,0 +1,169 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<atomic>
+#include<chrono>
+#include<memory>
+#include<mutex>
+
+namespace NodeEditor
+{
+	class Node;
+
+	/// <summary>
+	/// 実行の記録(Chromeのtrace event形式で書き出せる)
+	/// </summary>
+	/// <remarks>
+	/// ノードの実行、実行ソケットで辿った1ステップ、1回のパスをそれぞれ区間として記録する。
+	/// 記録はスレッドごとのリングバッファに残り、容量を超えると古いものから上書きされる。
+	/// 記録するスレッドどうしはロックを取り合わない(待つのは書き出しや消去と重なったときだけ)。
+	/// 記録していないときの負担はフラグの確認のみ。
+	/// </remarks>
+	class Trace
+	{
+	public:
+
+		enum class Category : uint8
+		{
+			//ノードのchildRun(関数テーブルから呼び出す場合は関数)
+			Node,
+			//実行ソケットで辿ったノード1つ分(入力の生成元を含む)
+			Step,
+			//起点ノードからの1回の実行
+			Pass,
+		};
+
+		static constexpr size_t DefaultCapacity = 65536;
+
+	private:
+
+		struct Event
+		{
+			Category category;
+
+			size_t id;
+
+			String className;
+
+			String name;
+
+			//記録の開始からの時刻[ns]
+			uint64 begin;
+
+			uint64 duration;
+		};
+
+		//1つのスレッドの記録
+		struct Buffer
+		{
+			//記録するスレッド自身と、書き出しや消去をするスレッドの間のロック
+			std::mutex mutex;
+
+			Array<Event> events;
+
+			size_t capacity = DefaultCapacity;
+
+			//これまでに記録した数(capacityで割った余りが次に書き込む位置)
+			size_t count = 0;
+
+			//trace eventのtid
+			uint32 thread = 0;
+		};
+
+		static inline std::atomic<bool> s_enabled = false;
+
+		//s_buffersとs_capacityのロック
+		static inline std::mutex s_mutex;
+
+		//記録したことのあるスレッドのバッファ(スレッドが終わっても書き出せるよう共有して持つ)
+		static inline Array<std::shared_ptr<Buffer>> s_buffers;
+
+		static inline size_t s_capacity = DefaultCapacity;
+
+		static inline const std::chrono::steady_clock::time_point s_origin = std::chrono::steady_clock::now();
+
+		//呼び出したスレッドのバッファ(最初の呼び出しで作る)
+		static Buffer& ThreadBuffer();
+
+	public:
+
+		/// <summary>
+		/// 記録するかどうかを切り替える
+		/// </summary>
+		static void SetEnabled(bool enabled)
+		{
+			s_enabled.store(enabled, std::memory_order_relaxed);
+		}
+
+		static bool IsEnabled()
+		{
+			return s_enabled.load(std::memory_order_relaxed);
+		}
+
+		/// <summary>
+		/// スレッドごとのリングバッファの容量を設定する(記録は消去される)
+		/// </summary>
+		static void SetCapacity(size_t capacity);
+
+		/// <summary>
+		/// 記録を消去する(終了したスレッドのバッファは破棄する)
+		/// </summary>
+		static void Clear();
+
+		/// <summary>
+		/// 区間を1つ記録する
+		/// </summary>
+		static void Record(Category category, const Node& node, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+		/// <summary>
+		/// 記録をChromeのtrace event形式のJSONに変換する(chrome://tracingやPerfettoで読み込める)
+		/// </summary>
+		/// <remarks>
+		/// 全てのスレッドの記録を開始時刻の順に書き出す
+		/// </remarks>
+		static String ToJSON();
+
+		static bool Save(const FilePath& path);
+	};
+
+	namespace detail
+	{
+		//記録中ならスコープの開始から終了までを区間として記録する
+		class TraceScope
+		{
+		private:
+
+			const Trace::Category m_category;
+
+			const Node& m_node;
+
+			const bool m_active;
+
+			std::chrono::steady_clock::time_point m_begin;
+
+		public:
+
+			TraceScope(Trace::Category category, const Node& node)
+				:m_category(category),
+				m_node(node),
+				m_active(Trace::IsEnabled())
+			{
+				if (m_active)
+				{
+					m_begin = std::chrono::steady_clock::now();
+				}
+			}
+
+			TraceScope(const TraceScope&) = delete;
+
+			TraceScope& operator=(const TraceScope&) = delete;
+
+			~TraceScope()
+			{
+				if (m_active)
+				{
+					Trace::Record(m_category, m_node, m_begin, std::chrono::steady_clock::now());
+				}
+			}
+		};
+	}
+}
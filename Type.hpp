@@ -1,8 +1,10 @@
 #pragma once
 #include<Siv3D.hpp>
 #include<any>
+#include<mutex>
 #include<typeinfo>
 #include<typeindex>
+#include<unordered_map>
 
 /// <summary>
 /// type_infoをコピー可能にするラッパクラス
@@ -11,12 +13,30 @@ class Type
 {
 private:
 
-	const type_info* m_typeInfo;
+	const std::type_info* m_typeInfo;
+
+	uint32 m_id;
+
+	//型ごとに1から順に連番のIDを割り当てる
+	static uint32 RegisterId(const std::type_info& type)
+	{
+		static std::mutex mutex;
+		static std::unordered_map<std::type_index, uint32> ids;
+
+		std::lock_guard lock(mutex);
+		return ids.emplace(type, static_cast<uint32>(ids.size() + 1)).first->second;
+	}
 
 public:
 
-	Type(const type_info& type)
-		:m_typeInfo(&type)
+	/// <summary>
+	/// どの型にも割り当てられないID
+	/// </summary>
+	static constexpr uint32 InvalidId = 0;
+
+	Type(const std::type_info& type)
+		:m_typeInfo(&type),
+		m_id(RegisterId(type))
 	{
 
 	}
@@ -26,25 +46,41 @@ public:
 		return Unicode::FromUTF8(m_typeInfo->name());
 	}
 
-	const type_info& TypeInfo() const
+	const std::type_info& TypeInfo() const
 	{
 		return *m_typeInfo;
 	}
 
+	/// <summary>
+	/// 型ごとに割り当てられた連番のID
+	/// </summary>
+	uint32 id() const
+	{
+		return m_id;
+	}
+
 	bool operator==(const Type& other) const
 	{
-		return *m_typeInfo == *other.m_typeInfo;
+		return m_id == other.m_id;
 	}
 
 	bool operator!=(const Type& other) const
 	{
-		return *m_typeInfo != *other.m_typeInfo;
+		return m_id != other.m_id;
 	}
 
+	//IDの登録はロックを取るので、型ごとに1回だけ行う
 	template<class T>
 	static Type getType()
 	{
-		return Type(typeid(T));
+		static const Type type(typeid(T));
+		return type;
+	}
+
+	template<class T>
+	static uint32 getId()
+	{
+		return getType<T>().id();
 	}
 
 	static Type getType(const std::any& val)
@@ -0,0 +1,215 @@
+#pragma once
+#include<Siv3D.hpp>
+#include<cassert>
+#include<cstddef>
+#include<memory>
+#include<new>
+#include<type_traits>
+#include"Type.hpp"
+
+namespace NodeEditor
+{
+	/// <summary>
+	/// ソケットの値を保持する型消去されたコンテナ
+	/// </summary>
+	/// <remarks>
+	/// InlineSize以下の型はバッファ内に直接保持し、それより大きい型は共有の不変バッファ(shared_ptr&lt;const T&gt;)で保持する。
+	/// そのため大きな値(Imageなど)をコピーしても参照カウントが増えるだけで中身は複製されない。
+	/// 型の判定はType::getId&lt;T&gt;()の整数比較で行う。
+	/// </remarks>
+	class ValueSlot
+	{
+	public:
+
+		static constexpr size_t InlineSize = 32;
+
+	private:
+
+		struct Ops
+		{
+			uint32 typeId;
+			const std::type_info& typeInfo;
+			void (*copy)(void* dst, const void* src);
+			void (*move)(void* dst, void* src) noexcept;
+			void (*destroy)(void* storage) noexcept;
+		};
+
+		template<class T>
+		static constexpr bool IsInline = sizeof(T) <= InlineSize && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>;
+
+		template<class T>
+		using StorageType = std::conditional_t<IsInline<T>, T, std::shared_ptr<const T>>;
+
+		template<class T>
+		static const Ops* OpsOf()
+		{
+			using Storage = StorageType<T>;
+			static const Ops ops
+			{
+				Type::getId<T>(),
+				typeid(T),
+				[](void* dst, const void* src) { new(dst) Storage(*static_cast<const Storage*>(src)); },
+				[](void* dst, void* src) noexcept { new(dst) Storage(std::move(*static_cast<Storage*>(src))); },
+				[](void* storage) noexcept { static_cast<Storage*>(storage)->~Storage(); }
+			};
+			return &ops;
+		}
+
+		template<class T>
+		const T* pointer() const noexcept
+		{
+			if constexpr (IsInline<T>)
+			{
+				return std::launder(reinterpret_cast<const T*>(m_storage));
+			}
+			else
+			{
+				return std::launder(reinterpret_cast<const std::shared_ptr<const T>*>(m_storage))->get();
+			}
+		}
+
+		alignas(std::max_align_t) unsigned char m_storage[InlineSize];
+
+		const Ops* m_ops = nullptr;
+
+	public:
+
+		ValueSlot() = default;
+
+		template<class T, std::enable_if_t<!std::is_same_v<std::decay_t<T>, ValueSlot>>* = nullptr>
+		explicit ValueSlot(T&& value)
+		{
+			set(std::forward<T>(value));
+		}
+
+		ValueSlot(const ValueSlot& other)
+		{
+			if (other.m_ops)
+			{
+				other.m_ops->copy(m_storage, other.m_storage);
+				m_ops = other.m_ops;
+			}
+		}
+
+		ValueSlot(ValueSlot&& other) noexcept
+		{
+			if (other.m_ops)
+			{
+				other.m_ops->move(m_storage, other.m_storage);
+				m_ops = other.m_ops;
+				other.reset();
+			}
+		}
+
+		ValueSlot& operator=(const ValueSlot& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				if (other.m_ops)
+				{
+					other.m_ops->copy(m_storage, other.m_storage);
+					m_ops = other.m_ops;
+				}
+			}
+			return *this;
+		}
+
+		ValueSlot& operator=(ValueSlot&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				if (other.m_ops)
+				{
+					other.m_ops->move(m_storage, other.m_storage);
+					m_ops = other.m_ops;
+					other.reset();
+				}
+			}
+			return *this;
+		}
+
+		~ValueSlot()
+		{
+			reset();
+		}
+
+		/// <summary>
+		/// 値を設定する(同じ型でバッファ内に保持している場合は代入で済ませる)
+		/// </summary>
+		template<class T>
+		void set(T&& value)
+		{
+			using U = std::decay_t<T>;
+			if constexpr (IsInline<U> && std::is_copy_assignable_v<U>)
+			{
+				if (m_ops == OpsOf<U>())
+				{
+					*std::launder(reinterpret_cast<U*>(m_storage)) = std::forward<T>(value);
+					return;
+				}
+			}
+			reset();
+			if constexpr (IsInline<U>)
+			{
+				new(m_storage) U(std::forward<T>(value));
+			}
+			else
+			{
+				new(m_storage) std::shared_ptr<const U>(std::make_shared<const U>(std::forward<T>(value)));
+			}
+			m_ops = OpsOf<U>();
+		}
+
+		void reset() noexcept
+		{
+			if (m_ops)
+			{
+				m_ops->destroy(m_storage);
+				m_ops = nullptr;
+			}
+		}
+
+		bool hasValue() const noexcept
+		{
+			return m_ops != nullptr;
+		}
+
+		/// <summary>
+		/// 保持している値の型ID(値がなければType::InvalidId)
+		/// </summary>
+		uint32 typeId() const noexcept
+		{
+			return m_ops ? m_ops->typeId : Type::InvalidId;
+		}
+
+		Type type() const
+		{
+			return m_ops ? Type(m_ops->typeInfo) : Type::getType<void>();
+		}
+
+		/// <summary>
+		/// 型を確認せずに値を参照する(接続時に型が確認済みのソケット用)
+		/// </summary>
+		template<class T>
+		const T& get() const noexcept
+		{
+			assert(typeId() == Type::getId<T>());
+			return *pointer<T>();
+		}
+
+		/// <summary>
+		/// 型が一致する場合のみ値へのポインタを返す
+		/// </summary>
+		template<class T>
+		const T* tryGet() const noexcept
+		{
+			if (typeId() != Type::getId<T>())
+			{
+				return nullptr;
+			}
+			return pointer<T>();
+		}
+	};
+}